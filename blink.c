@@ -0,0 +1,322 @@
+/********************************************************************************
+* blink.c: Innehåller funktionsdefinitioner för asynkron blinkning av
+*          lysdioder samt led-arrayer via systemtimern.
+********************************************************************************/
+#include "blink.h"
+#include "timer.h"
+
+/********************************************************************************
+* blink_mode: Enumeration för olika typer av asynkron blinkning av led-arrayer.
+********************************************************************************/
+enum blink_mode
+{
+   BLINK_MODE_NONE,        /* Ingen pågående blinkning. */
+   BLINK_MODE_FORWARD,     /* Sekventiell blinkning framåt. */
+   BLINK_MODE_BACKWARD,    /* Sekventiell blinkning bakåt. */
+   BLINK_MODE_COLLECTIVELY /* Kollektiv (synkroniserad) blinkning. */
+};
+
+/********************************************************************************
+* blink_sequence: Strukt innehållande tillståndet för asynkron blinkning av
+*                 en led-array.
+********************************************************************************/
+struct blink_sequence
+{
+   const led_array_t* leds;  /* Pekare till arrayen som blinkas. */
+   size_t index;             /* Index för aktuell lysdiod vid sekventiell blinkning. */
+   uint16_t blink_speed_ms;  /* Blinkhastighet mätt i millisekunder. */
+   uint16_t counter_ms;      /* Förfluten tid sedan senaste steg i sekvensen. */
+   bool enabled;             /* Indikerar ifall lysdioderna är tända vid kollektiv blinkning. */
+   enum blink_mode mode;     /* Typ av blinkning som genomförs. */
+};
+
+/* Statiska funktioner: */
+static void blink_service(void);
+static void blink_sequence_step(void);
+static void led_array_blink_start(const led_array_t* self,
+                                  const uint16_t blink_speed_ms,
+                                  const enum blink_mode mode);
+static void led_array_blink_set(const led_array_t* self,
+                                const bool enable);
+
+/* Statiska variabler: */
+static led_t* volatile blink_list = 0; /* Första lysdioden i listan över blinkande lysdioder. */
+static volatile struct blink_sequence blink_sequence; /* Aktuell blinksekvens för led-array. */
+
+/********************************************************************************
+* led_blink_start: Startar asynkron blinkning av angiven lysdiod, som därefter
+*                  togglas en gång per angiven blinkhastighet tills blinkningen
+*                  avslutas via led_blink_stop. Ifall lysdioden redan blinkar
+*                  uppdateras blinkhastigheten. En blinkhastighet på 0 ms
+*                  avslutar blinkningen.
+*
+*                  - self          : Pekare till lysdioden som ska blinkas.
+*                  - blink_speed_ms: Blinkhastigheten mätt i millisekunder.
+********************************************************************************/
+void led_blink_start(led_t* self,
+                     const uint16_t blink_speed_ms)
+{
+   uint8_t sreg;
+
+   if (!blink_speed_ms)
+   {
+      led_blink_stop(self);
+      return;
+   }
+
+   atomic_begin(sreg);
+
+   if (!self->blink_speed_ms)
+   {
+      self->blink_next = blink_list;
+      blink_list = self;
+   }
+
+   self->blink_speed_ms = blink_speed_ms;
+   self->blink_counter_ms = 0;
+   atomic_end(sreg);
+   timer_add_callback(blink_service);
+   return;
+}
+
+/********************************************************************************
+* led_blink_stop: Avslutar eventuell asynkron blinkning av angiven lysdiod,
+*                 som därefter släcks.
+*
+*                 - self: Pekare till lysdioden vars blinkning ska avslutas.
+********************************************************************************/
+void led_blink_stop(led_t* self)
+{
+   led_t* volatile* i;
+   uint8_t sreg;
+
+   if (!self->blink_speed_ms) return;
+
+   atomic_begin(sreg);
+
+   for (i = &blink_list; *i; i = &(*i)->blink_next)
+   {
+      if (*i == self)
+      {
+         *i = self->blink_next;
+         break;
+      }
+   }
+
+   self->blink_speed_ms = 0;
+   self->blink_counter_ms = 0;
+   self->blink_next = 0;
+
+   if (!blink_list && blink_sequence.mode == BLINK_MODE_NONE)
+   {
+      timer_remove_callback(blink_service);
+   }
+
+   atomic_end(sreg);
+   self->vptr->off(self);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_forward_start: Startar asynkron sekventiell blinkning framåt
+*                                av samtliga lysdioder lagrade i angiven array.
+*
+*                                - self          : Pekare till arrayen vars
+*                                                  lysdioder ska blinkas.
+*                                - blink_speed_ms: Lysdiodernas blinkhastighet
+*                                                  mätt i millisekunder.
+********************************************************************************/
+void led_array_blink_forward_start(const led_array_t* self,
+                                   const uint16_t blink_speed_ms)
+{
+   led_array_blink_start(self, blink_speed_ms, BLINK_MODE_FORWARD);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_backward_start: Startar asynkron sekventiell blinkning bakåt
+*                                 av samtliga lysdioder lagrade i angiven array.
+*
+*                                 - self          : Pekare till arrayen vars
+*                                                   lysdioder ska blinkas.
+*                                 - blink_speed_ms: Lysdiodernas blinkhastighet
+*                                                   mätt i millisekunder.
+********************************************************************************/
+void led_array_blink_backward_start(const led_array_t* self,
+                                    const uint16_t blink_speed_ms)
+{
+   led_array_blink_start(self, blink_speed_ms, BLINK_MODE_BACKWARD);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_collectively_start: Startar asynkron kollektiv
+*                                     (synkroniserad) blinkning av samtliga
+*                                     lysdioder lagrade i angiven array.
+*
+*                                     - self          : Pekare till arrayen
+*                                                       vars lysdioder ska
+*                                                       blinkas.
+*                                     - blink_speed_ms: Lysdiodernas
+*                                                       blinkhastighet mätt
+*                                                       i millisekunder.
+********************************************************************************/
+void led_array_blink_collectively_start(const led_array_t* self,
+                                        const uint16_t blink_speed_ms)
+{
+   led_array_blink_start(self, blink_speed_ms, BLINK_MODE_COLLECTIVELY);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_stop: Avslutar eventuell pågående asynkron blinkning av en
+*                       led-array, varefter arrayens lysdioder släcks.
+********************************************************************************/
+void led_array_blink_stop(void)
+{
+   const led_array_t* leds;
+   uint8_t sreg;
+
+   atomic_begin(sreg);
+   leds = blink_sequence.leds;
+   blink_sequence.mode = BLINK_MODE_NONE;
+   blink_sequence.leds = 0;
+
+   if (!blink_list)
+   {
+      timer_remove_callback(blink_service);
+   }
+
+   atomic_end(sreg);
+   if (leds) led_array_blink_set(leds, false);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_start: Startar asynkron blinkning av angiven led-array av
+*                        angiven typ. Eventuell pågående blinkning avslutas
+*                        först. Första steget i sekvensen genomförs direkt.
+*
+*                        - self          : Pekare till arrayen vars lysdioder
+*                                          ska blinkas.
+*                        - blink_speed_ms: Lysdiodernas blinkhastighet mätt
+*                                          i millisekunder.
+*                        - mode          : Typ av blinkning som ska genomföras.
+********************************************************************************/
+static void led_array_blink_start(const led_array_t* self,
+                                  const uint16_t blink_speed_ms,
+                                  const enum blink_mode mode)
+{
+   uint8_t sreg;
+   led_array_blink_stop();
+   if (!self->size || !blink_speed_ms) return;
+
+   atomic_begin(sreg);
+   blink_sequence.leds = self;
+   blink_sequence.index = mode == BLINK_MODE_BACKWARD ? self->size - 1 : 0;
+   blink_sequence.blink_speed_ms = blink_speed_ms;
+   blink_sequence.counter_ms = 0;
+   blink_sequence.enabled = true;
+   blink_sequence.mode = mode;
+
+   if (mode == BLINK_MODE_COLLECTIVELY)
+   {
+      led_array_blink_set(self, true);
+   }
+   else
+   {
+      led_t* led = self->leds[blink_sequence.index];
+      led->vptr->on(led);
+   }
+
+   atomic_end(sreg);
+   timer_add_callback(blink_service);
+   return;
+}
+
+/********************************************************************************
+* led_array_blink_set: Tänder eller släcker samtliga lysdioder i angiven array.
+*
+*                      - self  : Pekare till arrayen vars lysdioder ska sättas.
+*                      - enable: Indikerar ifall lysdioderna ska tändas.
+********************************************************************************/
+static void led_array_blink_set(const led_array_t* self,
+                                const bool enable)
+{
+   led_t** i;
+
+   for (i = self->leds; i < self->leds + self->size; ++i)
+   {
+      if (enable) (*i)->vptr->on(*i);
+      else (*i)->vptr->off(*i);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* blink_sequence_step: Genomför nästa steg i aktuell blinksekvens. Vid
+*                      sekventiell blinkning släcks aktuell lysdiod och nästa
+*                      lysdiod i sekvensen tänds. Vid kollektiv blinkning
+*                      togglas samtliga lysdioder.
+********************************************************************************/
+static void blink_sequence_step(void)
+{
+   const led_array_t* self = blink_sequence.leds;
+   size_t index = blink_sequence.index;
+
+   if (blink_sequence.mode == BLINK_MODE_COLLECTIVELY)
+   {
+      blink_sequence.enabled = !blink_sequence.enabled;
+      led_array_blink_set(self, blink_sequence.enabled);
+      return;
+   }
+
+   if (index < self->size)
+   {
+      self->leds[index]->vptr->off(self->leds[index]);
+   }
+
+   if (blink_sequence.mode == BLINK_MODE_FORWARD)
+   {
+      index = index + 1 < self->size ? index + 1 : 0;
+   }
+   else
+   {
+      index = index > 0 && index <= self->size ? index - 1 : self->size - 1;
+   }
+
+   if (index >= self->size) return;
+   self->leds[index]->vptr->on(self->leds[index]);
+   blink_sequence.index = index;
+   return;
+}
+
+/********************************************************************************
+* blink_service: Callbackrutin som anropas av systemtimern en gång per
+*                millisekund. Varje blinkande lysdiod vars blinkhastighet har
+*                förflutit togglas, varefter eventuell blinksekvens för
+*                led-array stegas fram.
+********************************************************************************/
+static void blink_service(void)
+{
+   led_t* i;
+
+   for (i = blink_list; i; i = i->blink_next)
+   {
+      if (++i->blink_counter_ms >= i->blink_speed_ms)
+      {
+         i->blink_counter_ms = 0;
+         i->vptr->toggle(i);
+      }
+   }
+
+   if (blink_sequence.mode != BLINK_MODE_NONE &&
+       ++blink_sequence.counter_ms >= blink_sequence.blink_speed_ms)
+   {
+      blink_sequence.counter_ms = 0;
+      blink_sequence_step();
+   }
+
+   return;
+}
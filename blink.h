@@ -0,0 +1,91 @@
+/********************************************************************************
+* blink.h: Innehåller funktionalitet för asynkron blinkning av lysdioder samt
+*          led-arrayer. Blinkningen drivs av systemtimerns avbrott, vilket
+*          medför att anropande kod inte blockeras under blinkningen, till
+*          skillnad från blinkfunktionerna i led.h samt led_array.h.
+********************************************************************************/
+#ifndef BLINK_H_
+#define BLINK_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led.h"
+#include "led_array.h"
+
+/********************************************************************************
+* led_blink_start: Startar asynkron blinkning av angiven lysdiod, som därefter
+*                  togglas en gång per angiven blinkhastighet tills blinkningen
+*                  avslutas via led_blink_stop. Ifall lysdioden redan blinkar
+*                  uppdateras blinkhastigheten. En blinkhastighet på 0 ms
+*                  avslutar blinkningen.
+*
+*                  - self          : Pekare till lysdioden som ska blinkas.
+*                  - blink_speed_ms: Blinkhastigheten mätt i millisekunder.
+********************************************************************************/
+void led_blink_start(led_t* self,
+                     const uint16_t blink_speed_ms);
+
+/********************************************************************************
+* led_blink_stop: Avslutar eventuell asynkron blinkning av angiven lysdiod,
+*                 som därefter släcks.
+*
+*                 - self: Pekare till lysdioden vars blinkning ska avslutas.
+********************************************************************************/
+void led_blink_stop(led_t* self);
+
+/********************************************************************************
+* led_array_blink_forward_start: Startar asynkron sekventiell blinkning framåt
+*                                av samtliga lysdioder lagrade i angiven array.
+*                                Sekvensen upprepas tills den avslutas via
+*                                led_array_blink_stop. Endast en array kan
+*                                blinkas åt gången, eventuell pågående sekvens
+*                                avslutas därmed. Lysdioder får läggas till
+*                                i arrayen, men inte tas bort, medan
+*                                blinkningen pågår.
+*
+*                                - self          : Pekare till arrayen vars
+*                                                  lysdioder ska blinkas.
+*                                - blink_speed_ms: Lysdiodernas blinkhastighet
+*                                                  mätt i millisekunder.
+********************************************************************************/
+void led_array_blink_forward_start(const led_array_t* self,
+                                   const uint16_t blink_speed_ms);
+
+/********************************************************************************
+* led_array_blink_backward_start: Startar asynkron sekventiell blinkning bakåt
+*                                 av samtliga lysdioder lagrade i angiven
+*                                 array. I övrigt gäller samma villkor som för
+*                                 led_array_blink_forward_start.
+*
+*                                 - self          : Pekare till arrayen vars
+*                                                   lysdioder ska blinkas.
+*                                 - blink_speed_ms: Lysdiodernas blinkhastighet
+*                                                   mätt i millisekunder.
+********************************************************************************/
+void led_array_blink_backward_start(const led_array_t* self,
+                                    const uint16_t blink_speed_ms);
+
+/********************************************************************************
+* led_array_blink_collectively_start: Startar asynkron kollektiv
+*                                     (synkroniserad) blinkning av samtliga
+*                                     lysdioder lagrade i angiven array.
+*                                     I övrigt gäller samma villkor som för
+*                                     led_array_blink_forward_start.
+*
+*                                     - self          : Pekare till arrayen
+*                                                       vars lysdioder ska
+*                                                       blinkas.
+*                                     - blink_speed_ms: Lysdiodernas
+*                                                       blinkhastighet mätt
+*                                                       i millisekunder.
+********************************************************************************/
+void led_array_blink_collectively_start(const led_array_t* self,
+                                        const uint16_t blink_speed_ms);
+
+/********************************************************************************
+* led_array_blink_stop: Avslutar eventuell pågående asynkron blinkning av en
+*                       led-array, varefter arrayens lysdioder släcks.
+********************************************************************************/
+void led_array_blink_stop(void);
+
+#endif /* BLINK_H_ */
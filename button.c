@@ -1,246 +1,390 @@
-/********************************************************************************
-* button.h: Innehller funktionsdefinitioner fr enkel implementering av 
-*           tryckknappar samt andra digitala inportar via strukten button.
-********************************************************************************/
-#include "button.h"
-
-/* Statiska funktioner: */
-static bool button_is_pressed(const button_t* self);
-static void button_enable_interrupt(button_t* self);
-static void button_disable_interrupt(button_t* self);
-static void button_toggle_interrupt(button_t* self);
-static button_vptr_t button_vptr_new(void);
-
-/********************************************************************************
-* button_init: Initierar ny tryckknapp p angiven pin.
-*
-*              - self: Pekare till tryckknappen som ska initieras.
-*              - pin : Tryckknappens pin-nummer p Arduino Uno, exempelvis 13.
-*                      Alternativt kan motsvarande port-nummer p ATmega328P
-*                      anges, exempelvis B5 fr pin 13 eller D3 fr pin 3.
-********************************************************************************/
-void button_init(button_t* self,
-                 const uint8_t pin)
-{
-   if (pin >= 0 && pin <= 7)
-   {
-      self->io_port = IO_PORTD;
-      self->pin = pin;
-      set(PORTD, self->pin);
-   }
-   else if (pin >= 8 && pin <= 13)
-   {
-      self->io_port = IO_PORTB;
-      self->pin = pin - 8;
-      set(PORTB, self->pin);
-   }
-   else if (pin >= 14 && pin <= 19)
-   {
-      self->io_port = IO_PORTC;
-      self->pin = pin - 14;
-      set(PORTC, self->pin);
-   }
-   else
-   {
-      self->io_port = IO_PORT_NONE;
-      self->pin = 0;
-   }
-
-   self->interrupt_enabled = false;
-   self->vptr = button_vptr_new();
-   return;
-}
-
-/********************************************************************************
-* button_clear: Nollstller tryckknapp samt motsvarande pin.
-*
-*               - self: Pekare till tryckknappen som ska nollstllas.
-********************************************************************************/
-void button_clear(button_t* self)
-{
-   button_disable_interrupt(self);
-
-   if (self->io_port == IO_PORTB)
-   {
-      clr(PORTB, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      clr(PORTC, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      clr(PORTD, self->pin);
-   }
-
-   self->io_port = IO_PORT_NONE;
-   self->pin = 0;
-   return;
-}
-
-/********************************************************************************
-* button_new: Allokerar minne och initierar en ny tryckknapp p angiven pin.
-*             En pekare returneras till tryckknappen efter initieringen.
-*             Vid misslyckad minnesallokering returneras en nullpekare.
-*
-*             - pin : Tryckknappens pin-nummer p Arduino Uno, exempelvis 8.
-*                     Alternativt kan motsvarande port-nummer p ATmega328P
-*                     anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-button_t* button_new(const uint8_t pin)
-{
-   button_t* self = (button_t*)malloc(sizeof(button_t));
-   if (!self) return 0;
-   button_init(self, pin);
-   return self;
-}
-
-/********************************************************************************
-* button_delete: Frigr minne allokerat fr angiven tryckknapp och stter
-*                motsvarande pekare till null. Fr att kunna genomfra detta
-*                passeras adressen till den pekare som pekar p tryckknappen.
-*
-*                - self: Adressen till den pekare som pekar p tryckknappen.
-********************************************************************************/
-void button_delete(button_t** self)
-{
-   button_clear(*self);
-   free(*self);
-   *self = 0;
-   return;
-}
-
-/********************************************************************************
-* button_is_pressed: Lser av tryckknappens pin och indikerar ifall denna r
-*                    nedtryckt. I s fall returneras true, annars false.
-*
-*                    - self: Pekare till tryckknappen som ska lsas av.
-********************************************************************************/
-static bool button_is_pressed(const button_t* self)
-{
-   if (self->io_port == IO_PORTB)
-   {
-      return read(PINB, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      return read(PINC, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      return read(PIND, self->pin);
-   }
-   else
-   {
-      return false;
-   }
-}
-
-/********************************************************************************
-* button_enable_interrupt: Aktiverar PCI-avbrott p angiven tryckknapp s att
-*                          event p tryckknappens pin medfr avbrott, bde p
-*                          stigande och fallande flank. Kontroll av flank mste
-*                          sktas av anvndaren, frslagsvis via avlsning i
-*                          motsvarande avbrottsrutin.
-*
-*                          Nedan visas sambandet mellan anvnd I/O-port samt
-*                          avbrottsvektorn fr motsvarande avbrottsrutin:
-*
-*                          I/O-port     pin (Arduino Uno)     Avbrottsvektor
-*                             B              8 - 13             PCINT0_vect
-*                             C             A0 - A5             PCINT1_vect
-*                             D              0 - 7              PCINT2_vect
-*
-*                          - self: Pekare till tryckknappen som PCI-avbrott
-*                                  ska aktiveras p.
-********************************************************************************/
-static void button_enable_interrupt(button_t* self)
-{
-   sei();
-
-   if (self->io_port == IO_PORTB)
-   {
-      set(PCICR, PCIE0);
-      set(PCMSK0, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      set(PCICR, PCIE1);
-      set(PCMSK1, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      set(PCICR, PCIE2);
-      set(PCMSK2, self->pin);
-   }
-
-   self->interrupt_enabled = true;
-   return;
-}
-
-/********************************************************************************
-* button_disable_interrupt: Inaktiverar PCI-avbrott p angiven tryckknapp.
-*
-*                           - self: Pekare till tryckknappen som PCI-avbrott
-*                                  ska inaktiveras p.
-********************************************************************************/
-static void button_disable_interrupt(button_t* self)
-{
-   if (self->io_port == IO_PORTB)
-   {
-      clr(PCMSK0, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      clr(PCMSK1, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      clr(PCMSK2, self->pin);
-   }
-
-   self->interrupt_enabled = false;
-   return;
-}
-
-/********************************************************************************
-* button_toggle_interrupt: Togglar aktivering av PCI-avbrott p angiven
-*                          tryckknapp. Om avbrott r aktiverat vid anrop
-*                          s sker inaktivering. P samma stt gller att om
-*                          avbrott r inaktiverat vid anrop s sker aktivering.
-*
-*                          - self: Pekare till tryckknappen som aktivering av
-*                                  PCI-avbrott ska inaktiveras p.
-********************************************************************************/
-static void button_toggle_interrupt(button_t* self)
-{
-   if (self->interrupt_enabled)
-   {
-      button_disable_interrupt(self);
-   }
-   else
-   {
-      button_enable_interrupt(self);
-   }
-
-   return;
-}
-
-/********************************************************************************
-* button_vptr_new: Returnerar en pekare till ett vtable innehllande pekare till
-*                  associerade funktioner fr strukten led. Nr programmet
-*                  startar stts respektive pekare till att peka p motsvarande
-*                  funktion.
-********************************************************************************/
-static button_vptr_t button_vptr_new(void)
-{
-   static struct button_vtable self = 
-   {
-      .is_pressed = button_is_pressed,
-      .enable_interrupt = button_enable_interrupt,
-      .disable_interrupt = button_disable_interrupt,
-      .toggle_interrupt = button_toggle_interrupt
-   };
-
-   return &self;
+/********************************************************************************
+* button.h: Innehåller funktionsdefinitioner för enkel implementering av 
+*           tryckknappar samt andra digitala inportar via strukten button.
+********************************************************************************/
+#include "button.h"
+#include "memstat.h"
+#include "trace.h"
+#include "debounce.h"
+
+/* Statiska funktioner: */
+static bool button_is_pressed(const button_t* self);
+static void button_enable_interrupt(button_t* self);
+static void button_disable_interrupt(button_t* self);
+static void button_toggle_interrupt(button_t* self);
+static void button_set_callback(button_t* self,
+                                const button_callback_t callback);
+static void button_dispatch(const enum io_port io_port,
+                            const uint8_t pins,
+                            const uint8_t enabled_pins);
+static uint8_t button_bit_index(const uint8_t bit);
+static button_vptr_t button_vptr_new(void);
+
+/* Statiska variabler: */
+#if BUTTON_POOL_SIZE > 0
+static button_t button_pool_storage[BUTTON_POOL_SIZE]; /* Minne för objektpoolen. */
+static pool_t button_pool = POOL_INIT(button_pool_storage); /* Objektpool för button_new. */
+#endif
+static button_t* volatile button_handlers[IO_PORT_NONE][8]; /* Tryckknappar med PCI-avbrott per pin. */
+static volatile uint8_t button_pin_state[IO_PORT_NONE]; /* Pinregistrens innehåll vid föregående avbrott. */
+
+/********************************************************************************
+* button_init: Initierar ny tryckknapp på angiven pin.
+*
+*              - self: Pekare till tryckknappen som ska initieras.
+*              - pin : Tryckknappens pin-nummer på Arduino Uno, exempelvis 13.
+*                      Alternativt kan motsvarande port-nummer på ATmega328P
+*                      anges, exempelvis B5 för pin 13 eller D3 för pin 3.
+********************************************************************************/
+void (button_init)(button_t* self,
+                   const uint8_t pin)
+{
+   gpio_t gpio;
+   if (gpio_load(&gpio, pin)) *gpio.port |= gpio.mask;
+
+   self->io_port = gpio.io_port;
+   self->pin = gpio.pin;
+   self->mask = gpio.mask;
+   self->interrupt_enabled = false;
+   self->callback = 0;
+   self->vptr = button_vptr_new();
+   return;
+}
+
+/********************************************************************************
+* button_clear: Nollställer tryckknapp samt motsvarande pin.
+*
+*               - self: Pekare till tryckknappen som ska nollställas.
+********************************************************************************/
+void button_clear(button_t* self)
+{
+   button_disable_interrupt(self);
+
+   if (self->io_port == IO_PORTB)
+   {
+      clr(PORTB, self->pin);
+   }
+   else if (self->io_port == IO_PORTC)
+   {
+      clr(PORTC, self->pin);
+   }
+   else if (self->io_port == IO_PORTD)
+   {
+      clr(PORTD, self->pin);
+   }
+
+   self->io_port = IO_PORT_NONE;
+   self->pin = 0;
+   self->mask = 0;
+   return;
+}
+
+/********************************************************************************
+* button_new: Allokerar minne och initierar en ny tryckknapp på angiven pin.
+*             En pekare returneras till tryckknappen efter initieringen.
+*             Vid misslyckad minnesallokering returneras en nullpekare.
+*             Minnet allokeras från en statisk objektpool med kapacitet
+*             BUTTON_POOL_SIZE, alternativt via malloc om kapaciteten är 0.
+*
+*             - pin : Tryckknappens pin-nummer på Arduino Uno, exempelvis 8.
+*                     Alternativt kan motsvarande port-nummer på ATmega328P
+*                     anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+********************************************************************************/
+button_t* (button_new)(const uint8_t pin)
+{
+#if BUTTON_POOL_SIZE > 0
+   button_t* self = (button_t*)pool_alloc(&button_pool);
+#else
+   button_t* self = (button_t*)memstat_malloc(sizeof(button_t));
+#endif
+   if (!self) return 0;
+   button_init(self, pin);
+   memstat_object_add(MEMSTAT_BUTTON);
+   return self;
+}
+
+/********************************************************************************
+* button_delete: Frigör minne allokerat för angiven tryckknapp och sätter
+*                motsvarande pekare till null. För att kunna genomföra detta
+*                passeras adressen till den pekare som pekar på tryckknappen.
+*
+*                - self: Adressen till den pekare som pekar på tryckknappen.
+********************************************************************************/
+void button_delete(button_t** self)
+{
+   button_clear(*self);
+   memstat_object_remove(MEMSTAT_BUTTON);
+#if BUTTON_POOL_SIZE > 0
+   pool_free(&button_pool, *self);
+#else
+   memstat_free(*self);
+#endif
+   *self = 0;
+   return;
+}
+
+/********************************************************************************
+* button_pool_stats: Kopierar användningsstatistik för objektpoolen som
+*                   används av button_new samt button_delete.
+*
+*                   - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void button_pool_stats(pool_stats_t* stats)
+{
+#if BUTTON_POOL_SIZE > 0
+   pool_get_stats(&button_pool, stats);
+#else
+   stats->capacity = 0;
+   stats->used = 0;
+   stats->high_water_mark = 0;
+   stats->failed = 0;
+#endif
+   return;
+}
+
+/********************************************************************************
+* button_is_pressed: Läser av tryckknappens pin och indikerar ifall denna är
+*                    nedtryckt. I så fall returneras true, annars false.
+*                    Ifall avstudsning har startats via debounce_init
+*                    returneras avstudsat värde, vilket läses av i konstant
+*                    tid utan avläsning av hårdvaran.
+*
+*                    - self: Pekare till tryckknappen som ska läsas av.
+********************************************************************************/
+static bool button_is_pressed(const button_t* self)
+{
+   bool pressed;
+   trace_enter(TRACE_BUTTON_IS_PRESSED);
+   pressed = (debounce_read(self->io_port) & self->mask) ? true : false;
+   trace_exit(TRACE_BUTTON_IS_PRESSED);
+   return pressed;
+}
+
+/********************************************************************************
+* button_enable_interrupt: Aktiverar PCI-avbrott på angiven tryckknapp så att
+*                          event på tryckknappens pin medför avbrott, både på
+*                          stigande och fallande flank. Tryckknappen registreras
+*                          för sin pin, så att avbrottsrutinen kan anropa dess
+*                          callbackrutin med detekterad flank. Aktuell
+*                          insignal lagras som utgångsläge för detekteringen.
+*
+*                          Nedan visas sambandet mellan använd I/O-port samt
+*                          avbrottsvektorn för motsvarande avbrottsrutin:
+*
+*                          I/O-port     pin (Arduino Uno)     Avbrottsvektor
+*                             B              8 - 13             PCINT0_vect
+*                             C             A0 - A5             PCINT1_vect
+*                             D              0 - 7              PCINT2_vect
+*
+*                          - self: Pekare till tryckknappen som PCI-avbrott
+*                                  ska aktiveras på.
+********************************************************************************/
+static void button_enable_interrupt(button_t* self)
+{
+   uint8_t sreg;
+   sei();
+
+   if (self->io_port == IO_PORT_NONE)
+   {
+      self->interrupt_enabled = true;
+      return;
+   }
+
+   atomic_begin(sreg);
+   button_handlers[self->io_port][self->pin] = self;
+
+   if (self->io_port == IO_PORTB)
+   {
+      button_pin_state[IO_PORTB] = (button_pin_state[IO_PORTB] & ~self->mask) | (PINB & self->mask);
+      set(PCICR, PCIE0);
+      set(PCMSK0, self->pin);
+   }
+   else if (self->io_port == IO_PORTC)
+   {
+      button_pin_state[IO_PORTC] = (button_pin_state[IO_PORTC] & ~self->mask) | (PINC & self->mask);
+      set(PCICR, PCIE1);
+      set(PCMSK1, self->pin);
+   }
+   else if (self->io_port == IO_PORTD)
+   {
+      button_pin_state[IO_PORTD] = (button_pin_state[IO_PORTD] & ~self->mask) | (PIND & self->mask);
+      set(PCICR, PCIE2);
+      set(PCMSK2, self->pin);
+   }
+
+   atomic_end(sreg);
+
+   self->interrupt_enabled = true;
+   return;
+}
+
+/********************************************************************************
+* button_disable_interrupt: Inaktiverar PCI-avbrott på angiven tryckknapp.
+*
+*                           - self: Pekare till tryckknappen som PCI-avbrott
+*                                  ska inaktiveras på.
+********************************************************************************/
+static void button_disable_interrupt(button_t* self)
+{
+   if (self->io_port == IO_PORTB)
+   {
+      clr(PCMSK0, self->pin);
+   }
+   else if (self->io_port == IO_PORTC)
+   {
+      clr(PCMSK1, self->pin);
+   }
+   else if (self->io_port == IO_PORTD)
+   {
+      clr(PCMSK2, self->pin);
+   }
+
+   if (self->io_port != IO_PORT_NONE && button_handlers[self->io_port][self->pin] == self)
+   {
+      button_handlers[self->io_port][self->pin] = 0;
+   }
+
+   self->interrupt_enabled = false;
+   return;
+}
+
+/********************************************************************************
+* button_toggle_interrupt: Togglar aktivering av PCI-avbrott på angiven
+*                          tryckknapp. Om avbrott är aktiverat vid anrop
+*                          så sker inaktivering. På samma sätt gäller att om
+*                          avbrott är inaktiverat vid anrop så sker aktivering.
+*
+*                          - self: Pekare till tryckknappen som aktivering av
+*                                  PCI-avbrott ska inaktiveras på.
+********************************************************************************/
+static void button_toggle_interrupt(button_t* self)
+{
+   if (self->interrupt_enabled)
+   {
+      button_disable_interrupt(self);
+   }
+   else
+   {
+      button_enable_interrupt(self);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* button_set_callback: Registrerar callbackrutin som anropas med detekterad
+*                      flank vid event på tryckknappens pin, förutsatt att
+*                      PCI-avbrott är aktiverat. En nullpekare avregistrerar
+*                      callbackrutinen.
+*
+*                      - self    : Pekare till tryckknappen.
+*                      - callback: Callbackrutinen som ska registreras.
+********************************************************************************/
+static void button_set_callback(button_t* self,
+                                const button_callback_t callback)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   self->callback = callback;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* button_bit_index: Returnerar index för angiven bit, där exakt en bit
+*                   förväntas vara ettställd. Indexet beräknas via tre
+*                   maskningar i stället för en loop.
+*
+*                   - bit: Bitmask innehållande en ettställd bit.
+********************************************************************************/
+static uint8_t button_bit_index(const uint8_t bit)
+{
+   uint8_t index = 0;
+   if (bit & 0xF0) index += 4;
+   if (bit & 0xCC) index += 2;
+   if (bit & 0xAA) index += 1;
+   return index;
+}
+
+/********************************************************************************
+* button_dispatch: Jämför pinregistrets innehåll med föregående avläsning och
+*                  anropar callbackrutinen för varje tryckknapp vars insignal
+*                  har ändrats. Endast ändrade bitar behandlas, en i taget
+*                  från minst signifikant bit, vilket medför att kostnaden
+*                  är proportionell mot antalet ändrade pinnar.
+*
+*                  - io_port     : I/O-porten som avbrottet gäller.
+*                  - pins        : Pinregistrets aktuella innehåll.
+*                  - enabled_pins: Pinnar med aktiverat PCI-avbrott (PCMSKx).
+********************************************************************************/
+static void button_dispatch(const enum io_port io_port,
+                            const uint8_t pins,
+                            const uint8_t enabled_pins)
+{
+   uint8_t changed = (pins ^ button_pin_state[io_port]) & enabled_pins;
+   button_pin_state[io_port] = pins;
+
+   while (changed)
+   {
+      const uint8_t bit = changed & (uint8_t)(~changed + 1);
+      button_t* button = button_handlers[io_port][button_bit_index(bit)];
+      changed &= ~bit;
+
+      if (button && button->callback)
+      {
+         button->callback(button, (pins & bit) ? BUTTON_EVENT_RISING_EDGE : BUTTON_EVENT_FALLING_EDGE);
+      }
+   }
+
+   return;
+}
+
+/********************************************************************************
+* ISR (PCINT0_vect): Avbrottsrutin för PCI-avbrott på I/O-port B.
+********************************************************************************/
+ISR (PCINT0_vect)
+{
+   trace_enter(TRACE_ISR_PCINT0);
+   button_dispatch(IO_PORTB, PINB, PCMSK0);
+   trace_exit(TRACE_ISR_PCINT0);
+}
+
+/********************************************************************************
+* ISR (PCINT1_vect): Avbrottsrutin för PCI-avbrott på I/O-port C.
+********************************************************************************/
+ISR (PCINT1_vect)
+{
+   trace_enter(TRACE_ISR_PCINT1);
+   button_dispatch(IO_PORTC, PINC, PCMSK1);
+   trace_exit(TRACE_ISR_PCINT1);
+}
+
+/********************************************************************************
+* ISR (PCINT2_vect): Avbrottsrutin för PCI-avbrott på I/O-port D.
+********************************************************************************/
+ISR (PCINT2_vect)
+{
+   trace_enter(TRACE_ISR_PCINT2);
+   button_dispatch(IO_PORTD, PIND, PCMSK2);
+   trace_exit(TRACE_ISR_PCINT2);
+}
+
+/********************************************************************************
+* button_vptr_new: Returnerar en pekare till ett vtable innehållande pekare till
+*                  associerade funktioner för strukten led. När programmet
+*                  startar sätts respektive pekare till att peka på motsvarande
+*                  funktion.
+********************************************************************************/
+static button_vptr_t button_vptr_new(void)
+{
+   static struct button_vtable self = 
+   {
+      .is_pressed = button_is_pressed,
+      .enable_interrupt = button_enable_interrupt,
+      .disable_interrupt = button_disable_interrupt,
+      .toggle_interrupt = button_toggle_interrupt,
+      .set_callback = button_set_callback
+   };
+
+   return &self;
 }
\ No newline at end of file
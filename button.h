@@ -1,122 +1,209 @@
-/********************************************************************************
-* button.h: Innehller funktionalitet fr enkel implementering av tryckknappar
-*           via strukten button samt associerade funktioner, som ns via en 
-*           vtable-pekare. Denna strukt fungerar ocks utmrkt fr andra 
-*           digitala inportar dr insignalen ska kunna lsas av samt avbrott 
-*           ska kunna genereras vid ett godtyckligt event.
-********************************************************************************/
-#ifndef BUTTON_H_
-#define BUTTON_H_
-
-/* Inkluderingsdirektiv: */
-#include "misc.h"
-
-struct button_vtable; /* Frdeklarerar infr deklaration av strukten button. */
-
-/********************************************************************************
-* button: Strukt fr implementering av tryckknappar och andra digitala inportar.
-*         PCI-avbrott kan aktiveras p aktuell pin. Drmed fr eventdetektering 
-*         implementeras av anvndaren, d PCI-avbrott inte mjliggr kontroll
-*         av vilken flank som avbrott ska ske p.
-********************************************************************************/
-typedef struct button
-{
-   uint8_t pin;                /* Tryckknappens pin-nummer p aktuell I/O-port. */
-   enum io_port io_port;       /* I/O-port som lysdioden r ansluten till. */
-   bool interrupt_enabled;     /* Indikerar ifall PCI-avbrott r aktiverat. */
-   struct button_vtable* vptr; /* Pekare till vtable innehllande associerade funktioner. */
-} button_t, *button_ptr_t;
-
-/********************************************************************************
-* button_vtable: Strukt fr vtable innehllande funktionspekare till associerade
-*                funktioner fr strukten button.
-********************************************************************************/
-typedef struct button_vtable
-{
-   /********************************************************************************
-   * is_pressed: Lser av tryckknappens pin och indikerar ifall denna r nedtryckt.
-   *             I s fall returneras true, annars false.
-   *
-   *             - self: Pekare till tryckknappen som ska lsas av.
-   ********************************************************************************/
-   bool (*is_pressed)(const button_t* self);
-
-   /********************************************************************************
-   * enable_interrupt: Aktiverar PCI-avbrott p angiven tryckknapp s att event p
-   *                   tryckknappens pin medfr avbrott, bde p stigande och 
-   *                   fallande flank. Kontroll av flank mste sktas av anvndaren, 
-   *                   frslagsvis via avlsning i motsvarande avbrottsrutin.
-   *
-   *                   Nedan visas sambandet mellan anvnd I/O-port samt
-   *                   avbrottsvektorn fr motsvarande avbrottsrutin:
-   *
-   *                   I/O-port     pin (Arduino Uno)     Avbrottsvektor
-   *                      B              8 - 13             PCINT0_vect
-   *                      C             A0 - A5             PCINT1_vect
-   *                      D              0 - 7              PCINT2_vect
-   *
-   *                      - self: Pekare till tryckknappen som PCI-avbrott ska
-   *                              aktiveras p.
-   ********************************************************************************/
-   void (*enable_interrupt)(button_t* self);
-
-   /********************************************************************************
-   * disable_interrupt: Inaktiverar PCI-avbrott p angiven tryckknapp.
-   *
-   *                    - self: Pekare till tryckknappen som PCI-avbrott ska
-   *                            inaktiveras p.
-   ********************************************************************************/
-   void (*disable_interrupt)(button_t* self);
-
-   /********************************************************************************
-   * toggle_interrupt: Togglar aktivering av PCI-avbrott p angiven tryckknapp. 
-   *                   Om avbrott r aktiverat vid anrop s sker inaktivering. 
-   *                   P samma stt gller att om avbrott r inaktiverat vid anrop 
-   *                   s sker aktivering.
-   *
-   *                   - self: Pekare till tryckknappen som aktivering av 
-   *                           PCI-avbrott ska inaktiveras p.
-   ********************************************************************************/
-   void (*toggle_interrupt)(button_t* self);
-
-} button_vtable_t, *button_vptr_t;
-
-/********************************************************************************
-* button_init: Initierar ny tryckknapp p angiven pin.
-*
-*              - self: Pekare till tryckknappen som ska initieras.
-*              - pin : Tryckknappens pin-nummer p Arduino Uno, exempelvis 13.
-*                      Alternativt kan motsvarande port-nummer p ATmega328P
-*                      anges, exempelvis B5 fr pin 13 eller D3 fr pin 3.
-********************************************************************************/
-void button_init(button_t* self,
-                 const uint8_t pin);
-
-/********************************************************************************
-* button_clear: Nollstller tryckknapp samt motsvarande pin.
-*
-*               - self: Pekare till tryckknappen som ska nollstllas.
-********************************************************************************/
-void button_clear(button_t* self);
-
-/********************************************************************************
-* button_new: Allokerar minne och initierar en ny tryckknapp p angiven pin.
-*             En pekare returneras till tryckknappen efter initieringen.
-*             Vid misslyckad minnesallokering returneras en nullpekare.
-*
-*             - pin : Tryckknappens pin-nummer p Arduino Uno, exempelvis 8.
-*                     Alternativt kan motsvarande port-nummer p ATmega328P
-*                     anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-button_t* button_new(const uint8_t pin);
-
-/********************************************************************************
-* button_delete: Frigr minne allokerat fr angiven tryckknapp och stter 
-*                motsvarande pekare till null. Fr att kunna genomfra detta 
-*                passeras adressen till den pekare som pekar p tryckknappen.
-*
-*                - self: Adressen till den pekare som pekar p tryckknappen.
-********************************************************************************/
-void button_delete(button_t** self);
-
+/********************************************************************************
+* button.h: Innehåller funktionalitet för enkel implementering av tryckknappar
+*           via strukten button samt associerade funktioner, som nås via en 
+*           vtable-pekare. Denna strukt fungerar också utmärkt för andra 
+*           digitala inportar där insignalen ska kunna läsas av samt avbrott 
+*           ska kunna genereras vid ett godtyckligt event.
+********************************************************************************/
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "pool.h"
+#include "gpio.h"
+
+/* Makrodefinitioner: */
+#ifndef BUTTON_POOL_SIZE
+#define BUTTON_POOL_SIZE 8 /* Kapacitet för objektpoolen som används av button_new, 0 = malloc. */
+#endif
+
+#if BUTTON_POOL_SIZE > POOL_MAX_CAPACITY
+#error "BUTTON_POOL_SIZE får vara högst POOL_MAX_CAPACITY (255)!"
+#endif
+
+struct button_vtable; /* Fördeklarerar inför deklaration av strukten button. */
+struct button;        /* Fördeklarerar inför deklaration av callbackrutiner. */
+
+/********************************************************************************
+* button_event: Enumeration för event som detekteras vid PCI-avbrott.
+********************************************************************************/
+enum button_event
+{
+   BUTTON_EVENT_FALLING_EDGE, /* Fallande flank, insignalen har gått från hög till låg. */
+   BUTTON_EVENT_RISING_EDGE   /* Stigande flank, insignalen har gått från låg till hög. */
+};
+
+/********************************************************************************
+* button_callback_t: Typ för callbackrutiner som anropas vid event på en
+*                    tryckknapp. Rutinerna anropas från avbrottsrutinen och
+*                    bör därmed vara korta.
+*
+*                    - self : Pekare till tryckknappen där eventet skedde.
+*                    - event: Detekterat event (stigande eller fallande flank).
+********************************************************************************/
+typedef void (*button_callback_t)(struct button* self,
+                                  const enum button_event event);
+
+/********************************************************************************
+* button: Strukt för implementering av tryckknappar och andra digitala inportar.
+*         PCI-avbrott kan aktiveras på aktuell pin. Avbrottsrutinerna för
+*         PCINT0_vect, PCINT1_vect samt PCINT2_vect ägs av button.c, som
+*         jämför pinregistrets innehåll med föregående avläsning och anropar
+*         registrerad callbackrutin med detekterad flank för de tryckknappar
+*         vars insignal har ändrats. Därmed får användaren inte definiera
+*         egna avbrottsrutiner för dessa avbrottsvektorer.
+********************************************************************************/
+typedef struct button
+{
+   uint8_t pin;                /* Tryckknappens pin-nummer på aktuell I/O-port. */
+   enum io_port io_port;       /* I/O-port som lysdioden är ansluten till. */
+   uint8_t mask;               /* Bitmask för tryckknappens pin i pinregistret. */
+   bool interrupt_enabled;     /* Indikerar ifall PCI-avbrott är aktiverat. */
+   button_callback_t callback; /* Callbackrutin som anropas vid event, eller null. */
+   struct button_vtable* vptr; /* Pekare till vtable innehållande associerade funktioner. */
+} button_t, *button_ptr_t;
+
+/********************************************************************************
+* button_vtable: Strukt för vtable innehållande funktionspekare till associerade
+*                funktioner för strukten button.
+********************************************************************************/
+typedef struct button_vtable
+{
+   /********************************************************************************
+   * is_pressed: Läser av tryckknappens pin och indikerar ifall denna är nedtryckt.
+   *             I så fall returneras true, annars false. Ifall avstudsning har
+   *             startats via debounce_init returneras avstudsat värde.
+   *
+   *             - self: Pekare till tryckknappen som ska läsas av.
+   ********************************************************************************/
+   bool (*is_pressed)(const button_t* self);
+
+   /********************************************************************************
+   * enable_interrupt: Aktiverar PCI-avbrott på angiven tryckknapp så att event på
+   *                   tryckknappens pin medför avbrott, både på stigande och 
+   *                   fallande flank. Vid avbrott detekteras flanken automatiskt,
+   *                   varefter registrerad callbackrutin anropas.
+   *
+   *                   Nedan visas sambandet mellan använd I/O-port samt
+   *                   avbrottsvektorn för motsvarande avbrottsrutin:
+   *
+   *                   I/O-port     pin (Arduino Uno)     Avbrottsvektor
+   *                      B              8 - 13             PCINT0_vect
+   *                      C             A0 - A5             PCINT1_vect
+   *                      D              0 - 7              PCINT2_vect
+   *
+   *                      - self: Pekare till tryckknappen som PCI-avbrott ska
+   *                              aktiveras på.
+   ********************************************************************************/
+   void (*enable_interrupt)(button_t* self);
+
+   /********************************************************************************
+   * disable_interrupt: Inaktiverar PCI-avbrott på angiven tryckknapp.
+   *
+   *                    - self: Pekare till tryckknappen som PCI-avbrott ska
+   *                            inaktiveras på.
+   ********************************************************************************/
+   void (*disable_interrupt)(button_t* self);
+
+   /********************************************************************************
+   * toggle_interrupt: Togglar aktivering av PCI-avbrott på angiven tryckknapp. 
+   *                   Om avbrott är aktiverat vid anrop så sker inaktivering. 
+   *                   På samma sätt gäller att om avbrott är inaktiverat vid anrop 
+   *                   så sker aktivering.
+   *
+   *                   - self: Pekare till tryckknappen som aktivering av 
+   *                           PCI-avbrott ska inaktiveras på.
+   ********************************************************************************/
+   void (*toggle_interrupt)(button_t* self);
+
+   /********************************************************************************
+   * set_callback: Registrerar callbackrutin som anropas med detekterad flank vid
+   *               event på tryckknappens pin, förutsatt att PCI-avbrott är
+   *               aktiverat. En nullpekare avregistrerar callbackrutinen.
+   *
+   *               - self    : Pekare till tryckknappen.
+   *               - callback: Callbackrutinen som ska registreras.
+   ********************************************************************************/
+   void (*set_callback)(button_t* self, const button_callback_t callback);
+
+} button_vtable_t, *button_vptr_t;
+
+/********************************************************************************
+* button_static_init,
+* button_static_is_pressed: Statisk åtkomst av tryckknapp på konstant pin, som
+*                           alternativ till strukten button när pin-numret är
+*                           känt vid kompilering. Avläsning i en if-sats
+*                           kompileras då till en sbis- eller sbic-instruktion
+*                           utan vtable eller kontroll av I/O-port. Ingen
+*                           avstudsning sker. För pin-nummer som väljs under
+*                           körning används strukten button. Ogiltiga
+*                           pin-nummer avbryter kompileringen.
+*
+*                           - pin: Tryckknappens pin-nummer på Arduino Uno,
+*                                  som måste vara en konstant, exempelvis 13.
+********************************************************************************/
+#define button_static_init(pin) (gpio_check(pin), pin_portx(pin) |= pin_mask(pin))
+#define button_static_is_pressed(pin) (gpio_check(pin), (pin_pinx(pin) & pin_mask(pin)) ? true : false)
+
+/********************************************************************************
+* button_init: Initierar ny tryckknapp på angiven pin.
+*
+*              - self: Pekare till tryckknappen som ska initieras.
+*              - pin : Tryckknappens pin-nummer på Arduino Uno, exempelvis 13.
+*                      Alternativt kan motsvarande port-nummer på ATmega328P
+*                      anges, exempelvis B5 för pin 13 eller D3 för pin 3.
+*                      Konstanta pin-nummer kontrolleras vid kompilering.
+********************************************************************************/
+void button_init(button_t* self,
+                 const uint8_t pin);
+#define button_init(self, pin) ({ \
+   gpio_check(pin); \
+   button_init(self, pin); \
+})
+
+/********************************************************************************
+* button_clear: Nollställer tryckknapp samt motsvarande pin.
+*
+*               - self: Pekare till tryckknappen som ska nollställas.
+********************************************************************************/
+void button_clear(button_t* self);
+
+/********************************************************************************
+* button_new: Allokerar minne och initierar en ny tryckknapp på angiven pin.
+*             En pekare returneras till tryckknappen efter initieringen.
+*             Vid misslyckad minnesallokering returneras en nullpekare.
+*             Minnet allokeras från en statisk objektpool med kapacitet
+*             BUTTON_POOL_SIZE, alternativt via malloc om kapaciteten är 0.
+*
+*             - pin : Tryckknappens pin-nummer på Arduino Uno, exempelvis 8.
+*                     Alternativt kan motsvarande port-nummer på ATmega328P
+*                     anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+*                     Konstanta pin-nummer kontrolleras vid kompilering.
+********************************************************************************/
+button_t* button_new(const uint8_t pin);
+#define button_new(pin) ({ \
+   gpio_check(pin); \
+   button_new(pin); \
+})
+
+/********************************************************************************
+* button_delete: Frigör minne allokerat för angiven tryckknapp och sätter 
+*                motsvarande pekare till null. För att kunna genomföra detta 
+*                passeras adressen till den pekare som pekar på tryckknappen.
+*
+*                - self: Adressen till den pekare som pekar på tryckknappen.
+********************************************************************************/
+void button_delete(button_t** self);
+
+/********************************************************************************
+* button_pool_stats: Kopierar användningsstatistik för objektpoolen som
+*                    används av button_new samt button_delete. Ifall
+*                    objektpoolen är inaktiverad via BUTTON_POOL_SIZE 0
+*                    sätts samtliga värden till 0.
+*
+*                    - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void button_pool_stats(pool_stats_t* stats);
+
 #endif /* BUTTON_H_ */
\ No newline at end of file
@@ -0,0 +1,119 @@
+/********************************************************************************
+* button_group.c: Innehåller funktionsdefinitioner för grupper av tryckknappar.
+********************************************************************************/
+#include "button_group.h"
+#include "debounce.h"
+
+/* Statiska funktioner: */
+static uint8_t popcount8(uint8_t x);
+
+/********************************************************************************
+* button_group_init: Initierar ny tom grupp av tryckknappar.
+*
+*                    - self: Pekare till gruppen som ska initieras.
+********************************************************************************/
+void button_group_init(button_group_t* self)
+{
+   self->portb = 0;
+   self->portc = 0;
+   self->portd = 0;
+   return;
+}
+
+/********************************************************************************
+* button_group_add: Lägger till angiven tryckknapp i gruppen genom att dess
+*                   bitmask läggs till i masken för aktuell I/O-port.
+*
+*                   - self  : Pekare till gruppen som ska tilldelas.
+*                   - button: Pekare till tryckknappen som ska läggas till.
+********************************************************************************/
+void button_group_add(button_group_t* self,
+                      const button_t* button)
+{
+   if (button->io_port == IO_PORTB)
+   {
+      self->portb |= button->mask;
+   }
+   else if (button->io_port == IO_PORTC)
+   {
+      self->portc |= button->mask;
+   }
+   else if (button->io_port == IO_PORTD)
+   {
+      self->portd |= button->mask;
+   }
+
+   return;
+}
+
+/********************************************************************************
+* button_group_read: Läser av samtliga tryckknappar i gruppen vid samma
+*                    tidpunkt och returnerar antalet nedtryckta tryckknappar.
+*                    Portarna läses av direkt efter varandra med avbrott
+*                    inaktiverade, så att avstudsningen inte kan uppdatera
+*                    portarna mitt i avläsningen.
+*
+*                    - self   : Pekare till gruppen som ska läsas av.
+*                    - pressed: Pekare till strukt där nedtryckta
+*                               tryckknappar ska lagras, eller null.
+********************************************************************************/
+uint8_t button_group_read(const button_group_t* self,
+                          button_group_t* pressed)
+{
+   uint8_t portb, portc, portd, sreg;
+
+   atomic_begin(sreg);
+   portb = debounce_read(IO_PORTB);
+   portc = debounce_read(IO_PORTC);
+   portd = debounce_read(IO_PORTD);
+   atomic_end(sreg);
+
+   portb &= self->portb;
+   portc &= self->portc;
+   portd &= self->portd;
+
+   if (pressed)
+   {
+      pressed->portb = portb;
+      pressed->portc = portc;
+      pressed->portd = portd;
+   }
+
+   return popcount8(portb) + popcount8(portc) + popcount8(portd);
+}
+
+/********************************************************************************
+* button_group_count: Returnerar antalet tryckknappar i angiven grupp.
+*
+*                     - self: Pekare till gruppen vars tryckknappar ska räknas.
+********************************************************************************/
+uint8_t button_group_count(const button_group_t* self)
+{
+   return popcount8(self->portb) + popcount8(self->portc) + popcount8(self->portd);
+}
+
+/********************************************************************************
+* button_group_is_settled: Returnerar true ifall avstudsningen av samtliga
+*                          tryckknappar i angiven grupp är avslutad.
+*
+*                          - self: Pekare till gruppen som ska kontrolleras.
+********************************************************************************/
+bool button_group_is_settled(const button_group_t* self)
+{
+   return !(debounce_pending(IO_PORTB) & self->portb) &&
+          !(debounce_pending(IO_PORTC) & self->portc) &&
+          !(debounce_pending(IO_PORTD) & self->portd);
+}
+
+/********************************************************************************
+* popcount8: Returnerar antalet ettställda bitar i angiven byte. Bitarna
+*            summeras parvis, därefter i grupper om fyra, utan loop.
+*
+*            - x: Byten vars ettställda bitar ska räknas.
+********************************************************************************/
+static uint8_t popcount8(uint8_t x)
+{
+   x = x - ((x >> 1) & 0x55);
+   x = (x & 0x33) + ((x >> 2) & 0x33);
+   return (x + (x >> 4)) & 0x0F;
+}
@@ -0,0 +1,77 @@
+/********************************************************************************
+* button_group.h: Innehåller funktionalitet för grupper av tryckknappar, där
+*                 gruppens tryckknappar läses av samtidigt. Vid tillägg av en
+*                 tryckknapp läggs dess bit till i en förberäknad bitmask för
+*                 aktuell I/O-port. Vid avläsning läses varje port av en gång,
+*                 vilket ger en konsistent ögonblicksbild av samtliga
+*                 tryckknappar, oavsett antalet tryckknappar i gruppen.
+********************************************************************************/
+#ifndef BUTTON_GROUP_H_
+#define BUTTON_GROUP_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "button.h"
+
+/********************************************************************************
+* button_group: Strukt innehållande en bitmask per I/O-port. Används både för
+*               att lagra vilka tryckknappar som ingår i en grupp samt vilka
+*               av dessa som är nedtryckta vid avläsning.
+********************************************************************************/
+typedef struct button_group
+{
+   uint8_t portb; /* Bitmask för tryckknappar anslutna till I/O-port B. */
+   uint8_t portc; /* Bitmask för tryckknappar anslutna till I/O-port C. */
+   uint8_t portd; /* Bitmask för tryckknappar anslutna till I/O-port D. */
+} button_group_t;
+
+/********************************************************************************
+* button_group_init: Initierar ny tom grupp av tryckknappar.
+*
+*                    - self: Pekare till gruppen som ska initieras.
+********************************************************************************/
+void button_group_init(button_group_t* self);
+
+/********************************************************************************
+* button_group_add: Lägger till angiven tryckknapp i gruppen.
+*
+*                   - self  : Pekare till gruppen som ska tilldelas.
+*                   - button: Pekare till tryckknappen som ska läggas till.
+********************************************************************************/
+void button_group_add(button_group_t* self,
+                      const button_t* button);
+
+/********************************************************************************
+* button_group_read: Läser av samtliga tryckknappar i gruppen vid samma
+*                    tidpunkt och returnerar antalet nedtryckta tryckknappar.
+*                    Ifall avstudsning har startats via debounce_init används
+*                    avstudsade värden. Vilka tryckknappar som är nedtryckta
+*                    kan lagras i form av bitmasker per port.
+*
+*                    - self   : Pekare till gruppen som ska läsas av.
+*                    - pressed: Pekare till strukt där nedtryckta
+*                               tryckknappar ska lagras, eller null.
+********************************************************************************/
+uint8_t button_group_read(const button_group_t* self,
+                          button_group_t* pressed);
+
+/********************************************************************************
+* button_group_count: Returnerar antalet tryckknappar i angiven grupp, utan
+*                     avläsning av portarna. Kan exempelvis användas för att
+*                     räkna tryckknappar i bitmasker erhållna via
+*                     button_group_read.
+*
+*                     - self: Pekare till gruppen vars tryckknappar ska räknas.
+********************************************************************************/
+uint8_t button_group_count(const button_group_t* self);
+
+/********************************************************************************
+* button_group_is_settled: Returnerar true ifall avstudsningen av samtliga
+*                          tryckknappar i angiven grupp är avslutad, se
+*                          debounce_pending. Annars returneras false.
+*
+*                          - self: Pekare till gruppen som ska kontrolleras.
+********************************************************************************/
+bool button_group_is_settled(const button_group_t* self);
+
+#endif /* BUTTON_GROUP_H_ */
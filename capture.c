@@ -0,0 +1,145 @@
+/********************************************************************************
+* capture.c: Innehåller funktionsdefinitioner för tidsstämpling av flanker
+*            på ICP1 via Timer 1:s infångningsenhet.
+********************************************************************************/
+#include "capture.h"
+#include "trace.h"
+
+/* Makrodefinitioner: */
+#define CAPTURE_MASK (CAPTURE_BUFFER_SIZE - 1) /* Mask för index i bufferten. */
+
+/* Statiska variabler: */
+static volatile capture_event_t capture_buffer[CAPTURE_BUFFER_SIZE]; /* Ringbuffert. */
+static volatile uint8_t capture_head = 0; /* Skrivindex, uppdateras endast av avbrottsrutinen. */
+static volatile uint8_t capture_tail = 0; /* Läsindex, uppdateras endast av huvudloopen. */
+static volatile uint16_t capture_num_overflows = 0; /* Antalet förkastade flanker. */
+
+/********************************************************************************
+* capture_enable: Aktiverar infångning av flanker på angiven tryckknapp.
+*                 Systemtimern initieras vid behov. Ifall insignalen är hög
+*                 inleds infångningen med fallande flank, annars med
+*                 stigande. ICF1 nollställs efter valet av flank, eftersom
+*                 flaggan kan ettställas när riktningen ändras.
+*
+*                 - button: Pekare till tryckknappen.
+********************************************************************************/
+int capture_enable(const button_t* button)
+{
+   uint8_t sreg;
+   if (button->io_port != IO_PORTB || button->pin != pin_bit(CAPTURE_PIN)) return 1;
+
+   timer_init();
+   atomic_begin(sreg);
+   set(TCCR1B, ICNC1);
+
+   if (read(PINB, button->pin))
+   {
+      clr(TCCR1B, ICES1);
+   }
+   else
+   {
+      set(TCCR1B, ICES1);
+   }
+
+   TIFR1 = (1 << ICF1);
+   set(TIMSK1, ICIE1);
+   atomic_end(sreg);
+   return 0;
+}
+
+/********************************************************************************
+* capture_disable: Inaktiverar infångningen. Redan lagrade flanker kan
+*                  fortfarande läsas av.
+********************************************************************************/
+void capture_disable(void)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   clr(TIMSK1, ICIE1);
+   clr(TCCR1B, ICNC1);
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* capture_read: Tar ut den äldsta tidsstämplade flanken ur bufferten och
+*               kopierar den till angiven strukt. Läsindexet uppdateras
+*               först efter kopieringen, så att avbrottsrutinen inte kan
+*               skriva över flanken under läsning. Tidsstämpeln består av
+*               fyra byte men skrivs aldrig medan den läses, så avbrott
+*               behöver inte inaktiveras.
+*
+*               - event: Pekare till strukt där flanken ska lagras.
+********************************************************************************/
+bool capture_read(capture_event_t* event)
+{
+   const uint8_t tail = capture_tail;
+   volatile capture_event_t* source;
+   if (tail == capture_head) return false;
+
+   source = &capture_buffer[tail & CAPTURE_MASK];
+   event->ticks = source->ticks;
+   event->edge = source->edge;
+   capture_tail = tail + 1;
+   return true;
+}
+
+/********************************************************************************
+* capture_available: Returnerar antalet flanker som ligger i bufferten.
+********************************************************************************/
+uint8_t capture_available(void)
+{
+   return (uint8_t)(capture_head - capture_tail);
+}
+
+/********************************************************************************
+* capture_overflows: Returnerar antalet flanker som har förkastats på grund
+*                    av full buffert sedan programmets start.
+********************************************************************************/
+uint16_t capture_overflows(void)
+{
+   uint16_t overflows;
+   uint8_t sreg;
+   atomic_begin(sreg);
+   overflows = capture_num_overflows;
+   atomic_end(sreg);
+   return overflows;
+}
+
+/********************************************************************************
+* ISR (TIMER1_CAPT_vect): Avbrottsrutin som anropas vid infångad flank.
+*                        ICR1 kombineras med millisekundräknaren. Ifall
+*                        Timer 1 har nått sitt toppvärde före infångningen
+*                        men systemtimerns avbrott ännu inte har genomförts
+*                        räknas den väntande millisekunden med, vilket
+*                        detekteras via OCF1A på samma sätt som i micros.
+*                        Därefter växlas riktningen inför nästa flank. ICF1
+*                        nollställs via skrivning av en etta, så att OCF1A
+*                        inte påverkas.
+********************************************************************************/
+ISR (TIMER1_CAPT_vect)
+{
+   const uint16_t ticks = ICR1;
+   const uint8_t head = capture_head;
+   uint32_t ms;
+   trace_enter(TRACE_ISR_TIMER1_CAPT);
+
+   ms = millis();
+   if (read(TIFR1, OCF1A) && ticks < TIMER_TICKS_PER_MS / 2) ms++;
+
+   if ((uint8_t)(head - capture_tail) < CAPTURE_BUFFER_SIZE)
+   {
+      volatile capture_event_t* event = &capture_buffer[head & CAPTURE_MASK];
+      event->ticks = ms * TIMER_TICKS_PER_MS + ticks;
+      event->edge = read(TCCR1B, ICES1) ? BUTTON_EVENT_RISING_EDGE : BUTTON_EVENT_FALLING_EDGE;
+      capture_head = head + 1;
+   }
+   else
+   {
+      capture_num_overflows++;
+   }
+
+   TCCR1B ^= (1 << ICES1);
+   TIFR1 = (1 << ICF1);
+   trace_exit(TRACE_ISR_TIMER1_CAPT);
+}
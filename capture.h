@@ -0,0 +1,102 @@
+/********************************************************************************
+* capture.h: Innehåller funktionalitet för tidsstämpling av flanker på en
+*            tryckknapp ansluten till ICP1 (pin 8 / B0) via Timer 1:s
+*            infångningsenhet (input capture). Vid varje flank låser
+*            hårdvaran räknarvärdet i ICR1 utan fördröjning från
+*            avbrottsrutiner eller callbackrutiner, varefter avbrottsrutinen
+*            kombinerar ICR1 med systemtimerns millisekundräknare till en
+*            tidsstämpel mätt i timertick, det vill säga 0,5 us vid 16 MHz.
+*            Tidsstämplarna lagras i en ringbuffert som läses av från
+*            huvudloopen via capture_read, exempelvis för mätning av
+*            pulsbredd eller hur länge en tryckknapp hålls nedtryckt.
+*
+*            Infångningsenheten delar Timer 1 med systemtimern, vars
+*            CTC-mod med OCR1A som toppvärde lämnar ICR1 fritt för
+*            infångning. Brusfiltret ICNC1 aktiveras, vilket fördröjer varje
+*            flank med exakt fyra klockcykler. Ingen avstudsning sker, så
+*            studsar lagras som korta pulser som användaren kan sortera
+*            bort via pulsbredden. Ifall två flanker inträffar innan
+*            avbrottsrutinen har hunnit läsa ICR1 går den första förlorad.
+*            Timer 1 stannar i viloläget Power-down, så infångning kräver
+*            viloläget Idle.
+********************************************************************************/
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "button.h"
+#include "timer.h"
+
+/* Makrodefinitioner: */
+#define CAPTURE_PIN B0 /* ICP1, den enda pin som kan användas för infångning. */
+
+#ifndef CAPTURE_BUFFER_SIZE
+#define CAPTURE_BUFFER_SIZE 16 /* Buffertens kapacitet, måste vara en tvåpotens. */
+#endif
+
+#if CAPTURE_BUFFER_SIZE < 2 || CAPTURE_BUFFER_SIZE > 128 || (CAPTURE_BUFFER_SIZE & (CAPTURE_BUFFER_SIZE - 1))
+#error "CAPTURE_BUFFER_SIZE måste vara en tvåpotens mellan 2 och 128!"
+#endif
+
+/********************************************************************************
+* capture_event: Strukt för en tidsstämplad flank.
+********************************************************************************/
+typedef struct capture_event
+{
+   uint32_t ticks;         /* Tidpunkt mätt i timertick sedan systemtimern startades. */
+   enum button_event edge; /* Flankens riktning. */
+} capture_event_t;
+
+/********************************************************************************
+* capture_ticks_to_us: Omvandlar angivet antal timertick till mikrosekunder,
+*                      exempelvis tiden mellan två tidsstämplar. Tiden
+*                      mellan två tidsstämplar beräknas som differensen
+*                      mellan dem, vilket blir korrekt även när räknaren
+*                      slår runt efter cirka 35 minuter vid 16 MHz.
+*                      Omvandlingen sker via timer_ticks_to_us, som är exakt
+*                      även när antalet timertick per mikrosekund inte är
+*                      ett heltal, exempelvis vid 20 MHz.
+*
+*                      - ticks: Antalet timertick.
+********************************************************************************/
+#define capture_ticks_to_us(ticks) timer_ticks_to_us(ticks)
+
+/********************************************************************************
+* capture_enable: Aktiverar infångning av flanker på angiven tryckknapp.
+*                 Systemtimern initieras vid behov. Infångningen inleds
+*                 med flanken bort från insignalens aktuella nivå, varefter
+*                 riktningen växlas efter varje flank. Ifall tryckknappen
+*                 inte är ansluten till ICP1 returneras felkod 1, annars 0.
+*
+*                 - button: Pekare till tryckknappen.
+********************************************************************************/
+int capture_enable(const button_t* button);
+
+/********************************************************************************
+* capture_disable: Inaktiverar infångningen. Redan lagrade flanker kan
+*                  fortfarande läsas av.
+********************************************************************************/
+void capture_disable(void);
+
+/********************************************************************************
+* capture_read: Tar ut den äldsta tidsstämplade flanken ur bufferten och
+*               kopierar den till angiven strukt. Ifall bufferten är tom
+*               returneras false, annars true.
+*
+*               - event: Pekare till strukt där flanken ska lagras.
+********************************************************************************/
+bool capture_read(capture_event_t* event);
+
+/********************************************************************************
+* capture_available: Returnerar antalet flanker som ligger i bufferten.
+********************************************************************************/
+uint8_t capture_available(void);
+
+/********************************************************************************
+* capture_overflows: Returnerar antalet flanker som har förkastats på grund
+*                    av full buffert sedan programmets start.
+********************************************************************************/
+uint16_t capture_overflows(void);
+
+#endif /* CAPTURE_H_ */
@@ -0,0 +1,175 @@
+/********************************************************************************
+* debounce.c: Innehåller funktionsdefinitioner för bitparallell avstudsning
+*             av I/O-port B, C och D via vertikala räknare.
+********************************************************************************/
+#include "debounce.h"
+#include "timer.h"
+#include "event_queue.h"
+
+/* Statiska funktioner: */
+static void debounce_service(void);
+static uint8_t debounce_port(const uint8_t sample,
+                             const uint8_t index);
+static uint8_t debounce_read_raw(const enum io_port io_port);
+static void debounce_update(const uint8_t sample,
+                            const uint8_t index);
+
+/* Statiska variabler: */
+static volatile uint8_t debounce_state[IO_PORT_NONE]; /* Avstudsade värden per port. */
+static uint8_t debounce_count0[IO_PORT_NONE]; /* Räknarnas minst signifikanta bitar. */
+static uint8_t debounce_count1[IO_PORT_NONE]; /* Räknarnas mest signifikanta bitar. */
+static uint8_t debounce_counter_ms = 0; /* Förfluten tid sedan senaste sampling. */
+static bool debounce_enabled = false; /* Indikerar ifall avstudsning har startats. */
+static bool debounce_events_enabled = false; /* Indikerar ifall event ska genereras. */
+
+/********************************************************************************
+* debounce_init: Startar avstudsning av I/O-port B, C och D. Aktuella
+*                insignaler används som startvärden, varefter portarna
+*                samplas via systemtimern, som initieras vid behov.
+*                Upprepade anrop har ingen effekt.
+********************************************************************************/
+void debounce_init(void)
+{
+   uint8_t i;
+   if (debounce_enabled) return;
+
+   for (i = 0; i < IO_PORT_NONE; ++i)
+   {
+      debounce_state[i] = debounce_read_raw((enum io_port)i);
+      debounce_count0[i] = 0;
+      debounce_count1[i] = 0;
+   }
+
+   debounce_enabled = true;
+   timer_add_callback(debounce_service);
+   return;
+}
+
+/********************************************************************************
+* debounce_read: Returnerar avstudsat värde för samtliga pinnar på angiven
+*                I/O-port. Ifall avstudsning inte har startats returneras
+*                aktuellt innehåll i PINx direkt.
+*
+*                - io_port: I/O-porten vars insignaler ska läsas av.
+********************************************************************************/
+uint8_t debounce_read(const enum io_port io_port)
+{
+   if (io_port >= IO_PORT_NONE) return 0;
+   if (!debounce_enabled) return debounce_read_raw(io_port);
+   return debounce_state[io_port];
+}
+
+/********************************************************************************
+* debounce_enable_events: Aktiverar event vid ändrade avstudsade värden.
+********************************************************************************/
+void debounce_enable_events(void)
+{
+   debounce_events_enabled = true;
+   return;
+}
+
+/********************************************************************************
+* debounce_pending: Returnerar en bitmask för de pinnar på angiven I/O-port
+*                   vars avstudsning pågår. Räknarna läses med avbrott
+*                   inaktiverade, eftersom de uppdateras av systemtimern.
+*
+*                   - io_port: I/O-porten som ska kontrolleras.
+********************************************************************************/
+uint8_t debounce_pending(const enum io_port io_port)
+{
+   uint8_t sreg;
+   uint8_t pending;
+   if (io_port >= IO_PORT_NONE || !debounce_enabled) return 0;
+
+   atomic_begin(sreg);
+   pending = debounce_read_raw(io_port) ^ debounce_state[io_port];
+   pending |= debounce_count0[io_port] | debounce_count1[io_port];
+   atomic_end(sreg);
+   return pending;
+}
+
+/********************************************************************************
+* debounce_read_raw: Returnerar aktuellt innehåll i PINx för angiven I/O-port.
+*
+*                    - io_port: I/O-porten vars insignaler ska läsas av.
+********************************************************************************/
+static uint8_t debounce_read_raw(const enum io_port io_port)
+{
+   if (io_port == IO_PORTB)
+   {
+      return PINB;
+   }
+   else if (io_port == IO_PORTC)
+   {
+      return PINC;
+   }
+   else if (io_port == IO_PORTD)
+   {
+      return PIND;
+   }
+   else
+   {
+      return 0;
+   }
+}
+
+/********************************************************************************
+* debounce_port: Uppdaterar de vertikala räknarna för en I/O-port utifrån ny
+*                sampling. Räknarna för pinnar vars sampling överensstämmer
+*                med avstudsat värde nollställs, medan övriga räknas upp.
+*                När en räknare slår runt efter fyra avvikande samplingar i
+*                följd togglas motsvarande bit i det avstudsade värdet, som
+*                returneras.
+*
+*                - sample: Ny sampling av portens pinregister.
+*                - index : Portens index i tabellerna, dvs. dess io_port.
+********************************************************************************/
+static uint8_t debounce_port(const uint8_t sample,
+                             const uint8_t index)
+{
+   const uint8_t delta = sample ^ debounce_state[index];
+   uint8_t toggle;
+
+   debounce_count1[index] = (debounce_count1[index] ^ debounce_count0[index]) & delta;
+   debounce_count0[index] = ~debounce_count0[index] & delta;
+   toggle = delta & ~(debounce_count0[index] | debounce_count1[index]);
+   return debounce_state[index] ^ toggle;
+}
+
+/********************************************************************************
+* debounce_update: Uppdaterar avstudsat värde för en I/O-port utifrån ny
+*                  sampling. Ifall värdet ändras och event är aktiverade
+*                  läggs eventet EVENT_INPUT_CHANGED till i eventkön.
+*
+*                  - sample: Ny sampling av portens pinregister.
+*                  - index : Portens index i tabellerna, dvs. dess io_port.
+********************************************************************************/
+static void debounce_update(const uint8_t sample,
+                            const uint8_t index)
+{
+   const uint8_t state = debounce_port(sample, index);
+   const uint8_t changed = state ^ debounce_state[index];
+   debounce_state[index] = state;
+
+   if (changed && debounce_events_enabled)
+   {
+      event_queue_push(EVENT_INPUT_CHANGED, index, changed);
+   }
+   return;
+}
+
+/********************************************************************************
+* debounce_service: Callbackrutin som anropas av systemtimern en gång per
+*                   millisekund. Var DEBOUNCE_INTERVAL_MS millisekund samplas
+*                   samtliga tre portar, vars avstudsade värden uppdateras.
+********************************************************************************/
+static void debounce_service(void)
+{
+   if (++debounce_counter_ms < DEBOUNCE_INTERVAL_MS) return;
+   debounce_counter_ms = 0;
+
+   debounce_update(PINB, IO_PORTB);
+   debounce_update(PINC, IO_PORTC);
+   debounce_update(PIND, IO_PORTD);
+   return;
+}
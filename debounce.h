@@ -0,0 +1,64 @@
+/********************************************************************************
+* debounce.h: Innehåller funktionalitet för avstudsning av samtliga digitala
+*             inportar på I/O-port B, C och D. Portarna samplas periodiskt via
+*             systemtimern, där samtliga pinnar på en port avstudsas samtidigt
+*             via vertikala räknare, dvs. en tvåbitars räknare per pin som
+*             lagras bitvis i två byte per port. En pins avstudsade värde
+*             ändras först efter att fyra samplingar i följd har avvikit från
+*             aktuellt värde, vilket vid samplingsintervallet 5 ms motsvarar
+*             20 ms. Kostnaden per sampling är konstant, oavsett antalet
+*             pinnar som används.
+********************************************************************************/
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#ifndef DEBOUNCE_INTERVAL_MS
+#define DEBOUNCE_INTERVAL_MS 5 /* Samplingsintervall för avstudsningen mätt i ms. */
+#endif
+
+/********************************************************************************
+* debounce_init: Startar avstudsning av I/O-port B, C och D. Aktuella
+*                insignaler används som startvärden, varefter portarna
+*                samplas via systemtimern, som initieras vid behov.
+*                Upprepade anrop har ingen effekt.
+********************************************************************************/
+void debounce_init(void);
+
+/********************************************************************************
+* debounce_read: Returnerar avstudsat värde för samtliga pinnar på angiven
+*                I/O-port, motsvarande innehållet i PINx. Ifall avstudsning
+*                inte har startats via debounce_init returneras aktuellt
+*                innehåll i PINx direkt. För ogiltig I/O-port returneras 0.
+*
+*                - io_port: I/O-porten vars insignaler ska läsas av.
+********************************************************************************/
+uint8_t debounce_read(const enum io_port io_port);
+
+/********************************************************************************
+* debounce_enable_events: Aktiverar event vid ändrade avstudsade värden. Vid
+*                         varje sampling där avstudsat värde ändras för en
+*                         I/O-port läggs eventet EVENT_INPUT_CHANGED till i
+*                         eventkön, se event_queue.h, med porten som källa
+*                         och ändrade bitar som data. Huvudloopen behöver
+*                         därmed inte läsa av portarna förrän ett event har
+*                         erhållits.
+********************************************************************************/
+void debounce_enable_events(void);
+
+/********************************************************************************
+* debounce_pending: Returnerar en bitmask för de pinnar på angiven I/O-port
+*                   vars avstudsning pågår, det vill säga där aktuell
+*                   insignal avviker från avstudsat värde eller där räknaren
+*                   ännu inte har nollställts. Systemtimern måste därmed
+*                   fortsätta gå för dessa pinnar. Ifall avstudsning inte har
+*                   startats eller I/O-porten är ogiltig returneras 0.
+*
+*                   - io_port: I/O-porten som ska kontrolleras.
+********************************************************************************/
+uint8_t debounce_pending(const enum io_port io_port);
+
+#endif /* DEBOUNCE_H_ */
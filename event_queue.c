@@ -0,0 +1,127 @@
+/********************************************************************************
+* event_queue.c: Innehåller funktionsdefinitioner för kön av event mellan
+*                avbrottsrutiner och huvudloopen.
+********************************************************************************/
+#include "event_queue.h"
+
+/* Makrodefinitioner: */
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1) /* Mask för index i bufferten. */
+
+/* Statiska variabler: */
+static volatile event_t event_queue_buffer[EVENT_QUEUE_SIZE]; /* Köns ringbuffert. */
+static volatile uint8_t event_queue_head = 0; /* Skrivindex, uppdateras endast av producenten. */
+static volatile uint8_t event_queue_tail = 0; /* Läsindex, uppdateras endast av konsumenten. */
+static volatile uint16_t event_queue_num_overflows = 0; /* Antalet förkastade event. */
+static volatile uint8_t event_queue_max_size = 0; /* Högsta antalet event i kön. */
+
+/********************************************************************************
+* event_queue_push: Lägger till ett event sist i kön. Indexen räknas upp
+*                   kontinuerligt och maskas vid åtkomst av bufferten,
+*                   vilket medför att skillnaden mellan dem alltid utgör
+*                   antalet event i kön. Eventet skrivs innan skrivindexet
+*                   uppdateras, så att konsumenten aldrig läser ofullständiga
+*                   event.
+*
+*                   - type  : Eventets typ.
+*                   - source: Eventets källa, exempelvis pin-nummer.
+*                   - data  : Data associerad med eventet.
+********************************************************************************/
+bool event_queue_push(const uint8_t type,
+                      const uint8_t source,
+                      const uint16_t data)
+{
+   const uint8_t head = event_queue_head;
+   const uint8_t size = (uint8_t)(head - event_queue_tail);
+   volatile event_t* event;
+
+   if (size >= EVENT_QUEUE_SIZE)
+   {
+      event_queue_num_overflows++;
+      return false;
+   }
+
+   event = &event_queue_buffer[head & EVENT_QUEUE_MASK];
+   event->type = type;
+   event->source = source;
+   event->data = data;
+   event_queue_head = head + 1;
+
+   if (size + 1 > event_queue_max_size)
+   {
+      event_queue_max_size = size + 1;
+   }
+
+   return true;
+}
+
+/********************************************************************************
+* event_queue_pop: Tar ut det äldsta eventet ur kön och kopierar det till
+*                  angiven strukt.
+*
+*                  - event: Pekare till strukt där eventet ska lagras.
+********************************************************************************/
+bool event_queue_pop(event_t* event)
+{
+   return event_queue_pop_batch(event, 1) ? true : false;
+}
+
+/********************************************************************************
+* event_queue_pop_batch: Tar ut upp till angivet antal event ur kön och
+*                        kopierar dem till angiven array. Läsindexet
+*                        uppdateras först efter kopieringen, så att
+*                        producenten inte kan skriva över eventen innan dess.
+*
+*                        - events    : Array där eventen ska lagras.
+*                        - max_events: Maximalt antal event som ska tas ut.
+********************************************************************************/
+uint8_t event_queue_pop_batch(event_t* events,
+                              const uint8_t max_events)
+{
+   uint8_t tail = event_queue_tail;
+   const uint8_t head = event_queue_head;
+   uint8_t num = 0;
+
+   while (tail != head && num < max_events)
+   {
+      const volatile event_t* event = &event_queue_buffer[tail & EVENT_QUEUE_MASK];
+      events[num].type = event->type;
+      events[num].source = event->source;
+      events[num].data = event->data;
+      num++;
+      tail++;
+   }
+
+   event_queue_tail = tail;
+   return num;
+}
+
+/********************************************************************************
+* event_queue_size: Returnerar antalet event som för tillfället ligger i kön.
+********************************************************************************/
+uint8_t event_queue_size(void)
+{
+   return (uint8_t)(event_queue_head - event_queue_tail);
+}
+
+/********************************************************************************
+* event_queue_overflows: Returnerar antalet förkastade event. Räknaren består
+*                        av två byte och läses därmed av atomärt.
+********************************************************************************/
+uint16_t event_queue_overflows(void)
+{
+   uint16_t num;
+   uint8_t sreg;
+   atomic_begin(sreg);
+   num = event_queue_num_overflows;
+   atomic_end(sreg);
+   return num;
+}
+
+/********************************************************************************
+* event_queue_high_water_mark: Returnerar högsta antalet event som samtidigt
+*                              har legat i kön sedan programmets start.
+********************************************************************************/
+uint8_t event_queue_high_water_mark(void)
+{
+   return event_queue_max_size;
+}
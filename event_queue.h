@@ -0,0 +1,106 @@
+/********************************************************************************
+* event_queue.h: Innehåller funktionalitet för en kö av kompakta event, som
+*                används för att överföra event från avbrottsrutiner, exempelvis
+*                flanker på tryckknappar eller timeravbrott, till programmets
+*                huvudloop. Kön är implementerad som en ringbuffert med en
+*                producent (avbrottsrutinerna) samt en konsument (huvudloopen).
+*                Eftersom producenten endast skriver till skrivindex och
+*                konsumenten endast till läsindex, som båda består av en byte,
+*                krävs ingen inaktivering av avbrott vid läsning eller skrivning.
+*
+*                Avbrottsrutiner på ATmega328P avbryter inte varandra, vilket
+*                medför att samtliga avbrottsrutiner utgör en producent.
+*                Event som läggs till från huvudloopen måste därmed läggas
+*                till med avbrott inaktiverade.
+********************************************************************************/
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 16 /* Köns kapacitet, måste vara en tvåpotens. */
+#endif
+
+#if EVENT_QUEUE_SIZE < 2 || EVENT_QUEUE_SIZE > 128 || (EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1))
+#error "EVENT_QUEUE_SIZE måste vara en tvåpotens mellan 2 och 128!"
+#endif
+
+/********************************************************************************
+* event_type: Enumeration för olika typer av event.
+********************************************************************************/
+enum event_type
+{
+   EVENT_NONE,                /* Inget event. */
+   EVENT_BUTTON_FALLING_EDGE, /* Fallande flank på tryckknapp, source = pin-nummer. */
+   EVENT_BUTTON_RISING_EDGE,  /* Stigande flank på tryckknapp, source = pin-nummer. */
+   EVENT_TIMER,               /* Timerevent, data = tidpunkt eller räknarvärde. */
+   EVENT_INPUT_CHANGED,       /* Avstudsad insignal ändrad, source = I/O-port, data = ändrade bitar. */
+   EVENT_USER                 /* Första lediga värde för applikationsspecifika event. */
+};
+
+/********************************************************************************
+* event: Strukt för kompakta event på fyra byte.
+********************************************************************************/
+typedef struct event
+{
+   uint8_t type;   /* Eventets typ, se enumerationen event_type. */
+   uint8_t source; /* Eventets källa, exempelvis pin-nummer. */
+   uint16_t data;  /* Godtycklig data associerad med eventet. */
+} event_t;
+
+/********************************************************************************
+* event_queue_push: Lägger till ett event sist i kön. Anropas från
+*                   avbrottsrutiner. Ifall kön är full förkastas eventet,
+*                   antalet förlorade event räknas upp och false returneras.
+*                   Annars returneras true. Tidsåtgången är konstant.
+*
+*                   - type  : Eventets typ.
+*                   - source: Eventets källa, exempelvis pin-nummer.
+*                   - data  : Data associerad med eventet.
+********************************************************************************/
+bool event_queue_push(const uint8_t type,
+                      const uint8_t source,
+                      const uint16_t data);
+
+/********************************************************************************
+* event_queue_pop: Tar ut det äldsta eventet ur kön och kopierar det till
+*                  angiven strukt. Anropas från huvudloopen. Ifall kön är tom
+*                  returneras false, annars true.
+*
+*                  - event: Pekare till strukt där eventet ska lagras.
+********************************************************************************/
+bool event_queue_pop(event_t* event);
+
+/********************************************************************************
+* event_queue_pop_batch: Tar ut upp till angivet antal event ur kön och
+*                        kopierar dem till angiven array. Skrivindexet läses
+*                        av en gång och läsindexet uppdateras en gång per
+*                        anrop. Antalet uttagna event returneras.
+*
+*                        - events    : Array där eventen ska lagras.
+*                        - max_events: Maximalt antal event som ska tas ut.
+********************************************************************************/
+uint8_t event_queue_pop_batch(event_t* events,
+                              const uint8_t max_events);
+
+/********************************************************************************
+* event_queue_size: Returnerar antalet event som för tillfället ligger i kön.
+********************************************************************************/
+uint8_t event_queue_size(void);
+
+/********************************************************************************
+* event_queue_overflows: Returnerar antalet event som har förkastats på grund
+*                        av full kö sedan programmets start.
+********************************************************************************/
+uint16_t event_queue_overflows(void);
+
+/********************************************************************************
+* event_queue_high_water_mark: Returnerar högsta antalet event som samtidigt
+*                              har legat i kön sedan programmets start.
+********************************************************************************/
+uint8_t event_queue_high_water_mark(void);
+
+#endif /* EVENT_QUEUE_H_ */
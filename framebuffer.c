@@ -0,0 +1,325 @@
+/********************************************************************************
+* framebuffer.c: Innehåller funktionsdefinitioner för bildbuffertar över
+*                lysdioderna i en led-array.
+********************************************************************************/
+#include "framebuffer.h"
+
+/********************************************************************************
+* framebuffer_bit: Returnerar bit för angivet index i angiven buffert.
+*
+*                  - bits : Pekare till bufferten.
+*                  - index: Bitens index.
+********************************************************************************/
+#define framebuffer_bit(bits, index) ((bits)[(index) >> 3] & (1 << ((index) & 0x07)))
+
+/* Statiska funktioner: */
+static void framebuffer_trim(framebuffer_t* self);
+
+/********************************************************************************
+* framebuffer_init: Initierar ny tom bildbuffert för angiven led-array.
+*
+*                   - self: Pekare till bufferten som ska initieras.
+*                   - leds: Pekare till arrayen som bufferten ska visas på.
+********************************************************************************/
+void framebuffer_init(framebuffer_t* self,
+                      const led_array_t* leds)
+{
+   self->leds = leds;
+   self->size = leds->size < FRAMEBUFFER_MAX_LEDS ? (uint8_t)leds->size : FRAMEBUFFER_MAX_LEDS;
+   framebuffer_clear(self);
+   return;
+}
+
+/********************************************************************************
+* framebuffer_clear: Släcker samtliga lysdioder i bufferten.
+*
+*                    - self: Pekare till bufferten.
+********************************************************************************/
+void framebuffer_clear(framebuffer_t* self)
+{
+   uint8_t i;
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      self->bits[i] = 0;
+   }
+
+   return;
+}
+
+/********************************************************************************
+* framebuffer_fill: Tänder samtliga lysdioder i bufferten.
+*
+*                   - self: Pekare till bufferten.
+********************************************************************************/
+void framebuffer_fill(framebuffer_t* self)
+{
+   uint8_t i;
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      self->bits[i] = 0xFF;
+   }
+
+   framebuffer_trim(self);
+   return;
+}
+
+/********************************************************************************
+* framebuffer_load: Sätter de första 16 lysdioderna i bufferten enligt
+*                   angiven bitmask och släcker övriga.
+*
+*                   - self: Pekare till bufferten.
+*                   - bits: Bitmask för de lysdioder som ska vara tända.
+********************************************************************************/
+void framebuffer_load(framebuffer_t* self,
+                      const uint16_t bits)
+{
+   framebuffer_clear(self);
+   self->bits[0] = (uint8_t)bits;
+   self->bits[1] = (uint8_t)(bits >> 8);
+   framebuffer_trim(self);
+   return;
+}
+
+/********************************************************************************
+* framebuffer_set: Tänder eller släcker lysdiod med angivet index.
+*
+*                  - self  : Pekare till bufferten.
+*                  - index : Lysdiodens index i arrayen.
+*                  - enable: Indikerar ifall lysdioden ska tändas.
+********************************************************************************/
+void framebuffer_set(framebuffer_t* self,
+                     const uint8_t index,
+                     const bool enable)
+{
+   if (index >= self->size) return;
+
+   if (enable)
+   {
+      self->bits[index >> 3] |= (1 << (index & 0x07));
+   }
+   else
+   {
+      self->bits[index >> 3] &= ~(1 << (index & 0x07));
+   }
+
+   return;
+}
+
+/********************************************************************************
+* framebuffer_get: Returnerar true ifall lysdiod med angivet index är tänd.
+*
+*                  - self : Pekare till bufferten.
+*                  - index: Lysdiodens index i arrayen.
+********************************************************************************/
+bool framebuffer_get(const framebuffer_t* self,
+                     const uint8_t index)
+{
+   if (index >= self->size) return false;
+   return framebuffer_bit(self->bits, index) ? true : false;
+}
+
+/********************************************************************************
+* framebuffer_toggle: Togglar lysdiod med angivet index.
+*
+*                     - self : Pekare till bufferten.
+*                     - index: Lysdiodens index i arrayen.
+********************************************************************************/
+void framebuffer_toggle(framebuffer_t* self,
+                        const uint8_t index)
+{
+   if (index >= self->size) return;
+   self->bits[index >> 3] ^= (1 << (index & 0x07));
+   return;
+}
+
+/********************************************************************************
+* framebuffer_shift: Skiftar bufferten angivet antal steg. Varje position
+*                    hämtar sin bit från positionen angivet antal steg
+*                    bakåt, eller släcks ifall den ligger utanför bufferten.
+*
+*                    - self : Pekare till bufferten.
+*                    - steps: Antalet steg som bufferten ska skiftas.
+********************************************************************************/
+void framebuffer_shift(framebuffer_t* self,
+                       const int8_t steps)
+{
+   uint8_t result[FRAMEBUFFER_BYTES] = { 0 };
+   uint8_t i;
+
+   for (i = 0; i < self->size; ++i)
+   {
+      const int16_t source = (int16_t)i - steps;
+
+      if (source >= 0 && source < self->size && framebuffer_bit(self->bits, source))
+      {
+         result[i >> 3] |= (1 << (i & 0x07));
+      }
+   }
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      self->bits[i] = result[i];
+   }
+
+   return;
+}
+
+/********************************************************************************
+* framebuffer_rotate: Roterar bufferten angivet antal steg. Varje position
+*                     hämtar sin bit från positionen angivet antal steg
+*                     bakåt, räknat modulo buffertens storlek.
+*
+*                     - self : Pekare till bufferten.
+*                     - steps: Antalet steg som bufferten ska roteras.
+********************************************************************************/
+void framebuffer_rotate(framebuffer_t* self,
+                        const int8_t steps)
+{
+   uint8_t result[FRAMEBUFFER_BYTES] = { 0 };
+   uint8_t i;
+   int16_t offset;
+   if (!self->size) return;
+
+   offset = steps % (int16_t)self->size;
+   if (offset < 0) offset += self->size;
+
+   for (i = 0; i < self->size; ++i)
+   {
+      const uint8_t source = (uint8_t)((i + self->size - offset) % self->size);
+
+      if (framebuffer_bit(self->bits, source))
+      {
+         result[i >> 3] |= (1 << (i & 0x07));
+      }
+   }
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      self->bits[i] = result[i];
+   }
+
+   return;
+}
+
+/********************************************************************************
+* framebuffer_mask: Kombinerar bufferten med angiven mask via angiven
+*                   bitoperation, en byte i taget.
+*
+*                   - self: Pekare till bufferten.
+*                   - mask: Pekare till masken, FRAMEBUFFER_BYTES byte.
+*                   - op  : Bitoperationen som ska genomföras.
+********************************************************************************/
+void framebuffer_mask(framebuffer_t* self,
+                      const uint8_t* mask,
+                      const enum framebuffer_op op)
+{
+   uint8_t i;
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      if (op == FRAMEBUFFER_OP_AND)
+      {
+         self->bits[i] &= mask[i];
+      }
+      else if (op == FRAMEBUFFER_OP_OR)
+      {
+         self->bits[i] |= mask[i];
+      }
+      else
+      {
+         self->bits[i] ^= mask[i];
+      }
+   }
+
+   framebuffer_trim(self);
+   return;
+}
+
+/********************************************************************************
+* framebuffer_commit: Visar buffertens bildruta på arrayens lysdioder.
+*                     Portmasker för samtliga lysdioder på I/O-port B, C och
+*                     D samt för de som ska vara tända beräknas först, med
+*                     avbrott aktiverade. Därefter skrivs portarna via
+*                     led_array_mask_set och övriga lysdioder sätts via
+*                     sitt vtable, med avbrott inaktiverade. Endast
+*                     lysdioder som fortfarande finns i arrayen visas,
+*                     ifall arrayen har minskats sedan initieringen.
+*
+*                     - self: Pekare till bufferten som ska visas.
+********************************************************************************/
+void framebuffer_commit(framebuffer_t* self)
+{
+   led_array_mask_t covered;
+   led_array_mask_t pattern;
+   bool other_leds = false;
+   uint8_t sreg;
+   uint8_t i;
+   const uint8_t size = self->leds->size < self->size ? (uint8_t)self->leds->size : self->size;
+
+   led_array_mask_init(&covered);
+   led_array_mask_init(&pattern);
+
+   for (i = 0; i < size; ++i)
+   {
+      led_t* led = self->leds->leds[i];
+
+      if (led->io_port == IO_PORT_NONE)
+      {
+         other_leds = true;
+      }
+      else
+      {
+         led->enabled = framebuffer_bit(self->bits, i) ? true : false;
+         led_array_mask_add(&covered, led);
+         if (led->enabled) led_array_mask_add(&pattern, led);
+      }
+   }
+
+   atomic_begin(sreg);
+   led_array_mask_set(&covered, &pattern);
+
+   for (i = 0; other_leds && i < size; ++i)
+   {
+      led_t* led = self->leds->leds[i];
+      const bool enable = framebuffer_bit(self->bits, i) ? true : false;
+      if (led->io_port != IO_PORT_NONE || led->enabled == enable) continue;
+
+      if (enable)
+      {
+         led->vptr->on(led);
+      }
+      else
+      {
+         led->vptr->off(led);
+      }
+   }
+
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* framebuffer_trim: Nollställer bitar för index utanför bufferten.
+*
+*                   - self: Pekare till bufferten.
+********************************************************************************/
+static void framebuffer_trim(framebuffer_t* self)
+{
+   uint8_t i;
+
+   for (i = 0; i < FRAMEBUFFER_BYTES; ++i)
+   {
+      if (self->size <= i * 8)
+      {
+         self->bits[i] = 0;
+      }
+      else if (self->size < (i + 1) * 8)
+      {
+         self->bits[i] &= (uint8_t)((1 << (self->size & 0x07)) - 1);
+      }
+   }
+
+   return;
+}
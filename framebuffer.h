@@ -0,0 +1,182 @@
+/********************************************************************************
+* framebuffer.h: Innehåller funktionalitet för en bildbuffert över lysdioderna
+*                i en led-array, där bit i motsvarar lysdiod i i arrayen.
+*                Nästa bildruta komponeras i bufferten via bitoperationer,
+*                exempelvis skiftning, rotation och maskning, utan någon
+*                åtkomst av register. Bildrutan visas därefter i sin helhet
+*                via framebuffer_commit, som skriver varje I/O-port en gång
+*                med avbrott inaktiverade. Därmed syns aldrig halvt
+*                uppdaterade bildrutor, till skillnad från makrona i
+*                led_array.h som sätter en lysdiod i taget.
+*
+*                Portregistren utgör den visade bildrutan, medan bufferten
+*                utgör nästa bildruta. Bufferten lämnas oförändrad vid
+*                framebuffer_commit, så att nästa bildruta kan komponeras
+*                utifrån föregående. Lysdioder som inte är anslutna till en
+*                I/O-port, exempelvis via skiftregister eller lysdiodmatris,
+*                sätts via sitt vtable och enbart ifall deras tillstånd
+*                ändras. Dessa visas vid nästa utskrivning från
+*                systemtimern, det vill säga inom en millisekund.
+********************************************************************************/
+#ifndef FRAMEBUFFER_H_
+#define FRAMEBUFFER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led_array.h"
+
+/* Makrodefinitioner: */
+#ifndef FRAMEBUFFER_MAX_LEDS
+#define FRAMEBUFFER_MAX_LEDS 32 /* Maximalt antal lysdioder per bildbuffert. */
+#endif
+
+#define FRAMEBUFFER_BYTES ((FRAMEBUFFER_MAX_LEDS + 7) / 8) /* Buffertens storlek i byte. */
+
+#if FRAMEBUFFER_MAX_LEDS < 16 || FRAMEBUFFER_MAX_LEDS > 255
+#error "FRAMEBUFFER_MAX_LEDS måste vara mellan 16 och 255, se pattern.h!"
+#endif
+
+/********************************************************************************
+* framebuffer_op: Enumeration för bitoperationer vid maskning av bufferten.
+********************************************************************************/
+enum framebuffer_op
+{
+   FRAMEBUFFER_OP_AND, /* Lysdioder utanför masken släcks. */
+   FRAMEBUFFER_OP_OR,  /* Lysdioder i masken tänds. */
+   FRAMEBUFFER_OP_XOR  /* Lysdioder i masken togglas. */
+};
+
+/********************************************************************************
+* framebuffer: Strukt för bildbuffertar. Bitar för index utanför bufferten
+*              är alltid nollställda.
+********************************************************************************/
+typedef struct framebuffer
+{
+   const led_array_t* leds;         /* Arrayen vars lysdioder bufferten visas på. */
+   uint8_t size;                    /* Antalet lysdioder i bufferten. */
+   uint8_t bits[FRAMEBUFFER_BYTES]; /* Nästa bildruta, bit i motsvarar lysdiod i. */
+} framebuffer_t;
+
+/********************************************************************************
+* framebuffer_init: Initierar ny tom bildbuffert för angiven led-array. Ifall
+*                   arrayen innehåller fler än FRAMEBUFFER_MAX_LEDS lysdioder
+*                   omfattas endast de första. Lysdioder som läggs till i
+*                   arrayen efter initieringen omfattas inte. Lysdioder som
+*                   tas bort ur arrayen efter initieringen, exempelvis via
+*                   led_array_pop, hoppas över av framebuffer_commit.
+*
+*                   - self: Pekare till bufferten som ska initieras.
+*                   - leds: Pekare till arrayen som bufferten ska visas på.
+********************************************************************************/
+void framebuffer_init(framebuffer_t* self,
+                      const led_array_t* leds);
+
+/********************************************************************************
+* framebuffer_clear: Släcker samtliga lysdioder i bufferten.
+*
+*                    - self: Pekare till bufferten.
+********************************************************************************/
+void framebuffer_clear(framebuffer_t* self);
+
+/********************************************************************************
+* framebuffer_fill: Tänder samtliga lysdioder i bufferten.
+*
+*                   - self: Pekare till bufferten.
+********************************************************************************/
+void framebuffer_fill(framebuffer_t* self);
+
+/********************************************************************************
+* framebuffer_load: Sätter de första 16 lysdioderna i bufferten enligt
+*                   angiven bitmask, där bit i motsvarar lysdiod i, och
+*                   släcker övriga, se pattern.h.
+*
+*                   - self: Pekare till bufferten.
+*                   - bits: Bitmask för de lysdioder som ska vara tända.
+********************************************************************************/
+void framebuffer_load(framebuffer_t* self,
+                      const uint16_t bits);
+
+/********************************************************************************
+* framebuffer_set: Tänder eller släcker lysdiod med angivet index i
+*                  bufferten. Index utanför bufferten ignoreras.
+*
+*                  - self  : Pekare till bufferten.
+*                  - index : Lysdiodens index i arrayen.
+*                  - enable: Indikerar ifall lysdioden ska tändas.
+********************************************************************************/
+void framebuffer_set(framebuffer_t* self,
+                     const uint8_t index,
+                     const bool enable);
+
+/********************************************************************************
+* framebuffer_get: Returnerar true ifall lysdiod med angivet index är tänd i
+*                  bufferten, annars false.
+*
+*                  - self : Pekare till bufferten.
+*                  - index: Lysdiodens index i arrayen.
+********************************************************************************/
+bool framebuffer_get(const framebuffer_t* self,
+                     const uint8_t index);
+
+/********************************************************************************
+* framebuffer_toggle: Togglar lysdiod med angivet index i bufferten.
+*
+*                     - self : Pekare till bufferten.
+*                     - index: Lysdiodens index i arrayen.
+********************************************************************************/
+void framebuffer_toggle(framebuffer_t* self,
+                        const uint8_t index);
+
+/********************************************************************************
+* framebuffer_shift: Skiftar bufferten angivet antal steg, där positivt antal
+*                    skiftar mot högre index och negativt mot lägre. Lediga
+*                    positioner släcks, medan lysdioder som skiftas ut ur
+*                    bufferten försvinner.
+*
+*                    - self : Pekare till bufferten.
+*                    - steps: Antalet steg som bufferten ska skiftas.
+********************************************************************************/
+void framebuffer_shift(framebuffer_t* self,
+                       const int8_t steps);
+
+/********************************************************************************
+* framebuffer_rotate: Roterar bufferten angivet antal steg, där positivt
+*                     antal roterar mot högre index och negativt mot lägre.
+*                     Lysdioder som roteras ut i ena änden roteras in i den
+*                     andra.
+*
+*                     - self : Pekare till bufferten.
+*                     - steps: Antalet steg som bufferten ska roteras.
+********************************************************************************/
+void framebuffer_rotate(framebuffer_t* self,
+                        const int8_t steps);
+
+/********************************************************************************
+* framebuffer_mask: Kombinerar bufferten med angiven mask via angiven
+*                   bitoperation. Masken lagras i samma format som
+*                   bufferten, det vill säga bit i % 8 i byte i / 8
+*                   motsvarar lysdiod i.
+*
+*                   - self: Pekare till bufferten.
+*                   - mask: Pekare till masken, FRAMEBUFFER_BYTES byte.
+*                   - op  : Bitoperationen som ska genomföras.
+********************************************************************************/
+void framebuffer_mask(framebuffer_t* self,
+                      const uint8_t* mask,
+                      const enum framebuffer_op op);
+
+/********************************************************************************
+* framebuffer_commit: Visar buffertens bildruta på arrayens lysdioder.
+*                     Samtliga lysdioder på I/O-port B, C och D sätts via en
+*                     skrivning per port, medan övriga lysdioder sätts via
+*                     sitt vtable ifall deras tillstånd har ändrats.
+*                     Lysdiodernas medlem enabled uppdateras. Avbrott är
+*                     inaktiverade under anropet, vilket medför att
+*                     bildrutan inte kan blandas med ändringar från
+*                     avbrottsrutiner. Bufferten lämnas oförändrad.
+*
+*                     - self: Pekare till bufferten som ska visas.
+********************************************************************************/
+void framebuffer_commit(framebuffer_t* self);
+
+#endif /* FRAMEBUFFER_H_ */
@@ -0,0 +1,58 @@
+/********************************************************************************
+* gpio.c: Innehåller tabellen över pinnarna på Arduino Uno samt
+*         funktionsdefinitioner för uppslag i denna.
+********************************************************************************/
+#include "gpio.h"
+
+/********************************************************************************
+* GPIO_PIN: Genererar tabellpost för angiven bit på angiven I/O-port.
+*
+*           - io_port: I/O-porten, exempelvis IO_PORTB.
+*           - x      : Portens bokstav i registernamnen, exempelvis B.
+*           - bit    : Pinnens bitnummer i portregistret.
+********************************************************************************/
+#define GPIO_PIN(io_port, x, bit) { io_port, bit, 1 << (bit), &DDR##x, &PORT##x, &PIN##x }
+
+/********************************************************************************
+* gpio_table: Beskrivning av samtliga pinnar, indexerad med pin-numret.
+********************************************************************************/
+const gpio_t gpio_table[GPIO_NUM_PINS] PROGMEM =
+{
+   GPIO_PIN(IO_PORTD, D, 0), GPIO_PIN(IO_PORTD, D, 1), /* Pin 0 - 1 (D0 - D1). */
+   GPIO_PIN(IO_PORTD, D, 2), GPIO_PIN(IO_PORTD, D, 3), /* Pin 2 - 3 (D2 - D3). */
+   GPIO_PIN(IO_PORTD, D, 4), GPIO_PIN(IO_PORTD, D, 5), /* Pin 4 - 5 (D4 - D5). */
+   GPIO_PIN(IO_PORTD, D, 6), GPIO_PIN(IO_PORTD, D, 7), /* Pin 6 - 7 (D6 - D7). */
+   GPIO_PIN(IO_PORTB, B, 0), GPIO_PIN(IO_PORTB, B, 1), /* Pin 8 - 9 (B0 - B1). */
+   GPIO_PIN(IO_PORTB, B, 2), GPIO_PIN(IO_PORTB, B, 3), /* Pin 10 - 11 (B2 - B3). */
+   GPIO_PIN(IO_PORTB, B, 4), GPIO_PIN(IO_PORTB, B, 5), /* Pin 12 - 13 (B4 - B5). */
+   GPIO_PIN(IO_PORTC, C, 0), GPIO_PIN(IO_PORTC, C, 1), /* Pin A0 - A1 (C0 - C1). */
+   GPIO_PIN(IO_PORTC, C, 2), GPIO_PIN(IO_PORTC, C, 3), /* Pin A2 - A3 (C2 - C3). */
+   GPIO_PIN(IO_PORTC, C, 4), GPIO_PIN(IO_PORTC, C, 5)  /* Pin A4 - A5 (C4 - C5). */
+};
+
+/********************************************************************************
+* gpio_load: Kopierar beskrivningen av angiven pin från programminnet.
+*            Ifall pin-numret är ogiltigt sätts I/O-porten till
+*            IO_PORT_NONE, bitmasken till noll samt registerpekarna till
+*            nullpekare, varefter false returneras. Annars returneras true.
+*
+*            - self: Pekare till strukten där beskrivningen ska lagras.
+*            - pin : Pin-numret på Arduino Uno, alternativt D0 - C5.
+********************************************************************************/
+bool gpio_load(gpio_t* self,
+               const uint8_t pin)
+{
+   if (!gpio_is_valid(pin))
+   {
+      self->io_port = IO_PORT_NONE;
+      self->pin = 0;
+      self->mask = 0;
+      self->ddr = 0;
+      self->port = 0;
+      self->pin_reg = 0;
+      return false;
+   }
+
+   memcpy_P(self, &gpio_table[pin], sizeof(gpio_t));
+   return true;
+}
@@ -0,0 +1,82 @@
+/********************************************************************************
+* gpio.h: Innehåller en gemensam tabell i programminnet över pinnarna på
+*         Arduino Uno, där varje pin-nummer 0 - 19 (alternativt D0 - C5)
+*         avbildas på sin I/O-port, sitt bitnummer, sin bitmask samt sina
+*         register DDRx, PORTx och PINx. Tabellen används vid initiering av
+*         lysdioder, tryckknappar och lysdiodmatriser, så att pin-numret
+*         avkodas via ett enda tabelluppslag i stället för jämförelser och
+*         skiftningar.
+*
+*         Konstanta pin-nummer kontrolleras dessutom vid kompilering via
+*         gpio_check, som används av led_init, led_new, button_init samt
+*         button_new. Därmed avbryts kompileringen vid exempelvis
+*         led_new(20), i stället för att lysdioden tyst kopplas bort under
+*         körning. Pin-nummer som väljs under körning kontrolleras av
+*         gpio_load.
+********************************************************************************/
+#ifndef GPIO_H_
+#define GPIO_H_
+
+/* Inkluderingsdirektiv: */
+#include <avr/pgmspace.h>
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#define GPIO_NUM_PINS 20 /* Antalet pinnar i tabellen, pin 0 - 19 (D0 - C5). */
+
+/********************************************************************************
+* gpio: Strukt innehållande beskrivning av en pin, det vill säga dess
+*       I/O-port, bitnummer, bitmask samt pekare till dess register.
+********************************************************************************/
+typedef struct gpio
+{
+   enum io_port io_port;      /* I/O-port som pinnen tillhör. */
+   uint8_t pin;               /* Pinnens bitnummer i portregistret. */
+   uint8_t mask;              /* Bitmask för pinnen i portregistret. */
+   volatile uint8_t* ddr;     /* Pekare till riktningsregistret DDRx. */
+   volatile uint8_t* port;    /* Pekare till portregistret PORTx. */
+   volatile uint8_t* pin_reg; /* Pekare till pinregistret PINx. */
+} gpio_t;
+
+/* Externa variabler: */
+extern const gpio_t gpio_table[GPIO_NUM_PINS] PROGMEM; /* Beskrivning av samtliga pinnar. */
+
+/********************************************************************************
+* gpio_is_valid: Indikerar ifall angivet pin-nummer finns i tabellen.
+*
+*                - pin: Pin-numret på Arduino Uno, alternativt D0 - C5.
+********************************************************************************/
+#define gpio_is_valid(pin) ((uint8_t)(pin) < GPIO_NUM_PINS)
+
+/********************************************************************************
+* gpio_invalid_pin: Deklareras men definieras aldrig. Ett anrop som kvarstår
+*                   efter optimering avbryter kompileringen med angivet
+*                   felmeddelande, se gpio_check.
+********************************************************************************/
+void gpio_invalid_pin(void) __attribute__((error("ogiltigt pin-nummer, giltiga pinnar: 0 - 19 (D0 - C5)")));
+
+/********************************************************************************
+* gpio_check: Avbryter kompileringen ifall angivet pin-nummer är en konstant
+*             utanför tabellen. Villkoret beräknas vid kompilering, så att
+*             anropet av gpio_invalid_pin tas bort för giltiga samt icke
+*             konstanta pin-nummer. Därmed genereras ingen kod.
+*
+*             - pin: Pin-numret på Arduino Uno, alternativt D0 - C5.
+********************************************************************************/
+#define gpio_check(pin) ({ \
+   if (__builtin_constant_p(pin) && !gpio_is_valid(pin)) gpio_invalid_pin(); \
+})
+
+/********************************************************************************
+* gpio_load: Kopierar beskrivningen av angiven pin från programminnet.
+*            Ifall pin-numret är ogiltigt sätts I/O-porten till
+*            IO_PORT_NONE, bitmasken till noll samt registerpekarna till
+*            nullpekare, varefter false returneras. Annars returneras true.
+*
+*            - self: Pekare till strukten där beskrivningen ska lagras.
+*            - pin : Pin-numret på Arduino Uno, alternativt D0 - C5.
+********************************************************************************/
+bool gpio_load(gpio_t* self,
+               const uint8_t pin);
+
+#endif /* GPIO_H_ */
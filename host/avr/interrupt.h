@@ -0,0 +1,17 @@
+/********************************************************************************
+* avr/interrupt.h: Ersättning för avr-libc:s avr/interrupt.h vid kompilering
+*                  för värddatorn. Avbrottsrutiner blir vanliga funktioner,
+*                  som anropas av simulatorn i sim.c. Global aktivering av
+*                  avbrott sker via I-flaggan i det simulerade statusregistret.
+********************************************************************************/
+#ifndef SIM_AVR_INTERRUPT_H_
+#define SIM_AVR_INTERRUPT_H_
+
+/* Inkluderingsdirektiv: */
+#include "avr/io.h"
+
+#define ISR(vector) void vector(void)
+#define sei() (SREG |= 0x80)
+#define cli() (SREG &= ~0x80)
+
+#endif /* SIM_AVR_INTERRUPT_H_ */
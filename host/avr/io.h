@@ -0,0 +1,164 @@
+/********************************************************************************
+* avr/io.h: Ersättning för avr-libc:s avr/io.h vid kompilering för värddatorn
+*           (Linux). Registren för ATmega328P placeras på samma adresser som i
+*           mikrodatorns dataminne, förskjutna med SIM_IO_BASE, där
+*           simulatorn i sim.c mappar en minnessida. Därmed kan simulatorn
+*           registrera samtliga skrivningar till registren.
+********************************************************************************/
+#ifndef SIM_AVR_IO_H_
+#define SIM_AVR_IO_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+
+/* Makrodefinitioner för registrens placering: */
+#define SIM_IO_BASE 0x20000000UL /* Adress för simulatorns minnessida. */
+#define SIM_IO_SIZE 0x100        /* Storleken på simulerat I/O-område. */
+#define _SFR_MEM8(addr) (*(volatile uint8_t*)(SIM_IO_BASE + (addr)))
+#define _SFR_MEM16(addr) (*(volatile uint16_t*)(SIM_IO_BASE + (addr)))
+
+/* I/O-portar: */
+#define PINB _SFR_MEM8(0x23)
+#define DDRB _SFR_MEM8(0x24)
+#define PORTB _SFR_MEM8(0x25)
+#define PINC _SFR_MEM8(0x26)
+#define DDRC _SFR_MEM8(0x27)
+#define PORTC _SFR_MEM8(0x28)
+#define PIND _SFR_MEM8(0x29)
+#define DDRD _SFR_MEM8(0x2A)
+#define PORTD _SFR_MEM8(0x2B)
+
+/* Generella register: */
+#define GPIOR0 _SFR_MEM8(0x3E)
+#define GPIOR1 _SFR_MEM8(0x4A)
+#define GPIOR2 _SFR_MEM8(0x4B)
+
+/* Avbrottsflaggor: */
+#define TIFR0 _SFR_MEM8(0x35)
+#define TIFR1 _SFR_MEM8(0x36)
+#define TIFR2 _SFR_MEM8(0x37)
+#define PCIFR _SFR_MEM8(0x3B)
+
+/* Timer 0: */
+#define TCCR0A _SFR_MEM8(0x44)
+#define TCCR0B _SFR_MEM8(0x45)
+#define TCNT0 _SFR_MEM8(0x46)
+#define OCR0A _SFR_MEM8(0x47)
+#define OCR0B _SFR_MEM8(0x48)
+
+/* SPI: */
+#define SPCR _SFR_MEM8(0x4C)
+#define SPSR _SFR_MEM8(0x4D)
+#define SPDR _SFR_MEM8(0x4E)
+
+/* Systemregister: */
+#define ACSR _SFR_MEM8(0x50)
+#define SMCR _SFR_MEM8(0x53)
+#define MCUCR _SFR_MEM8(0x55)
+#define SPL _SFR_MEM8(0x5D)
+#define SPH _SFR_MEM8(0x5E)
+#define SREG _SFR_MEM8(0x5F)
+#define PRR _SFR_MEM8(0x64)
+
+/* PCI-avbrott: */
+#define PCICR _SFR_MEM8(0x68)
+#define PCMSK0 _SFR_MEM8(0x6B)
+#define PCMSK1 _SFR_MEM8(0x6C)
+#define PCMSK2 _SFR_MEM8(0x6D)
+
+/* Avbrottsmasker för timerkretsar: */
+#define TIMSK0 _SFR_MEM8(0x6E)
+#define TIMSK1 _SFR_MEM8(0x6F)
+#define TIMSK2 _SFR_MEM8(0x70)
+
+/* AD-omvandlare: */
+#define ADCSRA _SFR_MEM8(0x7A)
+
+/* Timer 1: */
+#define TCCR1A _SFR_MEM8(0x80)
+#define TCCR1B _SFR_MEM8(0x81)
+#define TCCR1C _SFR_MEM8(0x82)
+#define TCNT1 _SFR_MEM16(0x84)
+#define ICR1 _SFR_MEM16(0x86)
+#define OCR1A _SFR_MEM16(0x88)
+#define OCR1B _SFR_MEM16(0x8A)
+
+/* Timer 2: */
+#define TCCR2A _SFR_MEM8(0xB0)
+#define TCCR2B _SFR_MEM8(0xB1)
+#define TCNT2 _SFR_MEM8(0xB2)
+#define OCR2A _SFR_MEM8(0xB3)
+#define OCR2B _SFR_MEM8(0xB4)
+
+/* USART 0: */
+#define UCSR0A _SFR_MEM8(0xC0)
+#define UCSR0B _SFR_MEM8(0xC1)
+#define UCSR0C _SFR_MEM8(0xC2)
+#define UBRR0 _SFR_MEM16(0xC4)
+#define UDR0 _SFR_MEM8(0xC6)
+
+/* Bitnummer: */
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM01 1
+#define OCIE0A 1
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define ICES1 6
+#define ICNC1 7
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM21 1
+#define OCIE2A 1
+#define SPR0 0
+#define SPR1 1
+#define MSTR 4
+#define SPE 6
+#define SPIE 7
+#define SPI2X 0
+#define SPIF 7
+#define U2X0 1
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCSZ00 1
+#define UCSZ01 2
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define ACD 7
+#define ADEN 7
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+
+/* Minnesdisposition: */
+#define RAMSTART 0x100
+#define RAMEND 0x8FF
+
+#endif /* SIM_AVR_IO_H_ */
@@ -0,0 +1,20 @@
+/********************************************************************************
+* avr/pgmspace.h: Ersättning för avr-libc:s avr/pgmspace.h vid kompilering för
+*                 värddatorn, där programminnet och dataminnet är gemensamt.
+********************************************************************************/
+#ifndef SIM_AVR_PGMSPACE_H_
+#define SIM_AVR_PGMSPACE_H_
+
+/* Inkluderingsdirektiv: */
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_ptr(addr) (*(void* const*)(addr))
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+
+#endif /* SIM_AVR_PGMSPACE_H_ */
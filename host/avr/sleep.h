@@ -0,0 +1,27 @@
+/********************************************************************************
+* avr/sleep.h: Ersättning för avr-libc:s avr/sleep.h vid kompilering för
+*              värddatorn. Val av viloläge sker via det simulerade registret
+*              SMCR, medan instruktionen sleep ersätts av en räknare i
+*              simulatorn, se sim_sleeps.
+********************************************************************************/
+#ifndef SIM_AVR_SLEEP_H_
+#define SIM_AVR_SLEEP_H_
+
+/* Inkluderingsdirektiv: */
+#include "avr/io.h"
+
+extern unsigned long sim_sleep_total; /* Antalet genomförda vilolägen. */
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (1 << SM1)
+#define SLEEP_MODE_PWR_SAVE ((1 << SM1) | (1 << SM0))
+#define SLEEP_MODE_STANDBY ((1 << SM2) | (1 << SM1))
+
+#define set_sleep_mode(mode) \
+   (SMCR = (SMCR & ~((1 << SM2) | (1 << SM1) | (1 << SM0))) | (mode))
+#define sleep_enable() (SMCR |= (1 << SE))
+#define sleep_disable() (SMCR &= ~(1 << SE))
+#define sleep_cpu() (sim_sleep_total += (SMCR & (1 << SE)) ? 1 : 0)
+
+#endif /* SIM_AVR_SLEEP_H_ */
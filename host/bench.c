@@ -0,0 +1,300 @@
+/********************************************************************************
+* bench.c: Prestandamätningar av drivrutinerna på värddatorn, avsedda att
+*          upptäcka algoritmiska regressioner snarare än att mäta exakt
+*          exekveringstid på mikrodatorn. Varje mätning körs för ett
+*          ökande antal lysdioder respektive operationer, varefter tid per
+*          operation skrivs ut. Ifall tiden per operation för största
+*          storleken överstiger BENCH_MAX_GROWTH gånger tiden för minsta
+*          storleken, exempelvis då en operation med konstant amorterad
+*          tidskomplexitet blivit linjär, returneras felkod 1.
+*
+*          Spårning av registerskrivningar är inaktiverad under mätningarna.
+*          Körs via kommandot make bench i katalogen host.
+********************************************************************************/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+#include "../led.h"
+#include "../led_array.h"
+#include "../button.h"
+#include "../button_group.h"
+#include "../event_queue.h"
+#include "../pool.h"
+
+/* Makrodefinitioner: */
+#define BENCH_MIN_SIZE 1000UL    /* Minsta antal lysdioder/operationer. */
+#define BENCH_MAX_SIZE 1000000UL /* Största antal lysdioder/operationer. */
+#define BENCH_MAX_GROWTH 8.0     /* Högsta tillåtna ökning av tid per operation. */
+#define BENCH_POP_COUNT 100      /* Antal borttagningar vid mätning av pop. */
+
+/********************************************************************************
+* bench_t: Strukt för en prestandamätning.
+*
+*          - name: Mätningens namn.
+*          - run : Funktion som kör mätningen för angivet antal och
+*                  returnerar förfluten tid i nanosekunder.
+********************************************************************************/
+typedef struct
+{
+   const char* name;
+   double (*run)(const size_t n);
+} bench_t;
+
+/* Statiska variabler: */
+static led_t* bench_leds;            /* Lysdioder som används av mätningarna. */
+static volatile uintptr_t bench_sink; /* Förhindrar bortoptimering av resultat. */
+
+/********************************************************************************
+* bench_now_ns: Returnerar aktuell monoton tid i nanosekunder.
+********************************************************************************/
+static double bench_now_ns(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/********************************************************************************
+* bench_array_fill: Initierar angiven led-array med n lysdioder.
+********************************************************************************/
+static void bench_array_fill(led_array_t* leds, const size_t n)
+{
+   size_t i;
+   led_array_init(leds);
+   for (i = 0; i < n; ++i)
+   {
+      led_array_push(leds, &bench_leds[i]);
+   }
+   return;
+}
+
+/********************************************************************************
+* bench_array_push: Mäter tillägg av n lysdioder i en dynamisk led-array.
+********************************************************************************/
+static double bench_array_push(const size_t n)
+{
+   led_array_t leds;
+   const double start = bench_now_ns();
+   bench_array_fill(&leds, n);
+   bench_sink = leds.size;
+   led_array_clear(&leds);
+   return bench_now_ns() - start;
+}
+
+/********************************************************************************
+* bench_array_pop: Mäter borttagning av lysdioder ur en led-array med n
+*                  lysdioder. Eftersom portmasken beräknas om vid varje
+*                  borttagning är tiden linjär mot arrayens storlek. Därför
+*                  tas BENCH_POP_COUNT lysdioder bort, varefter tiden per
+*                  borttagning returneras, vilket motsvarar tid per lysdiod
+*                  i arrayen efter division med n.
+********************************************************************************/
+static double bench_array_pop(const size_t n)
+{
+   led_array_t leds;
+   double start;
+   size_t i;
+   bench_array_fill(&leds, n);
+   start = bench_now_ns();
+   for (i = 0; i < BENCH_POP_COUNT; ++i)
+   {
+      led_array_pop(&leds);
+      bench_sink = leds.mask.portb;
+   }
+   start = (bench_now_ns() - start) / BENCH_POP_COUNT;
+   led_array_clear(&leds);
+   return start;
+}
+
+/********************************************************************************
+* bench_array_on_off: Mäter tändning och släckning av n lysdioder en och en
+*                     via vtable.
+********************************************************************************/
+static double bench_array_on_off(const size_t n)
+{
+   led_array_t leds;
+   double start;
+   bench_array_fill(&leds, n);
+   start = bench_now_ns();
+   led_array_on(&leds);
+   led_array_off(&leds);
+   start = (bench_now_ns() - start) / 2;
+   led_array_clear(&leds);
+   return start;
+}
+
+/********************************************************************************
+* bench_mask_update: Mäter omberäkning av portmasken för n lysdioder.
+********************************************************************************/
+static double bench_mask_update(const size_t n)
+{
+   led_array_t leds;
+   double start;
+   bench_array_fill(&leds, n);
+   start = bench_now_ns();
+   led_array_mask_update(&leds.mask, leds.leds, leds.size);
+   start = bench_now_ns() - start;
+   bench_sink = leds.mask.portb;
+   led_array_clear(&leds);
+   return start;
+}
+
+/********************************************************************************
+* bench_mask_toggle: Mäter n togglingar av lysdioder via portmasken.
+********************************************************************************/
+static double bench_mask_toggle(const size_t n)
+{
+   led_array_mask_t mask = { 0xFF, 0x3F, 0xFF };
+   const double start = bench_now_ns();
+   size_t i;
+   for (i = 0; i < n; ++i)
+   {
+      led_array_mask_toggle(&mask);
+   }
+   return bench_now_ns() - start;
+}
+
+/********************************************************************************
+* bench_pool: Mäter n allokeringar och frigöranden från en objektpool.
+********************************************************************************/
+static double bench_pool(const size_t n)
+{
+   static led_t storage[64];
+   static pool_t pool = POOL_INIT(storage);
+   void* objects[64];
+   const double start = bench_now_ns();
+   size_t i, j;
+
+   for (i = 0; i < n; i += 64)
+   {
+      for (j = 0; j < 64; ++j) objects[j] = pool_alloc(&pool);
+      for (j = 0; j < 64; ++j) pool_free(&pool, objects[j]);
+   }
+   return bench_now_ns() - start;
+}
+
+/********************************************************************************
+* bench_led_new: Mäter n anrop av led_new samt led_delete.
+********************************************************************************/
+static double bench_led_new(const size_t n)
+{
+   const double start = bench_now_ns();
+   size_t i;
+   for (i = 0; i < n; ++i)
+   {
+      led_t* led = led_new((uint8_t)(i % 20));
+      bench_sink = (uintptr_t)led;
+      led_delete(&led);
+   }
+   return bench_now_ns() - start;
+}
+
+/********************************************************************************
+* bench_button_group: Mäter n avläsningar av en grupp med tryckknappar.
+********************************************************************************/
+static double bench_button_group(const size_t n)
+{
+   button_group_t group;
+   button_group_t pressed;
+   button_t buttons[4];
+   const uint8_t pins[] = { 2, 11, 12, 13 };
+   double start;
+   size_t i;
+
+   button_group_init(&group);
+   for (i = 0; i < 4; ++i)
+   {
+      button_init(&buttons[i], pins[i]);
+      button_group_add(&group, &buttons[i]);
+   }
+
+   start = bench_now_ns();
+   for (i = 0; i < n; ++i)
+   {
+      bench_sink = button_group_read(&group, &pressed);
+   }
+   start = bench_now_ns() - start;
+
+   for (i = 0; i < 4; ++i) button_clear(&buttons[i]);
+   return start;
+}
+
+/********************************************************************************
+* bench_event_queue: Mäter n tillägg och uttag ur eventkön.
+********************************************************************************/
+static double bench_event_queue(const size_t n)
+{
+   event_t event;
+   const double start = bench_now_ns();
+   size_t i;
+   for (i = 0; i < n; ++i)
+   {
+      event_queue_push(EVENT_USER, (uint8_t)i, (uint16_t)i);
+      event_queue_pop(&event);
+   }
+   bench_sink = event.data;
+   return bench_now_ns() - start;
+}
+
+/* Samtliga mätningar: */
+static const bench_t bench_table[] =
+{
+   { "led_array_push", bench_array_push },
+   { "led_array_pop [/led]", bench_array_pop },
+   { "led_array_on/off", bench_array_on_off },
+   { "led_array_mask_update", bench_mask_update },
+   { "led_array_mask_toggle", bench_mask_toggle },
+   { "pool_alloc/free", bench_pool },
+   { "led_new/delete", bench_led_new },
+   { "button_group_read", bench_button_group },
+   { "event_queue_push/pop", bench_event_queue },
+};
+
+/********************************************************************************
+* main: Kör samtliga mätningar och skriver ut tid per operation. Returnerar
+*       1 ifall någon mätning visar en regression, annars 0.
+********************************************************************************/
+int main(void)
+{
+   const size_t num_benches = sizeof(bench_table) / sizeof(bench_table[0]);
+   int regressions = 0;
+   size_t i, n;
+
+   sim_reset();
+   sim_trace(false);
+   bench_leds = malloc(BENCH_MAX_SIZE * sizeof(led_t));
+   if (!bench_leds) return 1;
+
+   for (n = 0; n < BENCH_MAX_SIZE; ++n)
+   {
+      led_init(&bench_leds[n], (uint8_t)(n % 20));
+   }
+
+   printf("%-24s", "benchmark [ns/op]");
+   for (n = BENCH_MIN_SIZE; n <= BENCH_MAX_SIZE; n *= 10) printf("%12lu", (unsigned long)n);
+   printf("\n");
+
+   for (i = 0; i < num_benches; ++i)
+   {
+      double first = 0, last = 0;
+      printf("%-24s", bench_table[i].name);
+
+      for (n = BENCH_MIN_SIZE; n <= BENCH_MAX_SIZE; n *= 10)
+      {
+         last = bench_table[i].run(n) / n;
+         if (n == BENCH_MIN_SIZE) first = last;
+         printf("%12.2f", last);
+      }
+
+      if (last > first * BENCH_MAX_GROWTH && last - first > 10.0)
+      {
+         printf("  REGRESSION");
+         regressions++;
+      }
+      printf("\n");
+   }
+
+   free(bench_leds);
+   return regressions ? 1 : 0;
+}
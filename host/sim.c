@@ -0,0 +1,470 @@
+/********************************************************************************
+* sim.c: Implementering av simulatorn för körning av drivrutinerna på en
+*        värddator. Registren ligger i en minnessida på adressen SIM_IO_BASE,
+*        som normalt enbart är läsbar. En skrivning orsakar därmed signalen
+*        SIGSEGV, varvid sidan tillfälligt görs skrivbar och processorn
+*        ställs i stegläge (trap flag). Efter att skrivinstruktionen har
+*        genomförts erhålls signalen SIGTRAP, varvid skrivningen loggas,
+*        hårdvarans sidoeffekter emuleras och sidan åter skrivskyddas.
+********************************************************************************/
+#define _GNU_SOURCE
+
+/* Inkluderingsdirektiv (systemets bibliotek före sim.h, som definierar read): */
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include "sim.h"
+#include "../timer.h"
+
+/* Makrodefinitioner: */
+#define SIM_PAGE_SIZE 4096   /* Storleken på simulatorns minnessida. */
+#define SIM_TRAP_FLAG 0x100 /* Trap flag i processorns flaggregister. */
+
+/* Avbrottsrutiner, som enbart anropas ifall de är definierade: */
+void PCINT0_vect(void) __attribute__((weak));
+void PCINT1_vect(void) __attribute__((weak));
+void PCINT2_vect(void) __attribute__((weak));
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void TIMER1_CAPT_vect(void) __attribute__((weak));
+void USART_UDRE_vect(void) __attribute__((weak));
+
+/* Globala variabler: */
+unsigned long sim_delay_total_us = 0;
+unsigned long sim_sleep_total = 0;
+
+/* Statiska variabler: */
+static uint8_t* const sim_io = (uint8_t*)SIM_IO_BASE;
+static bool sim_tracing = false;
+static uint8_t sim_inputs[3];
+static uint8_t sim_snapshot[SIM_IO_SIZE];
+static uint16_t sim_fault_addr;
+static sim_write_t sim_log[SIM_LOG_SIZE];
+static size_t sim_log_count = 0;
+static uint8_t sim_uart[SIM_UART_SIZE];
+static size_t sim_uart_count = 0;
+static uint8_t sim_spi[SIM_SPI_SIZE];
+static size_t sim_spi_count = 0;
+
+/* Statiska funktioner: */
+static void sim_protect(const bool writable);
+static void sim_update_inputs(void);
+static void sim_on_write(const uint16_t addr, const uint8_t old_value);
+static void sim_segv_handler(int signal, siginfo_t* info, void* context);
+static void sim_trap_handler(int signal, siginfo_t* info, void* context);
+static void sim_init(void) __attribute__((constructor));
+
+/********************************************************************************
+* sim_reset: Nollställer samtliga register, insignaler, loggen samt summerad
+*            fördröjningstid. Spårning av registerskrivningar aktiveras.
+********************************************************************************/
+void sim_reset(void)
+{
+   sim_protect(true);
+   memset(sim_io, 0, SIM_IO_SIZE);
+   memset(sim_inputs, 0, sizeof(sim_inputs));
+   sim_log_count = 0;
+   sim_uart_count = 0;
+   sim_spi_count = 0;
+   sim_delay_total_us = 0;
+   sim_sleep_total = 0;
+   set(UCSR0A, UDRE0);
+   sim_trace(true);
+   return;
+}
+
+/********************************************************************************
+* sim_timer_restore: Återställer systemtimerns registertillstånd efter
+*                    sim_reset och aktiverar avbrott globalt.
+********************************************************************************/
+void sim_timer_restore(void)
+{
+   timer_init();
+   TCCR1A = 0;
+   TCNT1 = 0;
+   OCR1A = TIMER_TICKS_PER_MS - 1;
+   TCCR1B = (1 << WGM12) | (1 << CS11);
+   set(TIMSK1, OCIE1A);
+   sei();
+   return;
+}
+
+/********************************************************************************
+* sim_trace: Aktiverar eller inaktiverar spårning av registerskrivningar.
+*
+*            - enable: Indikerar ifall spårning ska aktiveras.
+********************************************************************************/
+void sim_trace(const bool enable)
+{
+#if defined(__x86_64__)
+   sim_tracing = enable;
+#else
+   sim_tracing = false;
+   (void)enable;
+#endif
+   sim_protect(!sim_tracing);
+   return;
+}
+
+/********************************************************************************
+* sim_set_input: Sätter nivån på en inport och genererar PCI-avbrott vid
+*                ändrad nivå ifall avbrott är aktiverat för aktuell pin.
+*
+*                - pin  : Aktuellt PIN-nummer (0 - 19).
+*                - level: Ny nivå (1 = hög, 0 = låg).
+********************************************************************************/
+void sim_set_input(const uint8_t pin, const bool level)
+{
+   const uint8_t port = &pin_portx(pin) == &PORTB ? 0 : &pin_portx(pin) == &PORTC ? 1 : 2;
+   const uint8_t mask = pin_mask(pin);
+   const uint8_t old_inputs = sim_inputs[port];
+   const uint8_t pcmsk = port == 0 ? PCMSK0 : port == 1 ? PCMSK1 : PCMSK2;
+   if (pin > 19) return;
+
+   if (level) sim_inputs[port] |= mask;
+   else sim_inputs[port] &= ~mask;
+
+   sim_protect(true);
+   sim_update_inputs();
+   sim_protect(!sim_tracing);
+
+   if ((old_inputs ^ sim_inputs[port]) & mask & pcmsk &&
+       read(PCICR, port) && read(SREG, 7))
+   {
+      void (*isr)(void) = port == 0 ? PCINT0_vect : port == 1 ? PCINT1_vect : PCINT2_vect;
+      if (isr) isr();
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_capture: Sätter nivån på ICP1 (pin 8) via sim_set_input. Ifall nivån
+*              ändras i den riktning som ICES1 anger låses angivet
+*              räknarvärde i ICR1 och ICF1 ettställs, varefter
+*              avbrottsrutinen anropas ifall infångningsavbrott är
+*              aktiverat samt avbrott är aktiverat globalt.
+*
+*              - ticks: Timer 1:s räknarvärde vid flanken.
+*              - level: Ny nivå (1 = hög, 0 = låg).
+********************************************************************************/
+void sim_capture(const uint16_t ticks, const bool level)
+{
+   const bool old_level = read(sim_inputs[0], 0);
+   sim_set_input(8, level);
+   if (level == old_level || level != (read(TCCR1B, ICES1) ? true : false)) return;
+
+   sim_protect(true);
+   ICR1 = ticks;
+   set(TIFR1, ICF1);
+   sim_protect(!sim_tracing);
+
+   if (read(TIMSK1, ICIE1) && read(SREG, 7) && TIMER1_CAPT_vect)
+   {
+      TIMER1_CAPT_vect();
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_tick_ms: Stegar fram Timer 1 angivet antal millisekunder och anropar
+*              avbrottsrutinen för Timer 1 en gång per millisekund ifall
+*              avbrottet är aktiverat.
+*
+*              - ms: Antal millisekunder som ska stegas fram.
+********************************************************************************/
+void sim_tick_ms(uint32_t ms)
+{
+   while (ms--)
+   {
+      if (read(TIMSK1, OCIE1A) && read(SREG, 7) && TIMER1_COMPA_vect)
+      {
+         TIMER1_COMPA_vect();
+      }
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_uart_drain: Anropar avbrottsrutinen för tomt dataregister på USART0 så
+*                 länge avbrottet är aktiverat. Antalet anrop begränsas, så
+*                 att en avbrottsrutin som aldrig inaktiverar avbrottet inte
+*                 medför en oändlig loop. När avbrottet har inaktiverats
+*                 ettställs TXC0, vilket motsvarar att sista byten har
+*                 skickats färdigt.
+********************************************************************************/
+void sim_uart_drain(void)
+{
+   size_t i;
+   for (i = 0; i < SIM_UART_SIZE && USART_UDRE_vect; ++i)
+   {
+      if (!read(UCSR0B, UDRIE0) || !read(SREG, 7)) break;
+      USART_UDRE_vect();
+   }
+
+   if (!read(UCSR0B, UDRIE0))
+   {
+      sim_protect(true);
+      set(UCSR0A, TXC0);
+      sim_protect(!sim_tracing);
+   }
+   return;
+}
+
+/********************************************************************************
+* sim_uart_read: Kopierar byte som har skickats via USART0 sedan föregående
+*                anrop och returnerar antalet kopierade byte.
+*
+*                - data: Buffert där byten ska lagras.
+*                - max : Maximalt antal byte som ska kopieras.
+********************************************************************************/
+size_t sim_uart_read(uint8_t* data,
+                     const size_t max)
+{
+   const size_t count = sim_uart_count < max ? sim_uart_count : max;
+   memcpy(data, sim_uart, count);
+   memmove(sim_uart, sim_uart + count, sim_uart_count - count);
+   sim_uart_count -= count;
+   return count;
+}
+
+/********************************************************************************
+* sim_spi_read: Kopierar byte som har skickats via SPI-enheten sedan
+*               föregående anrop och returnerar antalet kopierade byte.
+*
+*               - data: Buffert där byten ska lagras.
+*               - max : Maximalt antal byte som ska kopieras.
+********************************************************************************/
+size_t sim_spi_read(uint8_t* data,
+                    const size_t max)
+{
+   const size_t count = sim_spi_count < max ? sim_spi_count : max;
+   memcpy(data, sim_spi, count);
+   memmove(sim_spi, sim_spi + count, sim_spi_count - count);
+   sim_spi_count -= count;
+   return count;
+}
+
+/********************************************************************************
+* sim_sleeps: Returnerar antalet genomförda vilolägen sedan simulatorn senast
+*             nollställdes.
+********************************************************************************/
+unsigned long sim_sleeps(void)
+{
+   return sim_sleep_total;
+}
+
+/********************************************************************************
+* sim_writes: Returnerar adressen till loggen med registerskrivningar.
+*
+*             - count: Pekare till variabel där antalet loggade skrivningar
+*                      lagras.
+********************************************************************************/
+const sim_write_t* sim_writes(size_t* count)
+{
+   *count = sim_log_count;
+   return sim_log;
+}
+
+/********************************************************************************
+* sim_count_writes: Returnerar antalet loggade skrivningar till angivet
+*                   register sedan loggen senast tömdes.
+*
+*                   - addr: Registrets adress, lämpligen via SIM_REG.
+********************************************************************************/
+size_t sim_count_writes(const uint16_t addr)
+{
+   size_t count = 0;
+   size_t i;
+
+   for (i = 0; i < sim_log_count; ++i)
+   {
+      if (sim_log[i].addr == addr) count++;
+   }
+   return count;
+}
+
+/********************************************************************************
+* sim_clear_log: Tömmer loggen med registerskrivningar.
+********************************************************************************/
+void sim_clear_log(void)
+{
+   sim_log_count = 0;
+   return;
+}
+
+/********************************************************************************
+* sim_delay_us: Returnerar summerad fördröjningstid i mikrosekunder.
+********************************************************************************/
+unsigned long sim_delay_us(void)
+{
+   return sim_delay_total_us;
+}
+
+/********************************************************************************
+* sim_protect: Gör simulatorns minnessida skrivbar eller skrivskyddad.
+*
+*              - writable: Indikerar ifall minnessidan ska vara skrivbar.
+********************************************************************************/
+static void sim_protect(const bool writable)
+{
+   mprotect(sim_io, SIM_PAGE_SIZE, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+   return;
+}
+
+/********************************************************************************
+* sim_update_inputs: Uppdaterar PIN-registren utifrån insignalerna. Liksom
+*                    på hårdvaran avspeglar PINx utsignalen för pinnar som
+*                    är satta till utportar. Minnessidan måste vara skrivbar.
+********************************************************************************/
+static void sim_update_inputs(void)
+{
+   PINB = (PORTB & DDRB) | (sim_inputs[0] & ~DDRB);
+   PINC = (PORTC & DDRC) | (sim_inputs[1] & ~DDRC);
+   PIND = (PORTD & DDRD) | (sim_inputs[2] & ~DDRD);
+   return;
+}
+
+/********************************************************************************
+* sim_on_write: Loggar en genomförd skrivning och emulerar hårdvarans
+*               sidoeffekter. En etta skriven till PINx togglar motsvarande
+*               bit i PORTx. En etta skriven till TXC0 nollställer flaggan,
+*               liksom ettor skrivna till flaggorna i TIFR1.
+*               Byte skrivna till UDR0 fångas upp som skickade via USART0.
+*               Byte skrivna till SPDR fångas upp som skickade via
+*               SPI-enheten, varvid SPIF ettställs direkt. Minnessidan
+*               måste vara skrivbar.
+*
+*               - addr     : Adressen till registret som skrevs.
+*               - old_value: Registrets värde före skrivningen.
+********************************************************************************/
+static void sim_on_write(const uint16_t addr, const uint8_t old_value)
+{
+   const uint8_t value = sim_io[addr];
+
+   if (sim_log_count < SIM_LOG_SIZE)
+   {
+      sim_log[sim_log_count].addr = addr;
+      sim_log[sim_log_count].value = value;
+      sim_log_count++;
+   }
+
+   if (addr == SIM_REG(PINB) || addr == SIM_REG(PINC) || addr == SIM_REG(PIND))
+   {
+      sim_io[addr + 2] ^= value;
+      sim_io[addr] = old_value;
+   }
+   else if (addr == SIM_REG(UCSR0A))
+   {
+      const uint8_t txc = read(value, TXC0) ? 0 : old_value & (1 << TXC0);
+      sim_io[addr] = (value & ~(1 << TXC0)) | txc;
+   }
+   else if (addr == SIM_REG(TIFR1))
+   {
+      sim_io[addr] = old_value & ~value;
+   }
+   else if (addr == SIM_REG(UDR0) && sim_uart_count < SIM_UART_SIZE)
+   {
+      sim_uart[sim_uart_count++] = value;
+   }
+   else if (addr == SIM_REG(SPDR))
+   {
+      if (sim_spi_count < SIM_SPI_SIZE) sim_spi[sim_spi_count++] = value;
+      set(SPSR, SPIF);
+   }
+
+   sim_update_inputs();
+   return;
+}
+
+/********************************************************************************
+* sim_segv_handler: Anropas vid skrivning till den skrivskyddade minnessidan.
+*                   Sidan görs skrivbar och processorn ställs i stegläge,
+*                   så att skrivinstruktionen genomförs innan
+*                   sim_trap_handler anropas. Minnesfel utanför minnessidan
+*                   hanteras som vanligt.
+********************************************************************************/
+static void sim_segv_handler(int signal, siginfo_t* info, void* context)
+{
+   const uintptr_t addr = (uintptr_t)info->si_addr;
+
+   if (addr < SIM_IO_BASE || addr >= SIM_IO_BASE + SIM_PAGE_SIZE)
+   {
+      struct sigaction action;
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = SIG_DFL;
+      sigaction(signal, &action, 0);
+      return;
+   }
+
+   sim_fault_addr = (uint16_t)(addr - SIM_IO_BASE);
+   memcpy(sim_snapshot, sim_io, SIM_IO_SIZE);
+   sim_protect(true);
+#if defined(__x86_64__)
+   ((ucontext_t*)context)->uc_mcontext.gregs[REG_EFL] |= SIM_TRAP_FLAG;
+#else
+   (void)context;
+#endif
+   return;
+}
+
+/********************************************************************************
+* sim_trap_handler: Anropas efter att en skrivinstruktion till minnessidan
+*                   har genomförts. Samtliga ändrade register loggas, liksom
+*                   registret som orsakade minnesfelet även ifall värdet är
+*                   oförändrat. Ändrade register fastställs innan några
+*                   sidoeffekter emuleras. Därefter skrivskyddas minnessidan.
+********************************************************************************/
+static void sim_trap_handler(int signal, siginfo_t* info, void* context)
+{
+   uint16_t changed[SIM_IO_SIZE];
+   uint16_t num_changed = 0;
+   uint16_t addr, i;
+   (void)signal;
+   (void)info;
+#if defined(__x86_64__)
+   ((ucontext_t*)context)->uc_mcontext.gregs[REG_EFL] &= ~SIM_TRAP_FLAG;
+#else
+   (void)context;
+#endif
+
+   for (addr = 0; addr < SIM_IO_SIZE; ++addr)
+   {
+      if (addr == sim_fault_addr || sim_io[addr] != sim_snapshot[addr])
+      {
+         changed[num_changed++] = addr;
+      }
+   }
+
+   for (i = 0; i < num_changed; ++i)
+   {
+      sim_on_write(changed[i], sim_snapshot[changed[i]]);
+   }
+   sim_protect(false);
+   return;
+}
+
+/********************************************************************************
+* sim_init: Mappar simulatorns minnessida och installerar signalhanterare.
+*           Anropas automatiskt före main.
+********************************************************************************/
+static void sim_init(void)
+{
+   struct sigaction action;
+
+   if (mmap(sim_io, SIM_PAGE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != sim_io)
+   {
+      perror("sim: mmap");
+      exit(1);
+   }
+
+   memset(&action, 0, sizeof(action));
+   action.sa_flags = SA_SIGINFO;
+   action.sa_sigaction = sim_segv_handler;
+   sigaction(SIGSEGV, &action, 0);
+   action.sa_sigaction = sim_trap_handler;
+   sigaction(SIGTRAP, &action, 0);
+   sim_reset();
+   return;
+}
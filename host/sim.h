@@ -0,0 +1,185 @@
+/********************************************************************************
+* sim.h: Simulator för körning av drivrutinerna på en värddator (Linux).
+*        Mikrodatorns register placeras i en skrivskyddad minnessida, se
+*        avr/io.h. Varje skrivning till ett register orsakar därmed ett
+*        minnesfel, som fångas upp av simulatorn. Simulatorn låter
+*        skrivningen genomföras en instruktion i taget och loggar därefter
+*        vilket register som skrevs samt nytt värde. Samtidigt emuleras
+*        hårdvarans beteende, exempelvis att en etta skriven till PINx
+*        togglar motsvarande bit i PORTx.
+*
+*        Insignaler (exempelvis nedtryckta tryckknappar) injiceras via
+*        funktionen sim_set_input, vilket även genererar PCI-avbrott om
+*        dessa är aktiverade. Timer 1 stegas fram via sim_tick_ms. Byte som
+*        skickas via USART0 fångas upp och läses av via sim_uart_read.
+*
+*        Uppfångning av skrivningar kräver x86_64. På andra arkitekturer,
+*        samt då spårningen stängs av via sim_trace (exempelvis vid
+*        prestandamätning), skrivs registren direkt utan loggning. Då
+*        emuleras varken toggling via PINx, nollställning av flaggor via
+*        skrivning av ettor eller uppfångning av byte till UDR0 och SPDR,
+*        varför funktionstesterna i test.c enbart kan byggas för x86_64.
+********************************************************************************/
+#ifndef SIM_H_
+#define SIM_H_
+
+/* Inkluderingsdirektiv: */
+#include "../misc.h"
+#include <stddef.h>
+
+/* Makrodefinitioner: */
+#ifndef SIM_UART_SIZE
+#define SIM_UART_SIZE 1024 /* Maximalt antal uppfångade byte från USART0. */
+#endif
+
+#ifndef SIM_SPI_SIZE
+#define SIM_SPI_SIZE 1024 /* Maximalt antal uppfångade byte från SPI-enheten. */
+#endif
+
+#ifndef SIM_LOG_SIZE
+#define SIM_LOG_SIZE 4096 /* Maximalt antal loggade registerskrivningar. */
+#endif
+
+#define SIM_REG(reg) ((uint16_t)((uintptr_t)&(reg) - SIM_IO_BASE)) /* Adress. */
+
+/********************************************************************************
+* sim_write_t: Loggad skrivning till ett register.
+*
+*              - addr : Registrets adress i mikrodatorns dataminne.
+*              - value: Skrivet värde.
+********************************************************************************/
+typedef struct
+{
+   uint16_t addr;
+   uint8_t value;
+} sim_write_t;
+
+/********************************************************************************
+* sim_reset: Nollställer samtliga register, insignaler, loggen samt summerad
+*            fördröjningstid. Spårning av registerskrivningar aktiveras.
+********************************************************************************/
+void sim_reset(void);
+
+/********************************************************************************
+* sim_timer_restore: Återställer systemtimerns registertillstånd efter
+*                    sim_reset. Systemtimern initieras vid behov, men
+*                    eftersom timer_init enbart konfigurerar Timer 1 vid
+*                    första anropet skrivs registren om här på samma sätt
+*                    som i timer_init. Avbrott aktiveras globalt. Testfall
+*                    som använder systemtimern blir därmed oberoende av
+*                    ordningen de körs i.
+********************************************************************************/
+void sim_timer_restore(void);
+
+/********************************************************************************
+* sim_trace: Aktiverar eller inaktiverar spårning av registerskrivningar.
+*            Vid inaktiverad spårning emuleras inte heller togglingar via
+*            PINx.
+*
+*            - enable: Indikerar ifall spårning ska aktiveras.
+********************************************************************************/
+void sim_trace(const bool enable);
+
+/********************************************************************************
+* sim_set_input: Sätter nivån på en inport, exempelvis för att simulera en
+*                nedtryckt tryckknapp (låg nivå vid intern pullup-resistor).
+*                Vid ändrad nivå genereras PCI-avbrott ifall PCI-avbrott är
+*                aktiverat för aktuell pin samt avbrott är aktiverat globalt.
+*
+*                - pin  : Aktuellt PIN-nummer (0 - 19).
+*                - level: Ny nivå (1 = hög, 0 = låg).
+********************************************************************************/
+void sim_set_input(const uint8_t pin, const bool level);
+
+/********************************************************************************
+* sim_capture: Simulerar en flank på ICP1 (pin 8) vid angivet räknarvärde
+*              för Timer 1. Nivån sätts via sim_set_input. Ifall flanken
+*              har den riktning som ICES1 anger lagras räknarvärdet i ICR1,
+*              ICF1 ettställs och avbrottsrutinen för infångning anropas
+*              ifall avbrottet är aktiverat samt avbrott är aktiverat
+*              globalt.
+*
+*              - ticks: Timer 1:s räknarvärde vid flanken.
+*              - level: Ny nivå (1 = hög, 0 = låg).
+********************************************************************************/
+void sim_capture(const uint16_t ticks, const bool level);
+
+/********************************************************************************
+* sim_tick_ms: Stegar fram Timer 1 angivet antal millisekunder. Ifall
+*              avbrott vid jämförelse med OCR1A är aktiverat samt
+*              avbrott är aktiverat globalt anropas avbrottsrutinen en gång
+*              per millisekund.
+*
+*              - ms: Antal millisekunder som ska stegas fram.
+********************************************************************************/
+void sim_tick_ms(uint32_t ms);
+
+/********************************************************************************
+* sim_uart_drain: Anropar avbrottsrutinen för tomt dataregister på USART0
+*                 upprepade gånger, så länge avbrottet är aktiverat samt
+*                 avbrott är aktiverat globalt, vilket motsvarar att
+*                 sändbufferten töms av hårdvaran. Kräver aktiverad spårning,
+*                 eftersom skrivningar till UDR0 fångas upp som
+*                 registerskrivningar.
+********************************************************************************/
+void sim_uart_drain(void);
+
+/********************************************************************************
+* sim_uart_read: Kopierar byte som har skickats via USART0 sedan föregående
+*                anrop och returnerar antalet kopierade byte.
+*
+*                - data: Buffert där byten ska lagras.
+*                - max : Maximalt antal byte som ska kopieras.
+********************************************************************************/
+size_t sim_uart_read(uint8_t* data,
+                     const size_t max);
+
+/********************************************************************************
+* sim_spi_read: Kopierar byte som har skickats via SPI-enheten sedan
+*               föregående anrop och returnerar antalet kopierade byte.
+*               Överföringen sker omedelbart, det vill säga SPIF ettställs
+*               vid skrivning till SPDR. Kräver aktiverad spårning.
+*
+*               - data: Buffert där byten ska lagras.
+*               - max : Maximalt antal byte som ska kopieras.
+********************************************************************************/
+size_t sim_spi_read(uint8_t* data,
+                    const size_t max);
+
+/********************************************************************************
+* sim_sleeps: Returnerar antalet genomförda vilolägen, det vill säga antalet
+*             exekverade sleep-instruktioner med SE ettställd i SMCR, sedan
+*             simulatorn senast nollställdes. Valt viloläge kan läsas av
+*             via bitarna SM0 - SM2 i SMCR.
+********************************************************************************/
+unsigned long sim_sleeps(void);
+
+/********************************************************************************
+* sim_writes: Returnerar adressen till loggen med registerskrivningar.
+*
+*             - count: Pekare till variabel där antalet loggade skrivningar
+*                      lagras.
+********************************************************************************/
+const sim_write_t* sim_writes(size_t* count);
+
+/********************************************************************************
+* sim_count_writes: Returnerar antalet loggade skrivningar till angivet
+*                   register sedan loggen senast tömdes.
+*
+*                   - addr: Registrets adress, lämpligen via SIM_REG.
+********************************************************************************/
+size_t sim_count_writes(const uint16_t addr);
+
+/********************************************************************************
+* sim_clear_log: Tömmer loggen med registerskrivningar.
+********************************************************************************/
+void sim_clear_log(void);
+
+/********************************************************************************
+* sim_delay_us: Returnerar summerad fördröjningstid i mikrosekunder begärd
+*               via _delay_ms, _delay_us samt _delay_loop_2 sedan
+*               simulatorn senast nollställdes.
+********************************************************************************/
+unsigned long sim_delay_us(void);
+
+#endif /* SIM_H_ */
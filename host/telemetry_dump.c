@@ -0,0 +1,81 @@
+/********************************************************************************
+* telemetry_dump.c: Avkodar telemetriströmmen från USART0, se telemetry.h,
+*                   och skriver ut ett paket per rad. Strömmen läses från
+*                   standard in, exempelvis från simavr:s UART-brygga eller
+*                   en seriell port:
+*
+*                   ./build/telemetry_dump < /dev/ttyACM0
+*
+*                   Synkronisering sker via synkbyten, längdbyten samt
+*                   kontrollsumman. Paket med felaktig kontrollsumma räknas
+*                   och hoppas över.
+********************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "../telemetry.h"
+
+/********************************************************************************
+* dump_get16: Returnerar 16-bitars värde lagrat med minst signifikant byte
+*             först.
+********************************************************************************/
+static unsigned dump_get16(const uint8_t* data)
+{
+   return data[0] | (unsigned)data[1] << 8;
+}
+
+/********************************************************************************
+* dump_frame: Skriver ut innehållet i ett giltigt paket.
+********************************************************************************/
+static void dump_frame(const uint8_t* frame)
+{
+   const unsigned long ms = dump_get16(frame + 3) | (unsigned long)dump_get16(frame + 5) << 16;
+   printf("seq=%3u t=%lu ms leds=0x%04x buttons=B:0x%02x C:0x%02x D:0x%02x "
+          "presses=%u mode=%u event_overflows=%u uart_dropped=%u\n",
+          frame[2], ms, dump_get16(frame + 7), frame[9], frame[10], frame[11],
+          dump_get16(frame + 12), frame[14], dump_get16(frame + 15), dump_get16(frame + 17));
+   return;
+}
+
+/********************************************************************************
+* main: Läser strömmen byte för byte. När bufferten innehåller ett helt paket
+*       kontrolleras dess längd och kontrollsumma. Vid fel förkastas första
+*       byten, så att nästa synkbyte kan sökas upp.
+********************************************************************************/
+int main(void)
+{
+   uint8_t frame[TELEMETRY_FRAME_SIZE];
+   size_t count = 0;
+   unsigned long errors = 0;
+   int c;
+
+   while ((c = getchar()) != EOF)
+   {
+      if (!count && c != TELEMETRY_SYNC) continue;
+      frame[count++] = (uint8_t)c;
+
+      while (count == TELEMETRY_FRAME_SIZE)
+      {
+         uint8_t checksum = 0;
+         size_t i;
+
+         for (i = 1; i < TELEMETRY_FRAME_SIZE - 1; ++i) checksum ^= frame[i];
+
+         if (frame[1] == TELEMETRY_FRAME_SIZE - 3 && frame[TELEMETRY_FRAME_SIZE - 1] == checksum)
+         {
+            dump_frame(frame);
+            fflush(stdout);
+            count = 0;
+         }
+         else
+         {
+            errors++;
+            for (i = 1; i < count && frame[i] != TELEMETRY_SYNC; ++i);
+            memmove(frame, frame + i, count - i);
+            count -= i;
+         }
+      }
+   }
+
+   if (errors) fprintf(stderr, "telemetry_dump: %lu invalid frames\n", errors);
+   return 0;
+}
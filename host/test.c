@@ -0,0 +1,916 @@
+/********************************************************************************
+* test.c: Funktionstester av drivrutinerna, som körs på värddatorn via
+*         simulatorn i sim.c. Testerna verifierar skrivningar till register,
+*         emulerad toggling via PINx, avläsning av injicerade insignaler,
+*         PCI-avbrott samt avstudsning via systemtimern.
+*
+*         Körs via kommandot make test i katalogen host.
+********************************************************************************/
+#include "sim.h"
+#include "../led.h"
+#include "../led_array.h"
+#include "../button.h"
+#include "../timer.h"
+#include "../debounce.h"
+#include "../memstat.h"
+#include "../trace.h"
+#include "../uart.h"
+#include "../telemetry.h"
+#include "../button_group.h"
+#include "../event_queue.h"
+#include "../power.h"
+#include "../shift_register.h"
+#include "../matrix.h"
+#include "../framebuffer.h"
+#include "../scheduler.h"
+#include "../capture.h"
+#include <avr/sleep.h>
+#include <stdio.h>
+
+#if !defined(__x86_64__)
+#error "Funktionstesterna kräver x86_64, eftersom sim.c annars inte fångar upp registerskrivningar!"
+#endif
+
+/* Makrodefinitioner: */
+#define check(condition) ({ \
+   test_checks++; \
+   if (!(condition)) { \
+      test_failures++; \
+      fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+   } \
+})
+
+/* Statiska variabler: */
+static unsigned test_checks = 0;
+static unsigned test_failures = 0;
+static enum button_event test_last_event;
+static uint8_t test_num_events = 0;
+static uint8_t test_task_runs[4];
+static uint16_t test_task_data = 0;
+
+/********************************************************************************
+* test_led: Verifierar att tändning, släckning och toggling av en lysdiod
+*           resulterar i förväntade skrivningar till PORTx och PINx.
+********************************************************************************/
+static void test_led(void)
+{
+   led_t led;
+   sim_reset();
+   led_init(&led, 9);
+   check(read(DDRB, 1));
+
+   sim_clear_log();
+   led.vptr->on(&led);
+   check(PORTB == (1 << 1));
+   check(sim_count_writes(SIM_REG(PORTB)) == 1);
+
+   led.vptr->toggle(&led);
+   check(PORTB == 0);
+   check(!led.enabled);
+   check(sim_count_writes(SIM_REG(PINB)) == 1);
+   check(sim_count_writes(SIM_REG(PORTB)) == 1);
+
+   led.vptr->toggle(&led);
+   check(PORTB == (1 << 1));
+   check(read(PINB, 1));
+
+   led.vptr->off(&led);
+   check(PORTB == 0);
+   led_clear(&led);
+   return;
+}
+
+/********************************************************************************
+* test_led_array: Verifierar att tändning och släckning av lysdioder på
+*                 samtliga tre I/O-portar via bitmasken sker med en
+*                 skrivning per port.
+********************************************************************************/
+static void test_led_array(void)
+{
+   led_t l1, l2, l3, l4;
+   led_t* pushed[2];
+   led_array_t leds;
+   uint8_t num_pushed = 0;
+   sim_reset();
+   led_init(&l1, 2);
+   led_init(&l2, 8);
+   led_init(&l3, 13);
+   led_init(&l4, A0);
+
+   led_array_init(&leds);
+   led_array_push(&leds, &l1);
+   led_array_push(&leds, &l2);
+   led_array_push(&leds, &l3);
+   led_array_push(&leds, &l4);
+   check(leds.size == 4);
+
+   sim_clear_log();
+   led_array_mask_on(&leds.mask);
+   check(PORTD == (1 << 2));
+   check(PORTB == ((1 << 0) | (1 << 5)));
+   check(PORTC == (1 << 0));
+   check(sim_count_writes(SIM_REG(PORTB)) == 1);
+   check(sim_count_writes(SIM_REG(PORTC)) == 1);
+   check(sim_count_writes(SIM_REG(PORTD)) == 1);
+
+   led_array_mask_toggle(&leds.mask);
+   check(PORTB == 0 && PORTC == 0 && PORTD == 0);
+
+   sim_clear_log();
+   led_array_on(&leds);
+   check(PORTD == (1 << 2));
+   check(PORTB == ((1 << 0) | (1 << 5)));
+   check(PORTC == (1 << 0));
+   check(sim_count_writes(SIM_REG(PORTB)) == 1);
+   check(l1.enabled && l2.enabled && l3.enabled && l4.enabled);
+   l2.vptr->toggle(&l2);
+   check(!l2.enabled && PORTB == (1 << 5));
+   led_array_off(&leds);
+   check(PORTB == 0 && PORTC == 0 && PORTD == 0);
+   check(!l1.enabled && !l2.enabled && !l3.enabled && !l4.enabled);
+
+   led_array_pop(&leds);
+   led_array_mask_on(&leds.mask);
+   check(PORTC == 0);
+   led_array_clear(&leds);
+
+   pushed[0] = &l4;
+   pushed[1] = &l1;
+   led_array_push(&leds, pushed[num_pushed++]);
+   check(num_pushed == 1 && leds.size == 1 && leds.leds[0] == &l4);
+   check(leds.mask.portc == (1 << 0) && leds.mask.portd == 0);
+   led_array_clear(&leds);
+   return;
+}
+
+/********************************************************************************
+* test_button_callback: Registrerar flanken vid event på tryckknapp.
+********************************************************************************/
+static void test_button_callback(button_t* self, const enum button_event event)
+{
+   (void)self;
+   test_last_event = event;
+   test_num_events++;
+   return;
+}
+
+/********************************************************************************
+* test_button: Verifierar avläsning av injicerade insignaler samt att
+*              PCI-avbrott genererar callbackanrop med korrekt flank.
+********************************************************************************/
+static void test_button(void)
+{
+   button_t button;
+   sim_reset();
+   button_init(&button, 12);
+   check(read(PORTB, 4));
+   check(!button.vptr->is_pressed(&button));
+
+   sim_set_input(12, true);
+   check(button.vptr->is_pressed(&button));
+
+   sei();
+   button.vptr->set_callback(&button, test_button_callback);
+   button.vptr->enable_interrupt(&button);
+   check(read(PCICR, PCIE0) && read(PCMSK0, 4));
+
+   test_num_events = 0;
+   sim_set_input(12, false);
+   check(test_num_events == 1 && test_last_event == BUTTON_EVENT_FALLING_EDGE);
+   sim_set_input(12, true);
+   check(test_num_events == 2 && test_last_event == BUTTON_EVENT_RISING_EDGE);
+   sim_set_input(11, false);
+   check(test_num_events == 2);
+
+   button.vptr->disable_interrupt(&button);
+   sim_set_input(12, false);
+   check(test_num_events == 2);
+   button_clear(&button);
+   return;
+}
+
+/********************************************************************************
+* test_debounce: Verifierar att en ändrad insignal blir synlig först efter
+*                fyra stabila samplingar och att studsar ignoreras.
+********************************************************************************/
+static void test_debounce(void)
+{
+   button_t button;
+   sim_reset();
+   button_init(&button, A3);
+   sim_timer_restore();
+   debounce_init();
+
+   sim_set_input(A3, true);
+   sim_tick_ms(3 * DEBOUNCE_INTERVAL_MS);
+   check(!button.vptr->is_pressed(&button));
+   sim_tick_ms(DEBOUNCE_INTERVAL_MS);
+   check(button.vptr->is_pressed(&button));
+
+   sim_set_input(A3, false);
+   sim_tick_ms(2 * DEBOUNCE_INTERVAL_MS);
+   sim_set_input(A3, true);
+   sim_tick_ms(4 * DEBOUNCE_INTERVAL_MS);
+   check(button.vptr->is_pressed(&button));
+   check(millis() == 10 * DEBOUNCE_INTERVAL_MS);
+   button_clear(&button);
+   return;
+}
+
+/********************************************************************************
+* test_memstat: Verifierar att heapanvändning samt antalet objekt per typ
+*               räknas vid allokering och frigörning.
+********************************************************************************/
+static void test_memstat(void)
+{
+   memstat_t stats;
+   led_array_t leds;
+   led_t* led = led_new(8);
+   sim_reset();
+
+   led_array_init(&leds);
+   led_array_push(&leds, led);
+   memstat_get(&stats);
+   check(stats.objects[MEMSTAT_LED] == 1);
+   check(stats.objects[MEMSTAT_LED_ARRAY] == 1);
+   check(stats.heap_used == LED_ARRAY_MIN_CAPACITY * sizeof(led_t*));
+
+   led_array_reserve(&leds, 2 * LED_ARRAY_MIN_CAPACITY);
+   led_array_shrink_to_fit(&leds);
+   memstat_get(&stats);
+   check(stats.heap_used == sizeof(led_t*));
+   check(stats.heap_peak >= 2 * LED_ARRAY_MIN_CAPACITY * sizeof(led_t*));
+
+   led_array_clear(&leds);
+   led_delete(&led);
+   memstat_get(&stats);
+   check(stats.heap_used == 0);
+   check(stats.heap_failed == 0);
+   check(stats.objects[MEMSTAT_LED] == 0 && stats.objects[MEMSTAT_LED_ARRAY] == 0);
+   return;
+}
+
+/********************************************************************************
+* test_pool: Verifierar att pool_free ignorerar felaktiga pekare samt
+*            frigörning när inga objekt är allokerade.
+********************************************************************************/
+static void test_pool(void)
+{
+   static led_t storage[3];
+   pool_t pool = POOL_INIT(storage);
+   pool_stats_t stats;
+   led_t* a = (led_t*)pool_alloc(&pool);
+   led_t* b = (led_t*)pool_alloc(&pool);
+   check(a == &storage[0] && b == &storage[1]);
+
+   pool_free(&pool, (uint8_t*)a + 1);
+   pool_free(&pool, &storage[2]);
+   pool_free(&pool, 0);
+   pool_get_stats(&pool, &stats);
+   check(stats.used == 2);
+
+   pool_free(&pool, a);
+   pool_free(&pool, b);
+   pool_free(&pool, b);
+   pool_get_stats(&pool, &stats);
+   check(stats.used == 0);
+   check(pool_alloc(&pool) == b && pool_alloc(&pool) == a);
+   check(pool_alloc(&pool) == &storage[2] && !pool_alloc(&pool));
+   return;
+}
+
+/********************************************************************************
+* test_trace: Verifierar att spårpunkterna lagras i kronologisk ordning och
+*             att enbart de senaste posterna kopieras ifall fler finns än
+*             vad som ryms.
+********************************************************************************/
+static void test_trace(void)
+{
+   trace_record_t records[TRACE_SIZE];
+   led_t led;
+   uint8_t i;
+   sim_reset();
+   led_init(&led, 8);
+   trace_clear();
+   check(trace_copy(records, TRACE_SIZE) == 0);
+
+   led.vptr->on(&led);
+   led.vptr->toggle(&led);
+   check(trace_copy(records, TRACE_SIZE) == 4);
+   check(records[0].id == TRACE_LED_ON);
+   check(records[1].id == (TRACE_LED_ON | TRACE_EXIT));
+   check(records[2].id == TRACE_LED_TOGGLE);
+   check(records[3].id == (TRACE_LED_TOGGLE | TRACE_EXIT));
+   check(trace_copy(records, 1) == 1 && records[0].id == (TRACE_LED_TOGGLE | TRACE_EXIT));
+
+   for (i = 0; i < TRACE_SIZE; ++i)
+   {
+      led.vptr->off(&led);
+   }
+
+   check(trace_copy(records, TRACE_SIZE) == TRACE_SIZE);
+   check(records[0].id == TRACE_LED_OFF);
+   check(records[TRACE_SIZE - 1].id == (TRACE_LED_OFF | TRACE_EXIT));
+   check(trace_elapsed_ticks(&records[0], &records[1]) == 0);
+   led_clear(&led);
+   return;
+}
+
+/********************************************************************************
+* test_uart: Verifierar att data skickas via sändbufferten i ordning, att
+*            avbrottet inaktiveras när bufferten är tom och att skrivningar
+*            som inte ryms förkastas i sin helhet.
+********************************************************************************/
+static void test_uart(void)
+{
+   uint8_t data[UART_TX_SIZE];
+   uint8_t received[2 * UART_TX_SIZE];
+   uint8_t i;
+   sim_reset();
+   uart_init(38400);
+   check(UBRR0 == 51);
+
+   for (i = 0; i < UART_TX_SIZE; ++i) data[i] = i;
+   check(uart_tx_idle());
+   check(uart_write(data, 3));
+   check(read(UCSR0B, UDRIE0));
+   check(uart_tx_pending() == 3);
+   check(!uart_tx_idle());
+   sim_uart_drain();
+   check(!read(UCSR0B, UDRIE0));
+   check(uart_tx_idle());
+   check(sim_uart_read(received, sizeof(received)) == 3);
+   check(received[0] == 0 && received[1] == 1 && received[2] == 2);
+
+   check(uart_write(data, UART_TX_SIZE - 1));
+   check(!uart_write(data, 2));
+   check(uart_tx_dropped() == 2);
+   sim_uart_drain();
+   check(sim_uart_read(received, sizeof(received)) == UART_TX_SIZE - 1);
+   check(received[UART_TX_SIZE - 2] == UART_TX_SIZE - 2);
+   return;
+}
+
+/********************************************************************************
+* test_telemetry: Verifierar paketformatet samt att ett paket skickas per
+*                 period och att nedtryckningar räknas.
+********************************************************************************/
+static void test_telemetry(void)
+{
+   uint8_t frame[2 * TELEMETRY_FRAME_SIZE];
+   uint8_t checksum = 0;
+   led_t l1, l2;
+   button_t button;
+   led_array_t leds;
+   button_group_t buttons;
+   uint8_t i;
+
+   sim_reset();
+   sei();
+   led_init(&l1, 6);
+   led_init(&l2, 8);
+   button_init(&button, 2);
+   led_array_init(&leds);
+   led_array_push(&leds, &l1);
+   led_array_push(&leds, &l2);
+   button_group_init(&buttons);
+   button_group_add(&buttons, &button);
+
+   uart_init(38400);
+   sim_timer_restore();
+   telemetry_init(&leds, &buttons, 10);
+   telemetry_set_mode(3);
+   l2.vptr->on(&l2);
+
+   sim_tick_ms(9);
+   check(!telemetry_service());
+   sim_set_input(2, true);
+   sim_tick_ms(DEBOUNCE_INTERVAL_MS * 5);
+   check(telemetry_service());
+   check(!telemetry_service());
+   sim_uart_drain();
+   check(sim_uart_read(frame, sizeof(frame)) == TELEMETRY_FRAME_SIZE);
+
+   for (i = 1; i < TELEMETRY_FRAME_SIZE - 1; ++i) checksum ^= frame[i];
+   check(frame[0] == TELEMETRY_SYNC);
+   check(frame[1] == TELEMETRY_FRAME_SIZE - 3);
+   check(frame[7] == 0x02 && frame[8] == 0);
+   check(frame[9] == 0 && frame[10] == 0 && frame[11] == (1 << 2));
+   check(frame[12] == 1 && frame[13] == 0);
+   check(frame[14] == 3);
+   check(frame[TELEMETRY_FRAME_SIZE - 1] == checksum);
+
+   telemetry_set_period(0);
+   led_array_clear(&leds);
+   led_clear(&l1);
+   led_clear(&l2);
+   button_clear(&button);
+   return;
+}
+
+/********************************************************************************
+* test_power: Verifierar att oanvänd kringutrustning stängs av, att valt
+*             viloläge används, att insomning uteblir medan eventkön inte
+*             är tom samt att ändrade avstudsade insignaler ger event.
+********************************************************************************/
+static void test_power(void)
+{
+   event_t event;
+   button_t button;
+   button_group_t buttons;
+   sim_reset();
+   sim_timer_restore();
+   button_init(&button, A3);
+   button_group_init(&buttons);
+   button_group_add(&buttons, &button);
+   sim_tick_ms(4 * DEBOUNCE_INTERVAL_MS);
+   while (event_queue_pop(&event));
+
+   power_init();
+   check(!read(ADCSRA, ADEN) && read(ACSR, ACD));
+   check(read(PRR, PRADC) && read(PRR, PRTWI) && !read(PRR, PRTIM1));
+
+   power_sleep(POWER_MODE_IDLE);
+   check(sim_sleeps() == 1);
+   check((SMCR & ~(1 << SE)) == SLEEP_MODE_IDLE && !read(SMCR, SE));
+   check(read(SREG, 7));
+
+   debounce_enable_events();
+   check(button_group_is_settled(&buttons));
+   sim_set_input(A3, true);
+   check(!button_group_is_settled(&buttons));
+   sim_tick_ms(4 * DEBOUNCE_INTERVAL_MS);
+   check(button_group_is_settled(&buttons));
+
+   power_sleep(POWER_MODE_POWER_DOWN);
+   check(sim_sleeps() == 1);
+   check(event_queue_pop(&event));
+   check(event.type == EVENT_INPUT_CHANGED && event.source == IO_PORTC);
+   check(event.data == (1 << 3));
+
+   power_sleep(POWER_MODE_POWER_DOWN);
+   check(sim_sleeps() == 2);
+   check((SMCR & ~(1 << SE)) == SLEEP_MODE_PWR_DOWN);
+   check(read(SREG, 7));
+   button_clear(&button);
+   return;
+}
+
+/********************************************************************************
+* test_shift_register: Verifierar att lysdioder i en led-array kopplad till
+*                      skiftregister skrivs ut som en bildruta per
+*                      millisekund, att oförändrad bildbuffert inte skrivs
+*                      ut samt att bytet till sista kretsen skickas först.
+********************************************************************************/
+static void test_shift_register(void)
+{
+   led_t storage[SHIFT_REGISTER_NUM_LEDS];
+   led_t* pointers[SHIFT_REGISTER_NUM_LEDS];
+   uint8_t frame[2 * SHIFT_REGISTER_CHIPS];
+   led_array_t leds;
+   uint8_t i;
+   sim_reset();
+   sim_timer_restore();
+   shift_register_init();
+   check(read(SPCR, SPE) && read(SPCR, MSTR) && read(SPSR, SPI2X));
+   check(DDRB == ((1 << 2) | (1 << 3) | (1 << 5)));
+
+   sim_tick_ms(1);
+   check(sim_spi_read(frame, sizeof(frame)) == SHIFT_REGISTER_CHIPS);
+   check(frame[0] == 0 && frame[SHIFT_REGISTER_CHIPS - 1] == 0);
+
+   led_array_init_static(&leds, pointers, SHIFT_REGISTER_NUM_LEDS);
+   for (i = 0; i < SHIFT_REGISTER_NUM_LEDS; ++i)
+   {
+      shift_register_led_init(&storage[i], i);
+      led_array_push(&leds, &storage[i]);
+   }
+
+   check(leds.mask.portb == 0 && leds.mask.portc == 0 && leds.mask.portd == 0);
+   sim_tick_ms(1);
+   check(sim_spi_read(frame, sizeof(frame)) == 0);
+
+   led_array_on(&leds);
+   sim_clear_log();
+   sim_tick_ms(1);
+   check(sim_spi_read(frame, sizeof(frame)) == SHIFT_REGISTER_CHIPS);
+   check(frame[0] == 0xFF && frame[SHIFT_REGISTER_CHIPS - 1] == 0xFF);
+   check(sim_count_writes(SIM_REG(PORTB)) == 2);
+   check(!read(PORTB, 2));
+
+   storage[0].vptr->off(&storage[0]);
+   storage[9].vptr->toggle(&storage[9]);
+   check(!storage[9].enabled);
+   sim_tick_ms(1);
+   check(sim_spi_read(frame, sizeof(frame)) == SHIFT_REGISTER_CHIPS);
+   check(frame[SHIFT_REGISTER_CHIPS - 1] == 0xFE);
+   check(frame[SHIFT_REGISTER_CHIPS - 2] == 0xFD);
+
+   led_array_clear(&leds);
+   for (i = 0; i < SHIFT_REGISTER_NUM_LEDS; ++i) led_clear(&storage[i]);
+   shift_register_refresh();
+   check(sim_spi_read(frame, sizeof(frame)) == SHIFT_REGISTER_CHIPS);
+   check(frame[0] == 0 && frame[SHIFT_REGISTER_CHIPS - 1] == 0);
+   return;
+}
+
+/********************************************************************************
+* test_matrix: Verifierar att en rad aktiveras per millisekund med
+*              förväntade värden i DDRx och PORTx, både för multiplexering
+*              och charlieplexing, samt att övriga pinnar inte påverkas.
+********************************************************************************/
+static void test_matrix(void)
+{
+   const uint8_t rows[2] = { 2, 3 };
+   const uint8_t columns[3] = { 8, 9, 10 };
+   const uint8_t pins[3] = { A0, A1, A2 };
+   led_t leds[3];
+   sim_reset();
+   sim_timer_restore();
+   set(PORTB, 5);
+
+   check(matrix_init(rows, 2, columns, 3) == 0);
+   matrix_led_init(&leds[0], 0, 0);
+   matrix_led_init(&leds[1], 1, 2);
+   matrix_led_init(&leds[2], 2, 0);
+   leds[0].vptr->on(&leds[0]);
+   leds[1].vptr->on(&leds[1]);
+   leds[2].vptr->on(&leds[2]);
+
+   sim_tick_ms(1);
+   check(DDRD == 0x0C && PORTD == 0x08);
+   check(DDRB == 0x01 && (PORTB & 0x07) == 0x01);
+   sim_tick_ms(1);
+   check(DDRD == 0x0C && PORTD == 0x04);
+   check(DDRB == 0x04 && (PORTB & 0x07) == 0x04);
+
+   leds[1].vptr->toggle(&leds[1]);
+   check(!leds[1].enabled);
+   sim_tick_ms(2);
+   check(DDRB == 0 && (PORTB & 0x07) == 0);
+   check(read(PORTB, 5));
+
+   check(matrix_init_charlieplexed(pins, 3) == 0);
+   check(DDRD == 0 && PORTD == 0);
+   matrix_led_init(&leds[0], 0, 1);
+   matrix_led_init(&leds[1], 2, 0);
+   matrix_led_init(&leds[2], 1, 1);
+   leds[0].vptr->on(&leds[0]);
+   leds[1].vptr->on(&leds[1]);
+   leds[2].vptr->on(&leds[2]);
+
+   sim_tick_ms(1);
+   check(DDRC == 0x03 && PORTC == 0x02);
+   sim_tick_ms(1);
+   check(DDRC == 0x02 && PORTC == 0);
+   sim_tick_ms(1);
+   check(DDRC == 0x05 && PORTC == 0x01);
+
+   matrix_stop();
+   check(DDRC == 0 && PORTC == 0);
+   check(matrix_init_charlieplexed(pins, 1) == 1);
+   check(matrix_init(rows, 2, columns, MATRIX_MAX_COLUMNS + 1) == 1);
+   return;
+}
+
+/********************************************************************************
+* test_gpio: Verifierar tabellens beskrivning av pinnar på samtliga tre
+*            I/O-portar samt att ogiltiga pin-nummer som väljs under
+*            körning ger lysdioder och tryckknappar utan I/O-port.
+********************************************************************************/
+static void test_gpio(void)
+{
+   volatile uint8_t invalid_pin = 20;
+   gpio_t gpio;
+   led_t led;
+   button_t button;
+   sim_reset();
+
+   check(gpio_load(&gpio, D3));
+   check(gpio.io_port == IO_PORTD && gpio.pin == 3 && gpio.mask == (1 << 3));
+   check(gpio.ddr == &DDRD && gpio.port == &PORTD && gpio.pin_reg == &PIND);
+   check(gpio_load(&gpio, 13));
+   check(gpio.io_port == IO_PORTB && gpio.pin == 5 && gpio.port == &PORTB);
+   check(gpio_load(&gpio, A5));
+   check(gpio.io_port == IO_PORTC && gpio.mask == (1 << 5) && gpio.ddr == &DDRC);
+   check(!gpio_load(&gpio, invalid_pin));
+   check(gpio.io_port == IO_PORT_NONE && gpio.mask == 0 && !gpio.port);
+
+   led_init(&led, invalid_pin);
+   check(led.io_port == IO_PORT_NONE && led.mask == 0);
+   led.vptr->on(&led);
+   check(PORTB == 0 && PORTC == 0 && PORTD == 0);
+   button_init(&button, invalid_pin);
+   check(button.io_port == IO_PORT_NONE && button.mask == 0);
+
+   led_init(&led, A1);
+   check(read(DDRC, 1) && led.port == &PORTC && led.pin_reg == &PINC);
+   button_init(&button, D4);
+   check(read(PORTD, 4) && button.io_port == IO_PORTD && button.pin == 4);
+   led_clear(&led);
+   button_clear(&button);
+   return;
+}
+
+/********************************************************************************
+* test_framebuffer: Verifierar skiftning, rotation och maskning av en
+*                   bildbuffert samt att en bildruta visas med en skrivning
+*                   per I/O-port, även då arrayen innehåller en lysdiod
+*                   kopplad till skiftregister.
+********************************************************************************/
+static void test_framebuffer(void)
+{
+   const uint8_t pins[6] = { 2, 3, 4, 5, 8, 9 };
+   uint8_t mask[FRAMEBUFFER_BYTES] = { 0xFF };
+   led_t storage[7];
+   led_t* pointers[7];
+   led_array_t leds;
+   framebuffer_t framebuffer;
+   uint8_t i;
+   sim_reset();
+
+   led_array_init_static(&leds, pointers, 7);
+   for (i = 0; i < 6; ++i)
+   {
+      led_init(&storage[i], pins[i]);
+      led_array_push(&leds, &storage[i]);
+   }
+
+   shift_register_led_init(&storage[6], 0);
+   led_array_push(&leds, &storage[6]);
+   framebuffer_init(&framebuffer, &leds);
+   check(framebuffer.size == 7);
+
+   framebuffer_load(&framebuffer, 0x0005);
+   sim_clear_log();
+   framebuffer_commit(&framebuffer);
+   check(PORTD == ((1 << 2) | (1 << 4)) && PORTB == 0);
+   check(sim_count_writes(SIM_REG(PORTD)) == 1);
+   check(sim_count_writes(SIM_REG(PORTB)) == 1);
+   check(storage[0].enabled && !storage[1].enabled && storage[2].enabled);
+
+   framebuffer_shift(&framebuffer, 1);
+   check(framebuffer.bits[0] == 0x0A);
+   framebuffer_shift(&framebuffer, 4);
+   check(framebuffer.bits[0] == 0x20);
+   framebuffer_rotate(&framebuffer, 2);
+   check(framebuffer.bits[0] == 0x01);
+   framebuffer_rotate(&framebuffer, -1);
+   check(framebuffer.bits[0] == 0x40);
+   check(framebuffer_get(&framebuffer, 6) && !framebuffer_get(&framebuffer, 0));
+
+   framebuffer_commit(&framebuffer);
+   check(PORTD == 0 && PORTB == 0);
+   check(storage[6].enabled && !storage[0].enabled);
+
+   framebuffer_mask(&framebuffer, mask, FRAMEBUFFER_OP_XOR);
+   check(framebuffer.bits[0] == 0x3F);
+   sim_clear_log();
+   framebuffer_commit(&framebuffer);
+   check(PORTD == 0x3C && PORTB == 0x03);
+   check(sim_count_writes(SIM_REG(PORTD)) == 1);
+   check(!storage[6].enabled && storage[5].enabled);
+
+   framebuffer_set(&framebuffer, 7, true);
+   framebuffer_fill(&framebuffer);
+   check(framebuffer.bits[0] == 0x7F && framebuffer.bits[1] == 0);
+   framebuffer_mask(&framebuffer, mask, FRAMEBUFFER_OP_AND);
+   framebuffer_toggle(&framebuffer, 0);
+   check(framebuffer.bits[0] == 0x7E);
+
+   led_array_pop(&leds);
+   led_array_pop(&leds);
+   framebuffer_set(&framebuffer, 5, false);
+   framebuffer_commit(&framebuffer);
+   check(PORTD == 0x38 && PORTB == 0x03);
+   check(storage[5].enabled && !storage[6].enabled);
+
+   for (i = 0; i < 7; ++i) led_clear(&storage[i]);
+   return;
+}
+
+/********************************************************************************
+* test_periodic_task: Uppgift som räknar upp sina körningar var 10:e ms.
+********************************************************************************/
+static enum task_status test_periodic_task(task_t* self)
+{
+   task_begin(self);
+
+   while (1)
+   {
+      test_task_runs[0]++;
+      task_sleep(self, 10);
+   }
+
+   task_end(self);
+}
+
+/********************************************************************************
+* test_event_task: Uppgift som räknar upp sina körningar vid varje event av
+*                  typen EVENT_USER och lagrar eventets data.
+********************************************************************************/
+static enum task_status test_event_task(task_t* self)
+{
+   task_begin(self);
+
+   while (1)
+   {
+      task_wait_event(self, EVENT_USER);
+      test_task_runs[1]++;
+      test_task_data = self->event.data;
+   }
+
+   task_end(self);
+}
+
+/********************************************************************************
+* test_exiting_task: Uppgift som lämnar över två gånger och sedan avslutas.
+********************************************************************************/
+static enum task_status test_exiting_task(task_t* self)
+{
+   task_begin(self);
+   test_task_runs[2]++;
+   task_yield(self);
+   test_task_runs[2]++;
+   task_yield(self);
+   test_task_runs[2]++;
+   task_end(self);
+}
+
+/********************************************************************************
+* test_removing_task: Uppgift som avregistrerar uppgiften som dess context
+*                     pekar på och sedan avslutas.
+********************************************************************************/
+static enum task_status test_removing_task(task_t* self)
+{
+   task_begin(self);
+   scheduler_remove((task_t*)self->context);
+   test_task_runs[3]++;
+   task_end(self);
+}
+
+/********************************************************************************
+* test_scheduler: Verifierar att en periodisk uppgift körs med fast period,
+*                 att en uppgift som väntar på event enbart körs vid rätt
+*                 eventtyp, att avslutade uppgifter avregistreras samt att
+*                 ingen uppgift hoppas över när en uppgift avregistrerar
+*                 en uppgift före sig under ett varv.
+*                 Event från avstudsningen töms ur kön efter varje
+*                 stegning av timern, eftersom varje event medför att
+*                 samtliga vakna uppgifter körs.
+********************************************************************************/
+static void test_scheduler(void)
+{
+   task_t tasks[5];
+   event_t event;
+   sim_reset();
+   sim_timer_restore();
+   while (event_queue_pop(&event));
+
+   check(scheduler_add(&tasks[0], test_periodic_task, 0) == 0);
+   check(scheduler_add(&tasks[1], test_event_task, 0) == 0);
+   check(scheduler_add(&tasks[2], test_exiting_task, 0) == 0);
+   check(scheduler_add(&tasks[3], test_exiting_task, 0) == 0);
+   check(scheduler_add(&tasks[4], test_exiting_task, 0) == 1);
+   scheduler_remove(&tasks[3]);
+
+   scheduler_service();
+   check(test_task_runs[0] == 1 && test_task_runs[1] == 0 && test_task_runs[2] == 1);
+   check(scheduler_needs_timer());
+
+   sim_tick_ms(9);
+   while (event_queue_pop(&event));
+   scheduler_service();
+   check(test_task_runs[0] == 1 && test_task_runs[2] == 2);
+   sim_tick_ms(1);
+   while (event_queue_pop(&event));
+   scheduler_service();
+   check(test_task_runs[0] == 2 && test_task_runs[2] == 3);
+   scheduler_service();
+   check(test_task_runs[2] == 3);
+   check(scheduler_add(&tasks[2], test_exiting_task, 0) == 0);
+   check(scheduler_add(&tasks[3], test_exiting_task, 0) == 0);
+   scheduler_remove(&tasks[2]);
+   scheduler_remove(&tasks[3]);
+
+   event_queue_push(EVENT_TIMER, 0, 1);
+   event_queue_push(EVENT_USER, 0, 42);
+   scheduler_service();
+   check(test_task_runs[1] == 1 && test_task_data == 42);
+   scheduler_service();
+   check(test_task_runs[1] == 1);
+
+   sim_tick_ms(25);
+   while (event_queue_pop(&event));
+   scheduler_service();
+   scheduler_service();
+   check(test_task_runs[0] == 4);
+
+   scheduler_remove(&tasks[0]);
+   check(!scheduler_needs_timer());
+   scheduler_remove(&tasks[1]);
+
+   check(scheduler_add(&tasks[2], test_exiting_task, 0) == 0);
+   check(scheduler_add(&tasks[3], test_removing_task, &tasks[2]) == 0);
+   check(scheduler_add(&tasks[4], test_exiting_task, 0) == 0);
+   scheduler_service();
+   check(test_task_runs[3] == 1 && test_task_runs[2] == 5);
+   scheduler_remove(&tasks[4]);
+   return;
+}
+
+/********************************************************************************
+* test_capture: Verifierar att flanker på ICP1 tidsstämplas utifrån ICR1
+*               och millisekundräknaren, att riktningen växlas efter varje
+*               flank, att full buffert räknas som förkastade flanker samt
+*               att enbart pin 8 accepteras.
+********************************************************************************/
+static void test_capture(void)
+{
+   button_t button;
+   button_t other;
+   capture_event_t pressed;
+   capture_event_t released;
+   uint32_t ms;
+   uint8_t i;
+   sim_reset();
+   sim_timer_restore();
+
+   button_init(&button, CAPTURE_PIN);
+   button_init(&other, 9);
+   sim_set_input(8, true);
+   check(capture_enable(&other) == 1);
+   check(capture_enable(&button) == 0);
+   check(read(TIMSK1, ICIE1) && read(TCCR1B, ICNC1) && !read(TCCR1B, ICES1));
+
+   ms = millis();
+   sim_capture(300, false);
+   check(read(TCCR1B, ICES1) && !read(TIFR1, ICF1));
+   sim_capture(400, false);
+   sim_tick_ms(2);
+   sim_capture(1500, true);
+   check(capture_available() == 2);
+
+   check(capture_read(&pressed) && capture_read(&released));
+   check(!capture_read(&pressed));
+   check(pressed.edge == BUTTON_EVENT_FALLING_EDGE && released.edge == BUTTON_EVENT_RISING_EDGE);
+   check(pressed.ticks == ms * TIMER_TICKS_PER_MS + 300);
+   check(capture_ticks_to_us(released.ticks - pressed.ticks) == 2600);
+
+   for (i = 0; i <= CAPTURE_BUFFER_SIZE; ++i)
+   {
+      sim_capture(i, i & 1);
+   }
+
+   check(capture_available() == CAPTURE_BUFFER_SIZE && capture_overflows() == 1);
+   while (capture_read(&pressed));
+
+   capture_disable();
+   check(!read(TIMSK1, ICIE1));
+   sim_capture(0, false);
+   sim_capture(0, true);
+   check(capture_available() == 0);
+   button_clear(&button);
+   button_clear(&other);
+   return;
+}
+
+/********************************************************************************
+* test_delay: Verifierar att fördröjningsmakrona begär förväntad tid.
+********************************************************************************/
+static void test_delay(void)
+{
+   sim_reset();
+   delay_ms(100);
+   check(sim_delay_us() == 100000UL);
+   sim_reset();
+   delay_us(1000);
+   check(sim_delay_us() == 1000UL);
+   return;
+}
+
+/********************************************************************************
+* main: Kör samtliga tester. Returnerar 0 ifall samtliga kontroller lyckades.
+********************************************************************************/
+int main(void)
+{
+   test_led();
+   test_led_array();
+   test_button();
+   test_debounce();
+   test_memstat();
+   test_pool();
+   test_trace();
+   test_uart();
+   test_telemetry();
+   test_power();
+   test_shift_register();
+   test_matrix();
+   test_framebuffer();
+   test_gpio();
+   test_scheduler();
+   test_capture();
+   test_delay();
+   printf("%u checks, %u failures\n", test_checks, test_failures);
+   return test_failures ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+/********************************************************************************
+* util/delay.h: Ersättning för avr-libc:s util/delay.h vid kompilering för
+*               värddatorn. Ingen fördröjning genereras, i stället summeras
+*               begärd fördröjningstid i simulatorn, se sim_delay_us.
+********************************************************************************/
+#ifndef SIM_UTIL_DELAY_H_
+#define SIM_UTIL_DELAY_H_
+
+extern unsigned long sim_delay_total_us; /* Summerad fördröjningstid. */
+
+#define _delay_ms(ms) (sim_delay_total_us += (unsigned long)((ms) * 1000))
+#define _delay_us(us) (sim_delay_total_us += (unsigned long)(us))
+
+#endif /* SIM_UTIL_DELAY_H_ */
@@ -0,0 +1,15 @@
+/********************************************************************************
+* util/delay_basic.h: Ersättning för avr-libc:s util/delay_basic.h vid
+*                     kompilering för värddatorn. Begärd fördröjning räknas om
+*                     till mikrosekunder utifrån F_CPU och summeras i
+*                     simulatorn, se sim_delay_us.
+********************************************************************************/
+#ifndef SIM_UTIL_DELAY_BASIC_H_
+#define SIM_UTIL_DELAY_BASIC_H_
+
+extern unsigned long sim_delay_total_us; /* Summerad fördröjningstid. */
+
+#define _delay_loop_1(count) (sim_delay_total_us += (unsigned long)(count) * 3 / (F_CPU / 1000000UL))
+#define _delay_loop_2(count) (sim_delay_total_us += (unsigned long)(count) * 4 / (F_CPU / 1000000UL))
+
+#endif /* SIM_UTIL_DELAY_BASIC_H_ */
@@ -1,215 +1,258 @@
-/********************************************************************************
-* led.h: Innehller funktionsdefinitioner fr implementering av lysdioder och
-*        andra digitala utportar via strukten led.
-********************************************************************************/
-#include "led.h"
-
-/* Statiska funktioner: */
-static void led_on(led_t* self);
-static void led_off(led_t* self);
-static void led_toggle(led_t* self);
-static void led_blink(led_t* self,
-                      const uint16_t blink_speed_ms);
-static led_vptr_t led_vptr_new(void);
-
-/********************************************************************************
-* led_init: Initierar ny lysdiod p angiven pin.
-*
-*           - self: Pekare till lysdioden som ska initieras.
-*           - pin : Lysdiodens pin-nummer p Arduino Uno, exempelvis 8.
-*                   Alternativt kan motsvarande port-nummer p ATmega328P
-*                   anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-void led_init(led_t* self,
-              const uint8_t pin)
-{
-   if (pin >= 0 && pin <= 7)
-   {
-      self->io_port = IO_PORTD,
-      self->pin = pin;
-      set(DDRD, self->pin);
-   }
-   else if (pin >= 8 && pin <= 13)
-   {
-      self->io_port = IO_PORTB;
-      self->pin = pin - 8;
-      set(DDRB, self->pin);
-   }
-   else if (pin >= 14 && pin <= 19)
-   {
-      self->io_port = IO_PORTC;
-      self->pin = pin - 14;
-      set(DDRC, self->pin);
-   }
-   else
-   {
-      self->io_port = IO_PORT_NONE;
-      self->pin = 0;
-   }
-
-   self->enabled = false;
-   self->vptr = led_vptr_new();
-   return;
-}
-
-/********************************************************************************
-* led_clear: Nollstller lysdiod samt motsvarande pin.
-*
-*            - self: Pekare till lysdioden som ska nollstllas.
-********************************************************************************/
-void led_clear(led_t* self)
-{
-   if (self->io_port == IO_PORTB)
-   {
-      clr(DDRB, self->pin);
-      clr(PORTB, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      clr(DDRC, self->pin);
-      clr(PORTC, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      clr(DDRD, self->pin);
-      clr(PORTD, self->pin);
-   }
-
-   self->io_port = IO_PORT_NONE;
-   self->pin = 0;
-   self->enabled = false;
-   return;
-}
-
-/********************************************************************************
-* led_new: Allokerar minne och initierar en ny lysdiod p angiven pin.
-*          En pekare returneras till lysdioden efter initieringen.
-*          Vid misslyckad minnesallokering returneras en nullpekare.
-*
-*          - pin : Lysdiodens pin-nummer p Arduino Uno, exempelvis 8.
-*                  Alternativt kan motsvarande port-nummer p ATmega328P
-*                  anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-led_t* led_new(const uint8_t pin)
-{
-   led_t* self = (led_t*)malloc(sizeof(led_t));
-   if (!self) return 0;
-   led_init(self, pin);
-   return self;
-}
-
-/********************************************************************************
-* led_delete: Frigr minne allokerat fr angiven lysdiod och stter motsvarande
-*             pekare till null. Fr att kunna genomfra detta passeras adressen
-*             till den pekare som pekar p lysdioden.
-*
-*             - self: Adressen till den pekare som pekar p lysdioden.
-********************************************************************************/
-void led_delete(led_t** self)
-{
-   led_clear(*self);
-   free(*self);
-   *self = 0;
-   return;
-}
-
-/********************************************************************************
-* led_on: Tnder angiven lysdiod.
-*
-*         - self: Pekare till lysdioden som ska tndas.
-********************************************************************************/
-static void led_on(led_t* self)
-{
-   if (self->io_port == IO_PORTB)
-   {
-      set(PORTB, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      set(PORTC, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      set(PORTD, self->pin);
-   }
-
-   self->enabled = true;
-   return;
-}
-
-/********************************************************************************
-* led_off: Slcker angiven lysdiod.
-*
-*          - self: Pekare till lysdioden som ska slckas.
-********************************************************************************/
-static void led_off(led_t* self)
-{
-   if (self->io_port == IO_PORTB)
-   {
-      clr(PORTB, self->pin);
-   }
-   else if (self->io_port == IO_PORTC)
-   {
-      clr(PORTC, self->pin);
-   }
-   else if (self->io_port == IO_PORTD)
-   {
-      clr(PORTD, self->pin);
-   }
-
-   self->enabled = false;
-   return;
-}
-
-/********************************************************************************
-* led_toggle: Togglar utsignalen p angiven lysdiod. Om lysdioden r slckt vid
-*             anropet s tnds den. P samma stt gller att om lysdioden r
-*             tnd vid anropet s slcks den.
-*
-*             - self: Pekare till lysdioden vars utsignal ska togglas.
-********************************************************************************/
-static void led_toggle(led_t* self)
-{
-   if (self->enabled)
-   {
-      led_off(self);
-   }
-   else
-   {
-      led_on(self);
-   }
-
-   return;
-}
-
-/********************************************************************************
-* led_blink: Blinkar lysdiod en gng med angiven blinkhastighet.
-*
-*            - self          : Pekare till lysdioden som ska blinkas.
-*            - blink_speed_ms: Blinkhastigheten mtt i millisekunder.
-********************************************************************************/
-static void led_blink(led_t* self,
-                      const uint16_t blink_speed_ms)
-{
-   led_toggle(self);
-   delay_ms(blink_speed_ms);
-   return;
-}
-
-/********************************************************************************
-* led_vptr_new: Returnerar en pekare till ett vtable innehllande pekare till
-*               associerade funktioner fr strukten led. Nr programmet startar
-*               stts respektive pekare till att peka p motsvarande funktion.
-********************************************************************************/
-static led_vptr_t led_vptr_new(void)
-{
-   static struct led_vtable self = 
-   {
-      .on = led_on,
-      .off = led_off, 
-      .toggle = led_toggle,
-      .blink = led_blink,
-   };
-
-   return &self;
+/********************************************************************************
+* led.h: Innehåller funktionsdefinitioner för implementering av lysdioder och
+*        andra digitala utportar via strukten led.
+********************************************************************************/
+#include "led.h"
+#include "memstat.h"
+#include "trace.h"
+#include "blink.h"
+
+/* Statiska funktioner: */
+static void led_on(led_t* self);
+static void led_off(led_t* self);
+static void led_toggle(led_t* self);
+static void led_blink(led_t* self,
+                      const uint16_t blink_speed_ms);
+static led_vptr_t led_vptr_new(void);
+
+/* Statiska variabler: */
+#if LED_POOL_SIZE > 0
+static led_t led_pool_storage[LED_POOL_SIZE]; /* Minne för objektpoolen. */
+static pool_t led_pool = POOL_INIT(led_pool_storage); /* Objektpool för led_new. */
+#endif
+
+/********************************************************************************
+* led_dummy_reg: Ersättningsregister för lysdioder med ogiltig pin, så att
+*                led_on, led_off samt led_toggle kan genomföras utan kontroll
+*                av I/O-port. Eftersom bitmasken då är noll påverkas inget.
+********************************************************************************/
+static volatile uint8_t led_dummy_reg = 0;
+
+/********************************************************************************
+* led_init: Initierar ny lysdiod på angiven pin.
+*
+*           - self: Pekare till lysdioden som ska initieras.
+*           - pin : Lysdiodens pin-nummer på Arduino Uno, exempelvis 8.
+*                   Alternativt kan motsvarande port-nummer på ATmega328P
+*                   anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+********************************************************************************/
+void (led_init)(led_t* self,
+                const uint8_t pin)
+{
+   gpio_t gpio;
+
+   if (gpio_load(&gpio, pin))
+   {
+      self->port = gpio.port;
+      self->pin_reg = gpio.pin_reg;
+      *gpio.ddr |= gpio.mask;
+   }
+   else
+   {
+      self->port = &led_dummy_reg;
+      self->pin_reg = &led_dummy_reg;
+   }
+
+   self->io_port = gpio.io_port;
+   self->pin = gpio.pin;
+   self->mask = gpio.mask;
+   self->enabled = false;
+   self->blink_speed_ms = 0;
+   self->blink_counter_ms = 0;
+   self->blink_next = 0;
+   self->vptr = led_vptr_new();
+   return;
+}
+
+/********************************************************************************
+* led_clear: Nollställer lysdiod samt motsvarande pin. Eventuell asynkron
+*            blinkning av lysdioden avslutas. Tända lysdioder som inte är
+*            anslutna till en I/O-port, exempelvis via skiftregister, släcks
+*            via sitt vtable.
+*
+*            - self: Pekare till lysdioden som ska nollställas.
+********************************************************************************/
+void led_clear(led_t* self)
+{
+   led_blink_stop(self);
+
+   if (self->io_port == IO_PORTB)
+   {
+      clr(DDRB, self->pin);
+      clr(PORTB, self->pin);
+   }
+   else if (self->io_port == IO_PORTC)
+   {
+      clr(DDRC, self->pin);
+      clr(PORTC, self->pin);
+   }
+   else if (self->io_port == IO_PORTD)
+   {
+      clr(DDRD, self->pin);
+      clr(PORTD, self->pin);
+   }
+   else if (self->enabled)
+   {
+      self->vptr->off(self);
+   }
+
+   self->io_port = IO_PORT_NONE;
+   self->pin = 0;
+   self->mask = 0;
+   self->port = &led_dummy_reg;
+   self->pin_reg = &led_dummy_reg;
+   self->enabled = false;
+   return;
+}
+
+/********************************************************************************
+* led_new: Allokerar minne och initierar en ny lysdiod på angiven pin.
+*          En pekare returneras till lysdioden efter initieringen.
+*          Vid misslyckad minnesallokering returneras en nullpekare.
+*          Minnet allokeras från en statisk objektpool med kapacitet
+*          LED_POOL_SIZE, alternativt via malloc om kapaciteten är 0.
+*
+*          - pin : Lysdiodens pin-nummer på Arduino Uno, exempelvis 8.
+*                  Alternativt kan motsvarande port-nummer på ATmega328P
+*                  anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+********************************************************************************/
+led_t* (led_new)(const uint8_t pin)
+{
+#if LED_POOL_SIZE > 0
+   led_t* self = (led_t*)pool_alloc(&led_pool);
+#else
+   led_t* self = (led_t*)memstat_malloc(sizeof(led_t));
+#endif
+   if (!self) return 0;
+   led_init(self, pin);
+   memstat_object_add(MEMSTAT_LED);
+   return self;
+}
+
+/********************************************************************************
+* led_delete: Frigör minne allokerat för angiven lysdiod och sätter motsvarande
+*             pekare till null. För att kunna genomföra detta passeras adressen
+*             till den pekare som pekar på lysdioden.
+*
+*             - self: Adressen till den pekare som pekar på lysdioden.
+********************************************************************************/
+void led_delete(led_t** self)
+{
+   led_clear(*self);
+   memstat_object_remove(MEMSTAT_LED);
+#if LED_POOL_SIZE > 0
+   pool_free(&led_pool, *self);
+#else
+   memstat_free(*self);
+#endif
+   *self = 0;
+   return;
+}
+
+/********************************************************************************
+* led_pool_stats: Kopierar användningsstatistik för objektpoolen som används
+*                av led_new samt led_delete.
+*
+*                - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void led_pool_stats(pool_stats_t* stats)
+{
+#if LED_POOL_SIZE > 0
+   pool_get_stats(&led_pool, stats);
+#else
+   stats->capacity = 0;
+   stats->used = 0;
+   stats->high_water_mark = 0;
+   stats->failed = 0;
+#endif
+   return;
+}
+
+/********************************************************************************
+* led_on: Tänder angiven lysdiod. Porten uppdateras med avbrott inaktiverade,
+*         eftersom asynkron blinkning, blinkmönster samt mjukvaru-PWM skriver
+*         till samma portar från avbrottsrutiner.
+*
+*         - self: Pekare till lysdioden som ska tändas.
+********************************************************************************/
+static void led_on(led_t* self)
+{
+   uint8_t sreg;
+   trace_enter(TRACE_LED_ON);
+   atomic_begin(sreg);
+   *self->port |= self->mask;
+   self->enabled = true;
+   atomic_end(sreg);
+   trace_exit(TRACE_LED_ON);
+   return;
+}
+
+/********************************************************************************
+* led_off: Släcker angiven lysdiod. Porten uppdateras med avbrott
+*          inaktiverade, se led_on.
+*
+*          - self: Pekare till lysdioden som ska släckas.
+********************************************************************************/
+static void led_off(led_t* self)
+{
+   uint8_t sreg;
+   trace_enter(TRACE_LED_OFF);
+   atomic_begin(sreg);
+   *self->port &= ~self->mask;
+   self->enabled = false;
+   atomic_end(sreg);
+   trace_exit(TRACE_LED_OFF);
+   return;
+}
+
+/********************************************************************************
+* led_toggle: Togglar utsignalen på angiven lysdiod. Om lysdioden är släckt vid
+*             anropet så tänds den. På samma sätt gäller att om lysdioden är
+*             tänd vid anropet så släcks den. Togglingen sker via hårdvaran
+*             genom att lysdiodens bit ettställs i PINx, vilket genomförs med
+*             en enda skrivning och påverkar inga övriga pinnar på porten.
+*
+*             - self: Pekare till lysdioden vars utsignal ska togglas.
+********************************************************************************/
+static void led_toggle(led_t* self)
+{
+   trace_enter(TRACE_LED_TOGGLE);
+   *self->pin_reg = self->mask;
+   self->enabled = !self->enabled;
+   trace_exit(TRACE_LED_TOGGLE);
+   return;
+}
+
+/********************************************************************************
+* led_blink: Blinkar lysdiod en gång med angiven blinkhastighet.
+*
+*            - self          : Pekare till lysdioden som ska blinkas.
+*            - blink_speed_ms: Blinkhastigheten mätt i millisekunder.
+********************************************************************************/
+static void led_blink(led_t* self,
+                      const uint16_t blink_speed_ms)
+{
+   trace_enter(TRACE_LED_BLINK);
+   led_toggle(self);
+   delay_ms(blink_speed_ms);
+   trace_exit(TRACE_LED_BLINK);
+   return;
+}
+
+/********************************************************************************
+* led_vptr_new: Returnerar en pekare till ett vtable innehållande pekare till
+*               associerade funktioner för strukten led. När programmet startar
+*               sätts respektive pekare till att peka på motsvarande funktion.
+********************************************************************************/
+static led_vptr_t led_vptr_new(void)
+{
+   static struct led_vtable self = 
+   {
+      .on = led_on,
+      .off = led_off, 
+      .toggle = led_toggle,
+      .blink = led_blink,
+   };
+
+   return &self;
 }
\ No newline at end of file
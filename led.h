@@ -1,101 +1,160 @@
-/********************************************************************************
-* led.h: Innehller funktionalitet fr enkel implementering av lysdioder via
-*        strukten led samt associerade funktioner, som ns via en vtable-pekare. 
-*        Denna strukt fungerar ocks utmrkt fr andra digitala utportar.
-********************************************************************************/
-#ifndef LED_H_
-#define LED_H_
-
-/* Inkluderingsdirektiv: */
-#include "misc.h"
-
-struct led_vtable; /* Frdeklarerar infr deklaration av strukten led. */
-
-/********************************************************************************
-* led: Strukt fr implementering av lysdioder och andra digitala utportar.
-********************************************************************************/
-typedef struct led
-{
-   uint8_t pin;             /* Lysdiodens pin-nummer p aktuell I/O-port. */
-   enum io_port io_port;    /* I/O-port som lysdioden r ansluten till. */
-   bool enabled;            /* Indikerar ifall lysdioden r tnd. */
-   struct led_vtable* vptr; /* Pekare till vtable innehllande associerade funktioner. */
-} led_t, *led_ptr_t;
-
-/********************************************************************************
-* led_vtable: Strukt fr vtable innehllande funktionspekare till associerade
-*             funktioner fr strukten led.
-********************************************************************************/
-typedef struct led_vtable
-{
-   /********************************************************************************
-   * on: Tnder lysdioden.
-   *
-   *     - self: Pekare till lysdioden som ska tndas.
-   ********************************************************************************/
-   void (*on)(led_t* self); 
-
-   /********************************************************************************
-   * off: Slcker lysdioden.
-   *
-   *     - self: Pekare till lysdioden som ska slckas.
-   ********************************************************************************/                   
-   void (*off)(led_t* self);
-   
-   /********************************************************************************
-   * toggle: Togglar utsignalen p lysdioder frn tnd till slckt eller tvrtom.
-   *
-   *         - self: Pekare till lysdioden vars utsignal ska togglas.
-   ********************************************************************************/                    
-   void (*toggle)(led_t* self);  
-   
-   /********************************************************************************
-   * blink: Blinkar lysdioden en gng med angiven blinkhastighet. Fr kontinuerlig
-   *        blinkning mste denna funktion anropas i en fortgende loop.
-   *
-   *        - self: Pekare till lysdioden som ska blinkas.
-   ********************************************************************************/                  
-   void (*blink)(led_t* self, const uint16_t blink_speed_ms); 
-
-} *led_vptr_t;
-
-
-/********************************************************************************
-* led_init: Initierar ny lysdiod p angiven pin.
-*
-*           - self: Pekare till lysdioden som ska initieras.
-*           - pin : Lysdiodens pin-nummer p Arduino Uno, exempelvis 8. 
-*                   Alternativt kan motsvarande port-nummer p ATmega328P 
-*                   anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-void led_init(led_t* self, 
-              const uint8_t pin);
-
-/********************************************************************************
-* led_clear: Nollstller lysdiod samt motsvarande pin.
-*
-*            - self: Pekare till lysdioden som ska nollstllas.
-********************************************************************************/
-void led_clear(led_t* self);
-
-/********************************************************************************
-* led_new: Allokerar minne och initierar en ny lysdiod p angiven pin.
-*          En pekare returneras till lysdioden efter initieringen.
-*          Vid misslyckad minnesallokering returneras en nullpekare.
-*
-*          - pin : Lysdiodens pin-nummer p Arduino Uno, exempelvis 8.
-*                  Alternativt kan motsvarande port-nummer p ATmega328P
-*                  anges, exempelvis B0 fr pin 8 eller D2 fr pin 2.
-********************************************************************************/
-led_t* led_new(const uint8_t pin);
-
-/********************************************************************************
-* led_delete: Frigr minne allokerat fr angiven lysdiod och stter motsvarande
-*             pekare till null. Fr att kunna genomfra detta passeras adressen
-*             till den pekare som pekar p lysdioden.
-*
-*             - self: Adressen till den pekare som pekar p lysdioden.
-********************************************************************************/
-void led_delete(led_t** self);
-
+/********************************************************************************
+* led.h: Innehåller funktionalitet för enkel implementering av lysdioder via
+*        strukten led samt associerade funktioner, som nås via en vtable-pekare. 
+*        Denna strukt fungerar också utmärkt för andra digitala utportar.
+********************************************************************************/
+#ifndef LED_H_
+#define LED_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "pool.h"
+#include "gpio.h"
+
+/* Makrodefinitioner: */
+#ifndef LED_POOL_SIZE
+#define LED_POOL_SIZE 8 /* Kapacitet för objektpoolen som används av led_new, 0 = malloc. */
+#endif
+
+#if LED_POOL_SIZE > POOL_MAX_CAPACITY
+#error "LED_POOL_SIZE får vara högst POOL_MAX_CAPACITY (255)!"
+#endif
+
+struct led_vtable; /* Fördeklarerar inför deklaration av strukten led. */
+
+/********************************************************************************
+* led: Strukt för implementering av lysdioder och andra digitala utportar.
+********************************************************************************/
+typedef struct led
+{
+   uint8_t pin;               /* Lysdiodens pin-nummer på aktuell I/O-port. */
+   enum io_port io_port;      /* I/O-port som lysdioden är ansluten till. */
+   bool enabled;              /* Indikerar ifall lysdioden är tänd. */
+   uint8_t mask;              /* Bitmask för lysdiodens pin i portregistret. */
+   volatile uint8_t* port;    /* Pekare till portregistret PORTx, beräknas vid initiering. */
+   volatile uint8_t* pin_reg; /* Pekare till pinregistret PINx, används för toggling. */
+   uint16_t blink_speed_ms;   /* Blinkhastighet vid asynkron blinkning, 0 = inaktiv. */
+   uint16_t blink_counter_ms; /* Förfluten tid sedan senaste toggling vid asynkron blinkning. */
+   struct led* blink_next;    /* Nästa lysdiod i listan över asynkront blinkande lysdioder. */
+   struct led_vtable* vptr;   /* Pekare till vtable innehållande associerade funktioner. */
+} led_t, *led_ptr_t;
+
+/********************************************************************************
+* led_vtable: Strukt för vtable innehållande funktionspekare till associerade
+*             funktioner för strukten led.
+********************************************************************************/
+typedef struct led_vtable
+{
+   /********************************************************************************
+   * on: Tänder lysdioden.
+   *
+   *     - self: Pekare till lysdioden som ska tändas.
+   ********************************************************************************/
+   void (*on)(led_t* self); 
+
+   /********************************************************************************
+   * off: Släcker lysdioden.
+   *
+   *     - self: Pekare till lysdioden som ska släckas.
+   ********************************************************************************/                   
+   void (*off)(led_t* self);
+   
+   /********************************************************************************
+   * toggle: Togglar utsignalen på lysdioder från tänd till släckt eller tvärtom.
+   *
+   *         - self: Pekare till lysdioden vars utsignal ska togglas.
+   ********************************************************************************/                    
+   void (*toggle)(led_t* self);  
+   
+   /********************************************************************************
+   * blink: Blinkar lysdioden en gång med angiven blinkhastighet. För kontinuerlig
+   *        blinkning måste denna funktion anropas i en fortgående loop.
+   *
+   *        - self: Pekare till lysdioden som ska blinkas.
+   ********************************************************************************/                  
+   void (*blink)(led_t* self, const uint16_t blink_speed_ms); 
+
+} *led_vptr_t;
+
+/********************************************************************************
+* led_static_init, led_static_on, led_static_off, led_static_toggle,
+* led_static_is_enabled: Statisk åtkomst av lysdiod på konstant pin, som
+*                        alternativ till strukten led när pin-numret är känt
+*                        vid kompilering. Register samt bitmask väljs då vid
+*                        kompilering, vilket medför att tändning och släckning
+*                        kompileras till en enda sbi- respektive cbi-
+*                        instruktion utan vtable eller kontroll av I/O-port.
+*                        Toggling sker via skrivning till PINx. För pin-nummer
+*                        som väljs under körning används strukten led.
+*                        Ogiltiga pin-nummer avbryter kompileringen.
+*
+*                        - pin: Lysdiodens pin-nummer på Arduino Uno, som
+*                               måste vara en konstant, exempelvis 8 eller B0.
+********************************************************************************/
+#define led_static_init(pin) (gpio_check(pin), pin_ddrx(pin) |= pin_mask(pin))
+#define led_static_on(pin) (gpio_check(pin), pin_portx(pin) |= pin_mask(pin))
+#define led_static_off(pin) (gpio_check(pin), pin_portx(pin) &= ~pin_mask(pin))
+#define led_static_toggle(pin) (gpio_check(pin), pin_pinx(pin) = pin_mask(pin))
+#define led_static_is_enabled(pin) (gpio_check(pin), (pin_portx(pin) & pin_mask(pin)) ? true : false)
+
+/********************************************************************************
+* led_init: Initierar ny lysdiod på angiven pin.
+*
+*           - self: Pekare till lysdioden som ska initieras.
+*           - pin : Lysdiodens pin-nummer på Arduino Uno, exempelvis 8. 
+*                   Alternativt kan motsvarande port-nummer på ATmega328P 
+*                   anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+*                   Konstanta pin-nummer kontrolleras vid kompilering.
+********************************************************************************/
+void led_init(led_t* self, 
+              const uint8_t pin);
+#define led_init(self, pin) ({ \
+   gpio_check(pin); \
+   led_init(self, pin); \
+})
+
+/********************************************************************************
+* led_clear: Nollställer lysdiod samt motsvarande pin. Eventuell asynkron
+*            blinkning av lysdioden avslutas.
+*
+*            - self: Pekare till lysdioden som ska nollställas.
+********************************************************************************/
+void led_clear(led_t* self);
+
+/********************************************************************************
+* led_new: Allokerar minne och initierar en ny lysdiod på angiven pin.
+*          En pekare returneras till lysdioden efter initieringen.
+*          Vid misslyckad minnesallokering returneras en nullpekare.
+*          Minnet allokeras från en statisk objektpool med kapacitet
+*          LED_POOL_SIZE, alternativt via malloc om kapaciteten är 0.
+*
+*          - pin : Lysdiodens pin-nummer på Arduino Uno, exempelvis 8.
+*                  Alternativt kan motsvarande port-nummer på ATmega328P
+*                  anges, exempelvis B0 för pin 8 eller D2 för pin 2.
+*                  Konstanta pin-nummer kontrolleras vid kompilering.
+********************************************************************************/
+led_t* led_new(const uint8_t pin);
+#define led_new(pin) ({ \
+   gpio_check(pin); \
+   led_new(pin); \
+})
+
+/********************************************************************************
+* led_delete: Frigör minne allokerat för angiven lysdiod och sätter motsvarande
+*             pekare till null. För att kunna genomföra detta passeras adressen
+*             till den pekare som pekar på lysdioden.
+*
+*             - self: Adressen till den pekare som pekar på lysdioden.
+********************************************************************************/
+void led_delete(led_t** self);
+
+/********************************************************************************
+* led_pool_stats: Kopierar användningsstatistik för objektpoolen som används
+*                 av led_new samt led_delete. Ifall objektpoolen är
+*                 inaktiverad via LED_POOL_SIZE 0 sätts samtliga värden till 0.
+*
+*                 - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void led_pool_stats(pool_stats_t* stats);
+
 #endif /* LED_H_ */
\ No newline at end of file
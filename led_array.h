@@ -1,187 +1,563 @@
-/********************************************************************************
-* led_array.h: Innehller makroliknande funktioner fr implementering av
-*              dynamiska arrayer innehllande lysdioder i form av pekare till
-*              objekt av strukten led.
-********************************************************************************/
-#ifndef LED_ARRAY_H_
-#define LED_ARRAY_H_
-
-/* Inkluderingsdirektiv: */
-#include "misc.h"
-#include "led.h"
-
-/********************************************************************************
-* led_array_new: Allokerar minne fr ny dynamisk array av angiven storlek och
-*                returnerar en pekare till denna.
-*
-*                - size: Arrayens storlek, dvs. antalet led-objekt den rymmer.
-********************************************************************************/
-#define led_array_new(size) (led_t**)malloc(sizeof(led_t*) * size)
-
-/********************************************************************************
-* led_array_delete: Tmmer dynamisk array av angiven storlek. Lysdioderna
-*                   lagrade i arrayen mste dock nollstllas manuellt.
-*                   Adressen till den pekare som pekar p arrayen passeras fr
-*                   att bde kunna frigra minnet och stta pekaren till null.
-*
-*                   - self: Adressen till den pekare som pekar p arrayen.
-********************************************************************************/
-#define led_array_delete(self) ({ \
-   free(*self); \
-   *self = 0; \
-})
-
-/********************************************************************************
-* led_array_resize: ndrar storlek p befintlig led-array till ny storlek. 
-*                   Ifall arrayens storlek lyckas ndras s uppdateras den 
-*                   variabel som lagrar arrayens storlek och 0 returneras 0.
-*                   Annars returneras felkod 1. 
-*
-*                   - self    : Pekare till arrayen vars storlek ska ndras.
-*                   - new_size: Arrayens nya storlek.
-*                   - size    : Pekare till variabel som lagrar aktuell storlek.
-********************************************************************************/
-#define led_array_resize(self, new_size, size) ({ \
-   int ret_val = 0; \
-   led_t** copy = (led_t**)realloc(*self, sizeof(led_t*) * new_size); \
-   if (!copy) { \
-      ret_val = 1; \
-   } else { \
-      *self = copy; \
-      *size = new_size; \
-   } \
-   ret_val; \
-})
-
-/********************************************************************************
-* led_array_push: Lgger till ett nytt led-objekt lngst bak i angiven array
-*                 och rknar upp antalet element efter tillgget.
-*                 Vid misslyckad minnesallokering returneras felkod 1.
-*                 Annars om push-operationen lyckas returneras 0.
-*
-*                 - self   : Pekare till array som ska tilldelas.
-*                 - size   : Pekare till variabel innehllande arrayens storlek, 
-*                            dvs. antalet lysdioder i arrayen.
-*                 - new_led: Det nya led-objekt som ska lggas till.
-********************************************************************************/
-#define led_array_push(self, size, new_led) ({ \
-   int ret_val = 0; \
-   led_t** copy = (led_t**)realloc(*self, sizeof(led_t*) * (*size + 1)); \
-   if (!copy) ret_val = 1; \
-   copy[(*size)++] = new_led; \
-   *self = copy; \
-   ret_val; \
-})
-
-/********************************************************************************
-* led_array_pop: Tar bort eventuellt sista led-objekt i angiven array genom
-*                att minska dess storlek med ett. Vid misslyckad omallokering
-*                returneras felkod 1, annars 0.
-*
-*                - self: Pekare till arrayen vars sista element ska tas bort.
-*                - size: Arrayens storlek, dvs. antalet lysdioder i arrayen.
-********************************************************************************/
-#define led_array_pop(self, size) ({ \
-   int ret_val = 0; \
-   if ((*size) <= 1) { \
-      led_array_delete(self); \
-      *size = 0; \
-   } else { \
-      led_t** copy = (led_t**)realloc(self, sizeof(led_t*) * (*size - 1)); \
-      if (!copy) ret_val = 1; \
-      else { \
-         self = copy; \
-         (*size)--; \
-      } \
-   } \
-   ret_val; \
-})
-
-/********************************************************************************
-* led_array_on: Tnder samtliga lysdioder lagrade i angiven array.
-*
-*               - self: Pekare till arrayen vars lysdioder ska tndas.
-*               - size: Arrayens storlek, dvs. antalet lysdioder i arrayen.
-********************************************************************************/
-#define led_array_on(self, size) ({ \
-   led_t** i; \
-   for (i = self; i < self + size; ++i) { \
-      (*i)->vptr->on(*i); \
-   } \
-})
-
-/********************************************************************************
-* led_array_off: Slcker samtliga lysdioder lagrade i angiven array.
-*
-*                - self: Pekare till arrayen vars lysdioder ska slckas.
-*                - size: Arrayens storlek, dvs. antalet lysdioder i arrayen.
-********************************************************************************/
-#define led_array_off(self, size) ({ \
-   led_t** i; \
-   for (i = self; i < self + size; ++i) { \
-      (*i)->vptr->off(*i); \
-   } \
-})
-
-
-/********************************************************************************
-* led_array_blink_forward: Genomfr sekventiell blinkning framt av samtliga
-*                          lysdioder lagrade i angiven array. Drmed blinkar
-*                          lysdioderna framt i en sekvens en efter en.
-*
-*                          - self          : Pekare till arrayen vars lysdioder
-*                                            ska blinkas.
-*                          - size          : Arrayens storlek, dvs. antalet
-*                                            lysdioder i arrayen.
-*                          - blink_speed_ms: Lysdiodernas blinkhastighet mtt
-*                                            i millisekunder.
-********************************************************************************/
-#define led_array_blink_forward(self, size, blink_speed_ms) ({ \
-   led_t** i; \
-   for (i = self; i < self + size; ++i) { \
-      (*i)->vptr->on(*i); \
-      delay_ms(blink_speed_ms); \
-      (*i)->vptr->off(*i); \
-   } \
-})
-
-/********************************************************************************
-* led_array_blink_backward: Genomfr sekventiell blinkning bakt av samtliga
-*                           lysdioder lagrade i angiven array. Drmed blinkar
-*                           lysdioderna bakt i en sekvens en efter en.
-*
-*                           - self          : Pekare till arrayen vars lysdioder
-*                                             ska blinkas.
-*                           - size          : Arrayens storlek, dvs. antalet
-*                                             lysdioder i arrayen.
-*                           - blink_speed_ms: Lysdiodernas blinkhastighet mtt
-*                                             i millisekunder.
-********************************************************************************/
-#define led_array_blink_backward(self, size, blink_speed_ms) ({ \
-   led_t** i; \
-   for (i = self + size - 1; i >= self; --i) { \
-      (*i)->vptr->on(*i); \
-      delay_ms(blink_speed_ms); \
-      (*i)->vptr->off(*i); \
-   } \
-})
-
-/********************************************************************************
-* led_array_blink_collectively: Genomfr kollektiv (synkroniserad) blinkning
-*                               av samtliga lysdioder lagrade i angiven array.
-*
-*                               - self          : Pekare till arrayen vars
-*                                                 lysdioder ska blinkas.
-*                               - size          : Arrayens storlek, dvs.
-*                                                 antalet lysdioder i arrayen.
-*                               - blink_speed_ms: Lysdiodernas blinkhastighet
-*                                                 mtt i millisekunder.
-********************************************************************************/
-#define led_array_blink_collectively(self, size, blink_speed_ms) ({ \
-   led_array_on(self, size); \
-   delay_ms(blink_speed_ms); \
-   led_array_off(self, size); \
-   delay_ms(blink_speed_ms); \
-})
-
+/********************************************************************************
+* led_array.h: Innehåller makroliknande funktioner för implementering av
+*              arrayer innehållande lysdioder i form av pekare till objekt av
+*              strukten led. Arrayen lagras i strukten led_array, som håller
+*              reda på både storlek och kapacitet. Minnet allokeras antingen
+*              dynamiskt, där kapaciteten fördubblas vid behov, eller
+*              tillhandahålls av användaren i form av en statisk array.
+*
+*              Arrayen kan läsas av från avbrottsrutiner, exempelvis vid
+*              asynkron blinkning eller uppspelning av blinkmönster. Därför
+*              ersätts dynamiskt minne aldrig på plats via realloc. Nytt
+*              minne allokeras och fylls först, varefter pekaren, kapaciteten
+*              och storleken byts med avbrott inaktiverade via
+*              led_array_replace. Först därefter frigörs det gamla minnet.
+********************************************************************************/
+#ifndef LED_ARRAY_H_
+#define LED_ARRAY_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led.h"
+#include "memstat.h"
+#include "trace.h"
+
+/********************************************************************************
+* led_array_mask: Strukt innehållande förberäknade bitmasker för lysdioder
+*                 lagrade i en led-array, en mask per I/O-port. Via dessa kan
+*                 samtliga lysdioder i arrayen uppdateras med högst tre
+*                 registerskrivningar, oavsett antalet lysdioder.
+********************************************************************************/
+typedef struct led_array_mask
+{
+   uint8_t portb; /* Bitmask för lysdioder anslutna till I/O-port B. */
+   uint8_t portc; /* Bitmask för lysdioder anslutna till I/O-port C. */
+   uint8_t portd; /* Bitmask för lysdioder anslutna till I/O-port D. */
+} led_array_mask_t;
+
+/********************************************************************************
+* led_array: Strukt för implementering av arrayer innehållande lysdioder.
+*            Kapaciteten anger hur många lysdioder som ryms innan nytt minne
+*            måste allokeras. Vid dynamisk allokering fördubblas kapaciteten
+*            när arrayen blir full, vilket medför att tillägg av lysdioder
+*            i genomsnitt sker i konstant tid. Portmasken uppdateras när
+*            lysdioder läggs till eller tas bort.
+********************************************************************************/
+typedef struct led_array
+{
+   led_t** leds;          /* Pekare till arrayens lysdioder. */
+   size_t size;           /* Arrayens storlek, dvs. antalet lysdioder. */
+   size_t capacity;       /* Antalet lysdioder som ryms i allokerat minne. */
+   bool static_storage;   /* Indikerar ifall minnet tillhandahålls av användaren. */
+   led_array_mask_t mask; /* Förberäknade bitmasker för arrayens lysdioder. */
+} led_array_t;
+
+/* Makrodefinitioner: */
+#define LED_ARRAY_MIN_CAPACITY 4 /* Kapacitet vid första dynamiska allokering. */
+
+/********************************************************************************
+* led_array_init: Initierar ny tom led-array, vars minne allokeras dynamiskt
+*                 när lysdioder läggs till.
+*
+*                 - self: Pekare till arrayen som ska initieras.
+********************************************************************************/
+#define led_array_init(self) ({ \
+   (self)->leds = 0; \
+   (self)->size = 0; \
+   (self)->capacity = 0; \
+   (self)->static_storage = false; \
+   led_array_mask_init(&(self)->mask); \
+})
+
+/********************************************************************************
+* led_array_init_static: Initierar ny tom led-array som använder angiven
+*                        array som minne. Därmed sker ingen dynamisk
+*                        minnesallokering, utan arrayen rymmer som mest
+*                        angiven kapacitet.
+*
+*                        - self            : Pekare till arrayen som ska
+*                                            initieras.
+*                        - storage         : Array av led-pekare som utgör
+*                                            arrayens minne.
+*                        - storage_capacity: Antalet lysdioder som ryms i
+*                                            minnet.
+********************************************************************************/
+#define led_array_init_static(self, storage, storage_capacity) ({ \
+   (self)->leds = storage; \
+   (self)->size = 0; \
+   (self)->capacity = storage_capacity; \
+   (self)->static_storage = true; \
+   led_array_mask_init(&(self)->mask); \
+})
+
+/********************************************************************************
+* led_array_replace: Byter minne, kapacitet samt storlek för angiven led-array
+*                    med avbrott inaktiverade, varefter det gamla minnet
+*                    frigörs. Därmed kan en avbrottsrutin som läser av
+*                    arrayen aldrig se frigjort minne eller en storlek som
+*                    överstiger kapaciteten. Används internt av
+*                    led_array_clear, led_array_reserve samt
+*                    led_array_shrink_to_fit för dynamiskt minne.
+*
+*                    - self        : Pekare till arrayen.
+*                    - new_leds    : Arrayens nya minne, eller null.
+*                    - new_capacity: Antalet lysdioder som ryms i det nya
+*                                    minnet.
+*                    - new_size    : Arrayens nya storlek.
+********************************************************************************/
+#define led_array_replace(self, new_leds, new_capacity, new_size) ({ \
+   led_t** const replace_old = (self)->leds; \
+   uint8_t replace_sreg; \
+   atomic_begin(replace_sreg); \
+   (self)->leds = (new_leds); \
+   (self)->capacity = (new_capacity); \
+   (self)->size = (new_size); \
+   atomic_end(replace_sreg); \
+   memstat_free(replace_old); \
+})
+
+/********************************************************************************
+* led_array_copy: Allokerar nytt minne rymmande angiven kapacitet och
+*                 kopierar de första angivna antalet lysdioder från angiven
+*                 led-array dit. En pekare till det nya minnet returneras,
+*                 eller en nullpekare vid misslyckad minnesallokering.
+*
+*                 - self    : Pekare till arrayen vars lysdioder kopieras.
+*                 - capacity: Antalet lysdioder som ska rymmas.
+*                 - count   : Antalet lysdioder som ska kopieras.
+********************************************************************************/
+#define led_array_copy(self, capacity, count) ({ \
+   led_t** const copy_leds = (led_t**)memstat_malloc(sizeof(led_t*) * (capacity)); \
+   size_t copy_i; \
+   if (copy_leds) { \
+      for (copy_i = 0; copy_i < (count); ++copy_i) { \
+         copy_leds[copy_i] = (self)->leds[copy_i]; \
+      } \
+   } \
+   copy_leds; \
+})
+
+/********************************************************************************
+* led_array_clear: Tömmer angiven led-array och frigör eventuellt dynamiskt
+*                  allokerat minne. Lysdioderna lagrade i arrayen måste dock
+*                  nollställas manuellt. Efter anropet är arrayen tom och kan
+*                  återanvändas.
+*
+*                  - self: Pekare till arrayen som ska tömmas.
+********************************************************************************/
+#define led_array_clear(self) ({ \
+   if (!(self)->static_storage) { \
+      if ((self)->leds) memstat_object_remove(MEMSTAT_LED_ARRAY); \
+      led_array_replace(self, 0, 0, 0); \
+   } else { \
+      uint8_t clear_sreg; \
+      atomic_begin(clear_sreg); \
+      (self)->size = 0; \
+      atomic_end(clear_sreg); \
+   } \
+   led_array_mask_init(&(self)->mask); \
+})
+
+/********************************************************************************
+* led_array_reserve: Säkerställer att angiven led-array rymmer minst angivet
+*                    antal lysdioder utan ytterligare minnesallokering.
+*                    Ifall kapaciteten redan räcker eller lyckas utökas
+*                    returneras 0. Vid misslyckad minnesallokering eller
+*                    otillräckligt statiskt minne returneras felkod 1.
+*
+*                    - self        : Pekare till arrayen vars kapacitet ska
+*                                    utökas.
+*                    - new_capacity: Arrayens nya minimala kapacitet.
+********************************************************************************/
+#define led_array_reserve(self, new_capacity) ({ \
+   int reserve_ret_val = 0; \
+   const size_t reserve_capacity = (new_capacity); \
+   if (reserve_capacity > (self)->capacity) { \
+      if ((self)->static_storage) { \
+         reserve_ret_val = 1; \
+      } else { \
+         led_t** const reserve_leds = led_array_copy(self, reserve_capacity, (self)->size); \
+         if (!reserve_leds) { \
+            reserve_ret_val = 1; \
+         } else { \
+            if (!(self)->leds) memstat_object_add(MEMSTAT_LED_ARRAY); \
+            led_array_replace(self, reserve_leds, reserve_capacity, (self)->size); \
+         } \
+      } \
+   } \
+   reserve_ret_val; \
+})
+
+/********************************************************************************
+* led_array_shrink_to_fit: Minskar kapaciteten på angiven dynamiskt allokerad
+*                          led-array till dess storlek, så att inget minne
+*                          är outnyttjat. För statiskt minne sker ingenting.
+*                          Vid misslyckad omallokering returneras felkod 1,
+*                          annars 0.
+*
+*                          - self: Pekare till arrayen vars kapacitet ska
+*                                  minskas.
+********************************************************************************/
+#define led_array_shrink_to_fit(self) ({ \
+   int ret_val = 0; \
+   if (!(self)->static_storage && (self)->size < (self)->capacity) { \
+      if (!(self)->size) { \
+         memstat_object_remove(MEMSTAT_LED_ARRAY); \
+         led_array_replace(self, 0, 0, 0); \
+      } else { \
+         led_t** const shrink_leds = led_array_copy(self, (self)->size, (self)->size); \
+         if (!shrink_leds) { \
+            ret_val = 1; \
+         } else { \
+            led_array_replace(self, shrink_leds, (self)->size, (self)->size); \
+         } \
+      } \
+   } \
+   ret_val; \
+})
+
+/********************************************************************************
+* led_array_push: Lägger till ett nytt led-objekt längst bak i angiven array
+*                 och räknar upp antalet element efter tillägget. Ifall
+*                 arrayen är full fördubblas dess kapacitet, vilket medför
+*                 att tillägg i genomsnitt sker i konstant tid. Portmasken
+*                 uppdateras med den nya lysdioden. Vid misslyckad
+*                 minnesallokering eller full statisk array returneras
+*                 felkod 1. Annars om push-operationen lyckas returneras 0.
+*                 Den nya lysdioden lagras innan storleken räknas upp, vilket
+*                 sker med avbrott inaktiverade, så att arrayen kan läsas av
+*                 från avbrottsrutiner under tillägget.
+*
+*                 - self   : Pekare till array som ska tilldelas.
+*                 - new_led: Det nya led-objekt som ska läggas till. Uttrycket
+*                            beräknas exakt en gång.
+********************************************************************************/
+#define led_array_push(self, new_led) ({ \
+   led_t* const push_led = (new_led); \
+   uint8_t push_sreg; \
+   int ret_val = 0; \
+   if ((self)->size == (self)->capacity && \
+       led_array_reserve(self, (self)->capacity ? (self)->capacity * 2 : LED_ARRAY_MIN_CAPACITY)) { \
+      ret_val = 1; \
+   } else { \
+      (self)->leds[(self)->size] = push_led; \
+      atomic_begin(push_sreg); \
+      (self)->size++; \
+      atomic_end(push_sreg); \
+      led_array_mask_add(&(self)->mask, push_led); \
+   } \
+   ret_val; \
+})
+
+/********************************************************************************
+* led_array_pop: Tar bort eventuellt sista led-objekt i angiven array genom
+*                att minska dess storlek med ett. Kapaciteten lämnas
+*                oförändrad, vilket medför att ingen omallokering sker.
+*                Portmasken beräknas om. Ifall arrayen är tom returneras
+*                felkod 1, annars 0.
+*
+*                - self: Pekare till arrayen vars sista element ska tas bort.
+********************************************************************************/
+#define led_array_pop(self) ({ \
+   uint8_t pop_sreg; \
+   int ret_val = 0; \
+   if (!(self)->size) { \
+      ret_val = 1; \
+   } else { \
+      atomic_begin(pop_sreg); \
+      (self)->size--; \
+      atomic_end(pop_sreg); \
+      led_array_mask_update(&(self)->mask, (self)->leds, (self)->size); \
+   } \
+   ret_val; \
+})
+
+/********************************************************************************
+* led_array_native_enable: Sätter medlemmen enabled för samtliga lysdioder i
+*                          angiven array som är anslutna direkt till en
+*                          I/O-port, dvs. de som ingår i arrayens portmask.
+*                          Används internt av led_array_on samt
+*                          led_array_off, med avbrott inaktiverade, så att
+*                          portarna och enabled aldrig är osynkroniserade
+*                          för en avbrottsrutin.
+*
+*                          - self : Pekare till arrayen.
+*                          - state: Lysdiodernas nya tillstånd.
+********************************************************************************/
+#define led_array_native_enable(self, state) ({ \
+   led_t** enable_i; \
+   for (enable_i = (self)->leds; enable_i < (self)->leds + (self)->size; ++enable_i) { \
+      if ((*enable_i)->io_port != IO_PORT_NONE) (*enable_i)->enabled = (state); \
+   } \
+})
+
+/********************************************************************************
+* led_array_on: Tänder samtliga lysdioder lagrade i angiven array. Lysdioder
+*               anslutna direkt till en I/O-port tänds via arrayens portmask,
+*               med högst en skrivning per I/O-port och utan anrop via
+*               vtable. Portarna samt lysdiodernas medlem enabled uppdateras
+*               med avbrott inaktiverade. Övriga lysdioder, exempelvis i
+*               skiftregister eller matriser, tänds via sina vtable.
+*
+*               - self: Pekare till arrayen vars lysdioder ska tändas.
+********************************************************************************/
+#define led_array_on(self) ({ \
+   led_t** i; \
+   uint8_t on_sreg; \
+   trace_enter(TRACE_LED_ARRAY_ON); \
+   atomic_begin(on_sreg); \
+   if ((self)->mask.portb) PORTB |= (self)->mask.portb; \
+   if ((self)->mask.portc) PORTC |= (self)->mask.portc; \
+   if ((self)->mask.portd) PORTD |= (self)->mask.portd; \
+   led_array_native_enable(self, true); \
+   atomic_end(on_sreg); \
+   for (i = (self)->leds; i < (self)->leds + (self)->size; ++i) { \
+      if ((*i)->io_port == IO_PORT_NONE) (*i)->vptr->on(*i); \
+   } \
+   trace_exit(TRACE_LED_ARRAY_ON); \
+})
+
+/********************************************************************************
+* led_array_off: Släcker samtliga lysdioder lagrade i angiven array, på
+*                samma sätt som led_array_on.
+*
+*                - self: Pekare till arrayen vars lysdioder ska släckas.
+********************************************************************************/
+#define led_array_off(self) ({ \
+   led_t** i; \
+   uint8_t off_sreg; \
+   trace_enter(TRACE_LED_ARRAY_OFF); \
+   atomic_begin(off_sreg); \
+   if ((self)->mask.portb) PORTB &= ~(self)->mask.portb; \
+   if ((self)->mask.portc) PORTC &= ~(self)->mask.portc; \
+   if ((self)->mask.portd) PORTD &= ~(self)->mask.portd; \
+   led_array_native_enable(self, false); \
+   atomic_end(off_sreg); \
+   for (i = (self)->leds; i < (self)->leds + (self)->size; ++i) { \
+      if ((*i)->io_port == IO_PORT_NONE) (*i)->vptr->off(*i); \
+   } \
+   trace_exit(TRACE_LED_ARRAY_OFF); \
+})
+
+/********************************************************************************
+* led_array_mask_init: Nollställer angiven portmask, så att den inte omfattar
+*                      några lysdioder.
+*
+*                      - mask: Pekare till portmasken som ska nollställas.
+********************************************************************************/
+#define led_array_mask_init(mask) ({ \
+   (mask)->portb = 0; \
+   (mask)->portc = 0; \
+   (mask)->portd = 0; \
+})
+
+/********************************************************************************
+* led_array_mask_add: Lägger till angiven lysdiods bit i portmasken för den
+*                     I/O-port som lysdioden är ansluten till. Anropas
+*                     automatiskt av led_array_push.
+*
+*                     - mask: Pekare till portmasken som ska uppdateras.
+*                     - led : Pekare till lysdioden som ska läggas till.
+********************************************************************************/
+#define led_array_mask_add(mask, led) ({ \
+   if ((led)->io_port == IO_PORTB) { \
+      set((mask)->portb, (led)->pin); \
+   } else if ((led)->io_port == IO_PORTC) { \
+      set((mask)->portc, (led)->pin); \
+   } else if ((led)->io_port == IO_PORTD) { \
+      set((mask)->portd, (led)->pin); \
+   } \
+})
+
+/********************************************************************************
+* led_array_mask_update: Beräknar om portmasken utifrån samtliga lysdioder
+*                        lagrade i angiven array. Anropas automatiskt av
+*                        led_array_pop.
+*
+*                        - mask: Pekare till portmasken som ska beräknas.
+*                        - leds: Pekare till de lysdioder som ska ingå.
+*                        - size: Antalet lysdioder.
+********************************************************************************/
+#define led_array_mask_update(mask, leds, size) ({ \
+   led_t** i; \
+   led_array_mask_init(mask); \
+   for (i = (leds); i < (leds) + (size); ++i) { \
+      led_array_mask_add(mask, *i); \
+   } \
+})
+
+/********************************************************************************
+* led_array_mask_write: Uppdaterar angivet portregister via angivet uttryck
+*                       med avbrott inaktiverade, så att en avbrottsrutin
+*                       som skriver till samma port, exempelvis vid asynkron
+*                       blinkning eller mjukvaru-PWM, inte kan avbryta
+*                       läs-modifiera-skriv-operationen och få sin
+*                       uppdatering förlorad.
+*
+*                       - port : Portregistret som ska uppdateras.
+*                       - value: Uttryck för registrets nya värde.
+********************************************************************************/
+#define led_array_mask_write(port, value) ({ \
+   uint8_t write_sreg; \
+   atomic_begin(write_sreg); \
+   port = (value); \
+   atomic_end(write_sreg); \
+})
+
+/********************************************************************************
+* led_array_mask_on: Tänder samtliga lysdioder som ingår i angiven portmask.
+*                    Högst en skrivning sker per I/O-port, vilket medför att
+*                    lysdioder på samma port tänds på samma klockcykel.
+*                    Varje port uppdateras med avbrott inaktiverade.
+*                    Lysdiodernas medlem enabled uppdateras inte.
+*
+*                    - mask: Pekare till portmasken vars lysdioder ska tändas.
+********************************************************************************/
+#define led_array_mask_on(mask) ({ \
+   trace_enter(TRACE_LED_ARRAY_MASK_ON); \
+   if ((mask)->portb) led_array_mask_write(PORTB, PORTB | (mask)->portb); \
+   if ((mask)->portc) led_array_mask_write(PORTC, PORTC | (mask)->portc); \
+   if ((mask)->portd) led_array_mask_write(PORTD, PORTD | (mask)->portd); \
+   trace_exit(TRACE_LED_ARRAY_MASK_ON); \
+})
+
+/********************************************************************************
+* led_array_mask_off: Släcker samtliga lysdioder som ingår i angiven portmask.
+*                     Högst en skrivning sker per I/O-port, med avbrott
+*                     inaktiverade. Lysdiodernas medlem enabled uppdateras
+*                     inte.
+*
+*                     - mask: Pekare till portmasken vars lysdioder ska släckas.
+********************************************************************************/
+#define led_array_mask_off(mask) ({ \
+   trace_enter(TRACE_LED_ARRAY_MASK_OFF); \
+   if ((mask)->portb) led_array_mask_write(PORTB, PORTB & ~(mask)->portb); \
+   if ((mask)->portc) led_array_mask_write(PORTC, PORTC & ~(mask)->portc); \
+   if ((mask)->portd) led_array_mask_write(PORTD, PORTD & ~(mask)->portd); \
+   trace_exit(TRACE_LED_ARRAY_MASK_OFF); \
+})
+
+/********************************************************************************
+* led_array_mask_toggle: Togglar samtliga lysdioder som ingår i angiven
+*                        portmask. Ettställning av bitar i PINx medför att
+*                        motsvarande bitar i PORTx togglas av hårdvaran, vilket
+*                        ger en enda skrivning per I/O-port utan föregående
+*                        läsning. Lysdiodernas medlem enabled uppdateras inte.
+*
+*                        - mask: Pekare till portmasken vars lysdioder ska
+*                                togglas.
+********************************************************************************/
+#define led_array_mask_toggle(mask) ({ \
+   trace_enter(TRACE_LED_ARRAY_MASK_TOGGLE); \
+   if ((mask)->portb) PINB = (mask)->portb; \
+   if ((mask)->portc) PINC = (mask)->portc; \
+   if ((mask)->portd) PIND = (mask)->portd; \
+   trace_exit(TRACE_LED_ARRAY_MASK_TOGGLE); \
+})
+
+/********************************************************************************
+* led_array_mask_set: Sätter samtliga lysdioder som ingår i angiven portmask
+*                     enligt angivet mönster. Lysdioder vars bit är ettställd
+*                     i mönstret tänds, övriga släcks. Bitar i mönstret som
+*                     ligger utanför portmasken ignoreras. Högst en skrivning
+*                     sker per I/O-port, med avbrott inaktiverade.
+*                     Lysdiodernas medlem enabled uppdateras inte.
+*
+*                     - mask   : Pekare till portmasken som ska uppdateras.
+*                     - pattern: Pekare till portmask innehållande de
+*                                lysdioder som ska vara tända.
+********************************************************************************/
+#define led_array_mask_set(mask, pattern) ({ \
+   trace_enter(TRACE_LED_ARRAY_MASK_SET); \
+   if ((mask)->portb) \
+      led_array_mask_write(PORTB, (PORTB & ~(mask)->portb) | ((pattern)->portb & (mask)->portb)); \
+   if ((mask)->portc) \
+      led_array_mask_write(PORTC, (PORTC & ~(mask)->portc) | ((pattern)->portc & (mask)->portc)); \
+   if ((mask)->portd) \
+      led_array_mask_write(PORTD, (PORTD & ~(mask)->portd) | ((pattern)->portd & (mask)->portd)); \
+   trace_exit(TRACE_LED_ARRAY_MASK_SET); \
+})
+
+/********************************************************************************
+* led_array_mask_blink_collectively: Genomför kollektiv (synkroniserad)
+*                                    blinkning av samtliga lysdioder som ingår
+*                                    i angiven portmask.
+*
+*                                    - mask          : Pekare till portmasken
+*                                                      vars lysdioder ska
+*                                                      blinkas.
+*                                    - blink_speed_ms: Lysdiodernas
+*                                                      blinkhastighet mätt i
+*                                                      millisekunder.
+********************************************************************************/
+#define led_array_mask_blink_collectively(mask, blink_speed_ms) ({ \
+   trace_enter(TRACE_LED_ARRAY_BLINK); \
+   led_array_mask_on(mask); \
+   delay_ms(blink_speed_ms); \
+   led_array_mask_off(mask); \
+   delay_ms(blink_speed_ms); \
+   trace_exit(TRACE_LED_ARRAY_BLINK); \
+})
+
+
+/********************************************************************************
+* led_array_blink_forward: Genomför sekventiell blinkning framåt av samtliga
+*                          lysdioder lagrade i angiven array. Därmed blinkar
+*                          lysdioderna framåt i en sekvens en efter en.
+*
+*                          - self          : Pekare till arrayen vars lysdioder
+*                                            ska blinkas.
+*                          - blink_speed_ms: Lysdiodernas blinkhastighet mätt
+*                                            i millisekunder.
+********************************************************************************/
+#define led_array_blink_forward(self, blink_speed_ms) ({ \
+   led_t** i; \
+   trace_enter(TRACE_LED_ARRAY_BLINK); \
+   for (i = (self)->leds; i < (self)->leds + (self)->size; ++i) { \
+      (*i)->vptr->on(*i); \
+      delay_ms(blink_speed_ms); \
+      (*i)->vptr->off(*i); \
+   } \
+   trace_exit(TRACE_LED_ARRAY_BLINK); \
+})
+
+/********************************************************************************
+* led_array_blink_backward: Genomför sekventiell blinkning bakåt av samtliga
+*                           lysdioder lagrade i angiven array. Därmed blinkar
+*                           lysdioderna bakåt i en sekvens en efter en.
+*
+*                           - self          : Pekare till arrayen vars lysdioder
+*                                             ska blinkas.
+*                           - blink_speed_ms: Lysdiodernas blinkhastighet mätt
+*                                             i millisekunder.
+********************************************************************************/
+#define led_array_blink_backward(self, blink_speed_ms) ({ \
+   led_t** i; \
+   trace_enter(TRACE_LED_ARRAY_BLINK); \
+   for (i = (self)->leds + (self)->size - 1; i >= (self)->leds; --i) { \
+      (*i)->vptr->on(*i); \
+      delay_ms(blink_speed_ms); \
+      (*i)->vptr->off(*i); \
+   } \
+   trace_exit(TRACE_LED_ARRAY_BLINK); \
+})
+
+/********************************************************************************
+* led_array_blink_collectively: Genomför kollektiv (synkroniserad) blinkning
+*                               av samtliga lysdioder lagrade i angiven array.
+*
+*                               - self          : Pekare till arrayen vars
+*                                                 lysdioder ska blinkas.
+*                               - blink_speed_ms: Lysdiodernas blinkhastighet
+*                                                 mätt i millisekunder.
+********************************************************************************/
+#define led_array_blink_collectively(self, blink_speed_ms) ({ \
+   trace_enter(TRACE_LED_ARRAY_BLINK); \
+   led_array_on(self); \
+   delay_ms(blink_speed_ms); \
+   led_array_off(self); \
+   delay_ms(blink_speed_ms); \
+   trace_exit(TRACE_LED_ARRAY_BLINK); \
+})
+
 #endif /* LED_ARRAY_H_ */
\ No newline at end of file
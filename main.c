@@ -1,39 +1,62 @@
 /********************************************************************************
 * main.c: Demonstration av funktionsliknande makron, struktar med vtablepekare 
 *         samt dynamisk minnesallokering. Programkod skriven i C89.
-********************************************************************************/
+********************************************************************************/
 #include "led.h"
 #include "button.h"
+#include "button_group.h"
 #include "led_array.h"
+#include "pattern.h"
+#include "timer.h"
+#include "debounce.h"
+#include "uart.h"
+#include "telemetry.h"
+#include "event_queue.h"
+#include "power.h"
+#include "scheduler.h"
+
+/* Makrodefinitioner: */
+#define TELEMETRY_PERIOD_MS 100 /* Tid mellan telemetripaket, 0 = ingen telemetri. */
 
 /********************************************************************************
-* num_buttons_pressed: Returnerar antalet nedtryckta tryckknappar.
-*
-*                      - button1: Pekare till den frsta tryckknappen.
-*                      - button2: Pekare till den andra tryckknappen.  
-*                      - button3: Pekare till den tredje tryckknappen.       
-*                      - button4: Pekare till den fjrde tryckknappen.   
-********************************************************************************/
-static uint8_t num_buttons_pressed(button_t* button1,
-                                   button_t* button2,
-                                   button_t* button3,
-                                   button_t* button4)
+* main_state: Strukt innehållande tillståndet för uppgiften main_input_task,
+*             som lagras utanför uppgiften eftersom denna är stacklös.
+********************************************************************************/
+struct main_state
 {
-   uint8_t num = 0;
-   if (button1->vptr->is_pressed(button1)) num++;
-   if (button2->vptr->is_pressed(button2)) num++;
-   if (button3->vptr->is_pressed(button3)) num++;
-   if (button4->vptr->is_pressed(button4)) num++;
-   return num;
-}
+   led_array_t* leds;       /* Pekare till led-arrayen. */
+   button_group_t* buttons; /* Pekare till gruppen av tryckknappar. */
+   uint8_t buttons_pressed; /* Antalet nedtryckta tryckknappar vid föregående avläsning. */
+};
+
+/* Statiska funktioner: */
+static enum task_status main_input_task(task_t* self);
+static enum task_status main_telemetry_task(task_t* self);
+static void main_enable_wakeup(button_t* self);
+static void main_on_button_event(button_t* self,
+                                 const enum button_event event);
+static void main_set_mode(led_array_t* leds,
+                          const uint8_t buttons_pressed);
+static bool main_can_power_down(const button_group_t* buttons);
 
 /********************************************************************************
 * main: Ansluter fem lysdioder till pin 6 - 10 samt fyra tryckknappar till pin  
-*       11 - 13 samt pin 2. Lysdioderna lagras i en dynamisk array. 
-*       Beroende p antalet tryckknappar som trycks ned s blinkar lysdioderna 
-*       antingen framt, bakt eller synkroniserat, eller s hlls de tnda 
-*       eller slckta. 
-********************************************************************************/
+*       11 - 13 samt pin 2. Lysdioderna lagras i en led-array. 
+*       Beroende på antalet tryckknappar som trycks ned så blinkar lysdioderna 
+*       antingen framåt, bakåt eller synkroniserat, eller så hålls de tända 
+*       eller släckta. Blinkningen sker asynkront via blinkmönster som
+*       spelas upp av systemtimern. Lysdiodernas och tryckknapparnas
+*       tillstånd samt aktuellt läge skickas som telemetri via USART0
+*       (38 400 baud) var 100:e millisekund.
+*
+*       Huvudloopen är händelsestyrd och kör schemaläggaren en gång per
+*       avbrott, varefter processorn försätts i viloläge. Avläsning av
+*       tryckknapparna samt sändning av telemetri utgör var sin stacklös
+*       uppgift. Tryckknapparna läses enbart av när avstudsningen
+*       rapporterar ändrade insignaler via eventet EVENT_INPUT_CHANGED.
+*       Viloläget Idle används så länge systemtimern behövs, annars
+*       Power-down, där processorn väcks av PCI-avbrott från tryckknapparna.
+********************************************************************************/
 int main(void)
 {
    led_t* led1 = led_new(6);
@@ -47,47 +70,193 @@ int main(void)
    button_t* button3 = button_new(13);
    button_t* button4 = button_new(2);
 
-   led_t** leds = led_array_new(0);
-   size_t num_leds = 0;
+   led_t* led_storage[5];
+   led_array_t leds;
+   button_group_t buttons;
+   struct main_state state;
+   task_t input_task;
+   task_t telemetry_task;
 
-   if (!leds) return 1;
+   power_init();
+   led_array_init_static(&leds, led_storage, 5);
+   timer_init();
+   debounce_init();
+   debounce_enable_events();
 
-   led_array_push(&leds, &num_leds, led1);
-   led_array_push(&leds, &num_leds, led2);
-   led_array_push(&leds, &num_leds, led3);
-   led_array_push(&leds, &num_leds, led4);
-   led_array_push(&leds, &num_leds, led5);
+   led_array_push(&leds, led1);
+   led_array_push(&leds, led2);
+   led_array_push(&leds, led3);
+   led_array_push(&leds, led4);
+   led_array_push(&leds, led5);
+
+   button_group_init(&buttons);
+   button_group_add(&buttons, button1);
+   button_group_add(&buttons, button2);
+   button_group_add(&buttons, button3);
+   button_group_add(&buttons, button4);
+
+   main_enable_wakeup(button1);
+   main_enable_wakeup(button2);
+   main_enable_wakeup(button3);
+   main_enable_wakeup(button4);
+
+   uart_init(38400);
+   telemetry_init(&leds, &buttons, TELEMETRY_PERIOD_MS);
+
+   state.leds = &leds;
+   state.buttons = &buttons;
+   state.buttons_pressed = UINT8_MAX;
+   scheduler_add(&input_task, main_input_task, &state);
+   scheduler_add(&telemetry_task, main_telemetry_task, 0);
 
    while (1)
    {
-      const uint8_t buttons_pressed = num_buttons_pressed(button1, button2, button3, button4);
+      scheduler_service();
+      power_sleep(main_can_power_down(&buttons) ? POWER_MODE_POWER_DOWN : POWER_MODE_IDLE);
+   }
 
-      if (buttons_pressed == 0)
-      {
-         led_array_off(leds, num_leds);
-      }
-      else if (buttons_pressed == 1)
-      {
-         led_array_blink_collectively(leds, num_leds, 100);
-      }
-      else if (buttons_pressed == 2)
-      {
-         led_array_blink_forward(leds, num_leds, 100);
-      }
-      else if (buttons_pressed == 3)
-      {
-         led_array_blink_backward(leds, num_leds, 100);
-      }
-      else if (buttons_pressed == 4)
-      {
-          led_array_on(leds, num_leds);
-      }
-      else
+   return 0;
+}
+
+/********************************************************************************
+* main_input_task: Uppgift som läser av tryckknapparna vid start samt vid
+*                  varje event EVENT_INPUT_CHANGED och byter läge ifall
+*                  antalet nedtryckta tryckknappar har ändrats.
+*
+*                  - self: Pekare till uppgiften, vars tillstånd är en
+*                          strukt main_state.
+********************************************************************************/
+static enum task_status main_input_task(task_t* self)
+{
+   struct main_state* state = (struct main_state*)self->context;
+   uint8_t buttons_pressed;
+   task_begin(self);
+
+   while (1)
+   {
+      buttons_pressed = button_group_read(state->buttons, 0);
+
+      if (buttons_pressed != state->buttons_pressed)
       {
-         led_array_off(leds, num_leds);
+         main_set_mode(state->leds, buttons_pressed);
+         state->buttons_pressed = buttons_pressed;
       }
+
+      task_wait_event(self, EVENT_INPUT_CHANGED);
    }
 
-   return 0;
+   task_end(self);
+}
+
+/********************************************************************************
+* main_telemetry_task: Uppgift som skickar nästa telemetripaket när dess tid
+*                      har infallit, vilket kontrolleras en gång per varv.
+*
+*                      - self: Pekare till uppgiften.
+********************************************************************************/
+static enum task_status main_telemetry_task(task_t* self)
+{
+   task_begin(self);
+
+   while (1)
+   {
+      telemetry_service();
+      task_yield(self);
+   }
+
+   task_end(self);
+}
+
+/********************************************************************************
+* main_enable_wakeup: Aktiverar PCI-avbrott på angiven tryckknapp, så att
+*                     processorn väcks ur viloläget Power-down vid
+*                     nedtryckning eller uppsläppning.
+*
+*                     - self: Pekare till tryckknappen.
+********************************************************************************/
+static void main_enable_wakeup(button_t* self)
+{
+   self->vptr->set_callback(self, main_on_button_event);
+   self->vptr->enable_interrupt(self);
+   return;
+}
+
+/********************************************************************************
+* main_on_button_event: Callbackrutin som anropas vid flank på en tryckknapp.
+*                       Flanken läggs till i eventkön, vilket förhindrar
+*                       insomning innan huvudloopen har hanterat den.
+*                       Tryckknapparnas avstudsade värden avläses först vid
+*                       eventet EVENT_INPUT_CHANGED.
+*
+*                       - self : Pekare till tryckknappen.
+*                       - event: Detekterad flank.
+********************************************************************************/
+static void main_on_button_event(button_t* self,
+                                 const enum button_event event)
+{
+   if (event == BUTTON_EVENT_FALLING_EDGE)
+   {
+      event_queue_push(EVENT_BUTTON_FALLING_EDGE, self->pin, 0);
+   }
+   else
+   {
+      event_queue_push(EVENT_BUTTON_RISING_EDGE, self->pin, 0);
+   }
+   return;
+}
+
+/********************************************************************************
+* main_set_mode: Startar blinkmönster eller tänder respektive släcker
+*                lysdioderna utifrån antalet nedtryckta tryckknappar.
+*
+*                - leds           : Pekare till led-arrayen.
+*                - buttons_pressed: Antalet nedtryckta tryckknappar.
+********************************************************************************/
+static void main_set_mode(led_array_t* leds,
+                          const uint8_t buttons_pressed)
+{
+   pattern_stop();
+   telemetry_set_mode(buttons_pressed);
+
+   if (buttons_pressed == 0)
+   {
+      led_array_mask_off(&leds->mask);
+   }
+   else if (buttons_pressed == 1)
+   {
+      pattern_start(leds, &pattern_collectively, 100);
+   }
+   else if (buttons_pressed == 2)
+   {
+      pattern_start(leds, &pattern_forward, 100);
+   }
+   else if (buttons_pressed == 3)
+   {
+      pattern_start(leds, &pattern_backward, 100);
+   }
+   else if (buttons_pressed == 4)
+   {
+       led_array_mask_on(&leds->mask);
+   }
+   else
+   {
+      led_array_mask_off(&leds->mask);
+   }
+   return;
+}
+
+/********************************************************************************
+* main_can_power_down: Returnerar true ifall systemtimern och USART0 inte
+*                      behövs, det vill säga ifall telemetri är avstängd,
+*                      inget blinkmönster spelas upp, ingen uppgift sover,
+*                      sändningen är klar och avstudsningen av
+*                      tryckknapparna är avslutad.
+*
+*                      - buttons: Pekare till gruppen av tryckknappar.
+********************************************************************************/
+static bool main_can_power_down(const button_group_t* buttons)
+{
+   return TELEMETRY_PERIOD_MS == 0 && !pattern_is_running() && !scheduler_needs_timer() &&
+          uart_tx_idle() && button_group_is_settled(buttons);
 }
 
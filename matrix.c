@@ -0,0 +1,405 @@
+/********************************************************************************
+* matrix.c: Innehåller funktionsdefinitioner för multiplexerade samt
+*           charlieplexade lysdiodmatriser.
+********************************************************************************/
+#include "matrix.h"
+#include "timer.h"
+#include "trace.h"
+#include "gpio.h"
+
+/********************************************************************************
+* matrix_row: Strukt innehållande förberäknade värden för DDRx samt PORTx
+*             för matrisens pinnar när en viss rad är aktiv, en byte per
+*             I/O-port. Bitar för pinnar utanför matrisen är alltid noll.
+********************************************************************************/
+struct matrix_row
+{
+   uint8_t ddr[IO_PORT_NONE];  /* Värden för DDRB, DDRC samt DDRD. */
+   uint8_t port[IO_PORT_NONE]; /* Värden för PORTB, PORTC samt PORTD. */
+};
+
+/********************************************************************************
+* matrix_blank: Sätter matrisens pinnar på angiven I/O-port till inportar,
+*               så att inga lysdioder lyser medan nästa rad förbereds.
+*
+*               - ddr_reg: Datariktningsregistret DDRx.
+*               - index  : I/O-portens index, se enumerationen io_port.
+********************************************************************************/
+#define matrix_blank(ddr_reg, index) ({ \
+   if (matrix_pins[index]) ddr_reg &= ~matrix_pins[index]; \
+})
+
+/********************************************************************************
+* matrix_drive: Sätter matrisens pinnar på angiven I/O-port enligt angiven
+*               rad. Portregistret skrivs före datariktningsregistret, så
+*               att pinnarna aldrig drivs med föregående rads nivåer.
+*
+*               - ddr_reg : Datariktningsregistret DDRx.
+*               - port_reg: Portregistret PORTx.
+*               - row_ptr : Pekare till raden som ska aktiveras.
+*               - index   : I/O-portens index, se enumerationen io_port.
+********************************************************************************/
+#define matrix_drive(ddr_reg, port_reg, row_ptr, index) ({ \
+   if (matrix_pins[index]) { \
+      port_reg = (port_reg & ~matrix_pins[index]) | (row_ptr)->port[index]; \
+      ddr_reg |= (row_ptr)->ddr[index]; \
+   } \
+})
+
+/* Statiska funktioner: */
+static int matrix_init_columns(const uint8_t* pins,
+                               const uint8_t num_pins);
+static int matrix_start(const uint8_t num_rows);
+static void matrix_reset(void);
+static void matrix_led_on(led_t* self);
+static void matrix_led_off(led_t* self);
+static void matrix_led_toggle(led_t* self);
+static void matrix_led_blink(led_t* self,
+                             const uint16_t blink_speed_ms);
+static led_vptr_t matrix_vptr_new(void);
+
+/* Statiska variabler: */
+static volatile struct matrix_row matrix_rows[MATRIX_MAX_ROWS]; /* Förberäknade rader. */
+static uint8_t matrix_pins[IO_PORT_NONE]; /* Matrisens samtliga pinnar per I/O-port. */
+static uint8_t matrix_column_pins[MATRIX_MAX_COLUMNS]; /* Kolumnernas pin-nummer. */
+static uint8_t matrix_num_rows = 0; /* Antalet rader, 0 = ingen matris drivs. */
+static uint8_t matrix_num_columns = 0; /* Antalet kolumner. */
+static uint8_t matrix_row = 0; /* Index för aktiv rad. */
+static bool matrix_charlieplexed = false; /* Indikerar charlieplexing. */
+static volatile uint8_t matrix_dummy_reg = 0; /* Ersättningsbyte för ogiltig position. */
+
+/********************************************************************************
+* matrix_init: Startar drivning av en multiplexerad matris. För varje rad
+*              förberäknas att samtliga radpinnar är utportar, där aktuell
+*              rad är låg och övriga rader höga. Kolumnerna är högimpediva
+*              tills lysdioder tänds.
+*
+*              - row_pins   : Pin-nummer för matrisens rader.
+*              - num_rows   : Antalet rader.
+*              - column_pins: Pin-nummer för matrisens kolumner.
+*              - num_columns: Antalet kolumner.
+********************************************************************************/
+int matrix_init(const uint8_t* row_pins,
+                const uint8_t num_rows,
+                const uint8_t* column_pins,
+                const uint8_t num_columns)
+{
+   uint8_t i, r;
+   matrix_stop();
+
+   if (num_rows < 1 || num_rows > MATRIX_MAX_ROWS ||
+       num_columns < 1 || num_columns > MATRIX_MAX_COLUMNS) return 1;
+   if (matrix_init_columns(column_pins, num_columns)) return 1;
+
+   for (i = 0; i < num_rows; ++i)
+   {
+      gpio_t gpio;
+
+      if (!gpio_load(&gpio, row_pins[i]))
+      {
+         matrix_reset();
+         return 1;
+      }
+
+      matrix_pins[gpio.io_port] |= gpio.mask;
+
+      for (r = 0; r < num_rows; ++r)
+      {
+         matrix_rows[r].ddr[gpio.io_port] |= gpio.mask;
+         if (r != i) matrix_rows[r].port[gpio.io_port] |= gpio.mask;
+      }
+   }
+
+   return matrix_start(num_rows);
+}
+
+/********************************************************************************
+* matrix_init_charlieplexed: Startar drivning av en charlieplexad matris.
+*                            För rad r förberäknas att enbart pin r är
+*                            utport med låg nivå, medan övriga pinnar är
+*                            högimpediva tills lysdioder tänds.
+*
+*                            - pins    : Matrisens pin-nummer.
+*                            - num_pins: Antalet pinnar.
+********************************************************************************/
+int matrix_init_charlieplexed(const uint8_t* pins,
+                              const uint8_t num_pins)
+{
+   uint8_t r;
+   matrix_stop();
+
+   if (num_pins < 2 || num_pins > MATRIX_MAX_ROWS) return 1;
+   if (matrix_init_columns(pins, num_pins)) return 1;
+
+   for (r = 0; r < num_pins; ++r)
+   {
+      gpio_t gpio;
+      if (gpio_load(&gpio, pins[r])) matrix_rows[r].ddr[gpio.io_port] |= gpio.mask;
+   }
+
+   matrix_charlieplexed = true;
+   return matrix_start(num_pins);
+}
+
+/********************************************************************************
+* matrix_led_init: Initierar ny lysdiod på angiven position i aktuell matris.
+*                  Lysdiodens portpekare pekar på radens förberäknade värde
+*                  för PORTx, medan pekaren till pinregistret används för
+*                  radens förberäknade värde för DDRx.
+*
+*                  - self  : Pekare till lysdioden som ska initieras.
+*                  - row   : Lysdiodens rad.
+*                  - column: Lysdiodens kolumn.
+********************************************************************************/
+void matrix_led_init(led_t* self,
+                     const uint8_t row,
+                     const uint8_t column)
+{
+   if (row < matrix_num_rows && column < matrix_num_columns &&
+       !(matrix_charlieplexed && row == column))
+   {
+      gpio_t gpio;
+      gpio_load(&gpio, matrix_column_pins[column]);
+      self->pin = gpio.pin;
+      self->mask = gpio.mask;
+      self->port = &matrix_rows[row].port[gpio.io_port];
+      self->pin_reg = &matrix_rows[row].ddr[gpio.io_port];
+   }
+   else
+   {
+      self->pin = 0;
+      self->mask = 0;
+      self->port = &matrix_dummy_reg;
+      self->pin_reg = &matrix_dummy_reg;
+   }
+
+   self->io_port = IO_PORT_NONE;
+   self->enabled = false;
+   self->blink_speed_ms = 0;
+   self->blink_counter_ms = 0;
+   self->blink_next = 0;
+   self->vptr = matrix_vptr_new();
+   return;
+}
+
+/********************************************************************************
+* matrix_scan: Släcker aktuell rad genom att samtliga pinnar i matrisen sätts
+*              till inportar, varefter nästa rads förberäknade värden skrivs
+*              till PORTx och DDRx. Släckningen sker på samtliga I/O-portar
+*              före aktiveringen, så att föregående rads lysdioder aldrig
+*              lyser med nästa rads kolumner.
+********************************************************************************/
+void matrix_scan(void)
+{
+   const volatile struct matrix_row* row;
+   if (!matrix_num_rows) return;
+
+   trace_enter(TRACE_MATRIX_SCAN);
+   if (++matrix_row >= matrix_num_rows) matrix_row = 0;
+   row = &matrix_rows[matrix_row];
+
+   matrix_blank(DDRB, IO_PORTB);
+   matrix_blank(DDRC, IO_PORTC);
+   matrix_blank(DDRD, IO_PORTD);
+   matrix_drive(DDRB, PORTB, row, IO_PORTB);
+   matrix_drive(DDRC, PORTC, row, IO_PORTC);
+   matrix_drive(DDRD, PORTD, row, IO_PORTD);
+   trace_exit(TRACE_MATRIX_SCAN);
+   return;
+}
+
+/********************************************************************************
+* matrix_stop: Avslutar drivningen av aktuell matris och sätter samtliga
+*              pinnar i matrisen till högimpediva inportar.
+********************************************************************************/
+void matrix_stop(void)
+{
+   uint8_t sreg;
+   timer_remove_callback(matrix_scan);
+
+   atomic_begin(sreg);
+   DDRB &= ~matrix_pins[IO_PORTB];
+   DDRC &= ~matrix_pins[IO_PORTC];
+   DDRD &= ~matrix_pins[IO_PORTD];
+   PORTB &= ~matrix_pins[IO_PORTB];
+   PORTC &= ~matrix_pins[IO_PORTC];
+   PORTD &= ~matrix_pins[IO_PORTD];
+   matrix_reset();
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* matrix_init_columns: Lagrar kolumnernas pin-nummer och lägger till dem i
+*                      matrisens pinnar. Vid ogiltig pin nollställs
+*                      matrisen och felkod 1 returneras, annars 0.
+*
+*                      - pins    : Kolumnernas pin-nummer.
+*                      - num_pins: Antalet kolumner.
+********************************************************************************/
+static int matrix_init_columns(const uint8_t* pins,
+                               const uint8_t num_pins)
+{
+   uint8_t i;
+
+   for (i = 0; i < num_pins; ++i)
+   {
+      gpio_t gpio;
+
+      if (!gpio_load(&gpio, pins[i]))
+      {
+         matrix_reset();
+         return 1;
+      }
+
+      matrix_column_pins[i] = pins[i];
+      matrix_pins[gpio.io_port] |= gpio.mask;
+   }
+
+   matrix_num_columns = num_pins;
+   return 0;
+}
+
+/********************************************************************************
+* matrix_start: Registrerar radbytet hos systemtimern, varefter första rad
+*               aktiveras vid nästa avbrott. Ifall tabellen för
+*               systemtimerns callbackrutiner är full nollställs matrisen
+*               och felkod 1 returneras, annars 0.
+*
+*               - num_rows: Matrisens antal rader.
+********************************************************************************/
+static int matrix_start(const uint8_t num_rows)
+{
+   matrix_row = num_rows - 1;
+   matrix_num_rows = num_rows;
+
+   if (timer_add_callback(matrix_scan))
+   {
+      matrix_reset();
+      return 1;
+   }
+   return 0;
+}
+
+/********************************************************************************
+* matrix_reset: Nollställer samtliga förberäknade värden samt matrisens
+*               pinnar, varefter ingen matris drivs.
+********************************************************************************/
+static void matrix_reset(void)
+{
+   uint8_t r, i;
+
+   for (r = 0; r < MATRIX_MAX_ROWS; ++r)
+   {
+      for (i = 0; i < IO_PORT_NONE; ++i)
+      {
+         matrix_rows[r].ddr[i] = 0;
+         matrix_rows[r].port[i] = 0;
+      }
+   }
+
+   for (i = 0; i < IO_PORT_NONE; ++i)
+   {
+      matrix_pins[i] = 0;
+   }
+
+   matrix_num_rows = 0;
+   matrix_num_columns = 0;
+   matrix_row = 0;
+   matrix_charlieplexed = false;
+   return;
+}
+
+/********************************************************************************
+* matrix_led_on: Tänder angiven lysdiod, dvs. lysdiodens kolumn drivs hög när
+*                lysdiodens rad är aktiv. Portbiten ettställs före
+*                riktningsbiten, så att kolumnen aldrig drivs låg. Radens
+*                värden uppdateras med avbrott inaktiverade, eftersom
+*                asynkron blinkning samt blinkmönster kan ändra samma rad
+*                från avbrottsrutiner.
+*
+*                - self: Pekare till lysdioden som ska tändas.
+********************************************************************************/
+static void matrix_led_on(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   *self->port |= self->mask;
+   *self->pin_reg |= self->mask;
+   self->enabled = true;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* matrix_led_off: Släcker angiven lysdiod, dvs. lysdiodens kolumn är
+*                 högimpediv när lysdiodens rad är aktiv. Radens värden
+*                 uppdateras med avbrott inaktiverade, se matrix_led_on.
+*
+*                 - self: Pekare till lysdioden som ska släckas.
+********************************************************************************/
+static void matrix_led_off(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   *self->pin_reg &= ~self->mask;
+   *self->port &= ~self->mask;
+   self->enabled = false;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* matrix_led_toggle: Togglar angiven lysdiod. Avbrott inaktiveras mellan
+*                    avläsningen av lysdiodens tillstånd och uppdateringen.
+*
+*                    - self: Pekare till lysdioden som ska togglas.
+********************************************************************************/
+static void matrix_led_toggle(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+
+   if (self->enabled)
+   {
+      matrix_led_off(self);
+   }
+   else
+   {
+      matrix_led_on(self);
+   }
+
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* matrix_led_blink: Blinkar lysdiod en gång med angiven blinkhastighet.
+*
+*                   - self          : Pekare till lysdioden som ska blinkas.
+*                   - blink_speed_ms: Blinkhastigheten mätt i millisekunder.
+********************************************************************************/
+static void matrix_led_blink(led_t* self,
+                             const uint16_t blink_speed_ms)
+{
+   matrix_led_toggle(self);
+   delay_ms(blink_speed_ms);
+   return;
+}
+
+/********************************************************************************
+* matrix_vptr_new: Returnerar en pekare till ett vtable innehållande pekare
+*                  till associerade funktioner för lysdioder i matrisen.
+********************************************************************************/
+static led_vptr_t matrix_vptr_new(void)
+{
+   static struct led_vtable self =
+   {
+      .on = matrix_led_on,
+      .off = matrix_led_off,
+      .toggle = matrix_led_toggle,
+      .blink = matrix_led_blink,
+   };
+
+   return &self;
+}
@@ -0,0 +1,120 @@
+/********************************************************************************
+* matrix.h: Innehåller funktionalitet för en lysdiodmatris som drivs via
+*           multiplexering eller charlieplexing, vilket medför att betydligt
+*           fler lysdioder kan styras än antalet pinnar. Systemtimern
+*           aktiverar en rad per millisekund, där samtliga pinnar i matrisen
+*           sätts utifrån förberäknade värden för DDRx samt PORTx per rad.
+*           Kostnaden per rad är därmed konstant, oavsett antalet tända
+*           lysdioder: högst tre registerskrivningar per använd I/O-port
+*           (släckning via DDRx, därefter PORTx samt DDRx för nästa rad).
+*           Antalet klockcykler per rad mäts exakt av mätningarna
+*           CYCLES_MATRIX_SCAN samt CYCLES_MATRIX_SCAN_CHARLIEPLEXED i
+*           simavr/cycles.c, som körs via make i katalogen simavr.
+*           Uppdateringsfrekvensen blir 1000 / antalet rader Hz, exempelvis
+*           125 Hz för åtta rader, vilket upplevs som flimmerfritt.
+*
+*           Varje lysdiod utgörs av ett objekt av strukten led, se led.h,
+*           med ett eget vtable, där tändning och släckning enbart uppdaterar
+*           de förberäknade värdena för lysdiodens rad. Därmed kan
+*           lysdioderna lagras i led-arrayer och styras via blinkmönster,
+*           asynkron blinkning samt telemetri. Portmaskerna i led_array.h
+*           omfattar dock inte lysdioder i matrisen.
+*
+*           Multiplexering: Raderna är aktivt låga, det vill säga aktiv rad
+*           dras låg medan övriga rader hålls höga. Kolumnerna drivs höga
+*           för tända lysdioder och är högimpediva för släckta. Lysdiodernas
+*           anoder ansluts därmed via en resistor per kolumn och katoderna
+*           till raderna. Exempelvis ger fyra rader och fyra kolumner 16
+*           lysdioder via åtta pinnar.
+*
+*           Charlieplexing: Med n pinnar kan n * (n - 1) lysdioder styras,
+*           exempelvis 30 via sex pinnar eller 56 via åtta pinnar. Rad r
+*           motsvarar att pin r dras låg, medan pin c drivs hög för tänd
+*           lysdiod (r, c), dvs. lysdiod med katod mot pin r och anod mot
+*           pin c. Övriga pinnar är högimpediva. En resistor per pin krävs.
+*
+*           Endast en matris kan drivas åt gången. Lysdiodernas ljusstyrka
+*           motsvarar 1 / antalet rader av full ljusstyrka.
+********************************************************************************/
+#ifndef MATRIX_H_
+#define MATRIX_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led.h"
+
+/* Makrodefinitioner: */
+#ifndef MATRIX_MAX_ROWS
+#define MATRIX_MAX_ROWS 8 /* Maximalt antal rader, även antalet pinnar vid charlieplexing. */
+#endif
+
+#ifndef MATRIX_MAX_COLUMNS
+#define MATRIX_MAX_COLUMNS 8 /* Maximalt antal kolumner vid multiplexering. */
+#endif
+
+#if MATRIX_MAX_COLUMNS < MATRIX_MAX_ROWS
+#error "MATRIX_MAX_COLUMNS måste vara minst MATRIX_MAX_ROWS!"
+#endif
+
+/********************************************************************************
+* matrix_init: Startar drivning av en multiplexerad matris med angivna pinnar
+*              för rader respektive kolumner. Eventuell tidigare matris
+*              stoppas först. Systemtimern initieras vid behov. Samtliga
+*              lysdioder är släckta efter anropet. Vid ogiltigt antal rader
+*              eller kolumner, ogiltig pin eller full tabell för systemtimerns
+*              callbackrutiner returneras felkod 1, annars 0. Pinnarna måste
+*              vara unika.
+*
+*              - row_pins   : Pin-nummer för matrisens rader.
+*              - num_rows   : Antalet rader, 1 - MATRIX_MAX_ROWS.
+*              - column_pins: Pin-nummer för matrisens kolumner.
+*              - num_columns: Antalet kolumner, 1 - MATRIX_MAX_COLUMNS.
+********************************************************************************/
+int matrix_init(const uint8_t* row_pins,
+                const uint8_t num_rows,
+                const uint8_t* column_pins,
+                const uint8_t num_columns);
+
+/********************************************************************************
+* matrix_init_charlieplexed: Startar drivning av en charlieplexad matris med
+*                            angivna pinnar, som utgör både rader och
+*                            kolumner. Eventuell tidigare matris stoppas
+*                            först. Vid ogiltigt antal pinnar, ogiltig pin
+*                            eller full tabell för systemtimerns
+*                            callbackrutiner returneras felkod 1, annars 0.
+*
+*                            - pins    : Matrisens pin-nummer.
+*                            - num_pins: Antalet pinnar, 2 - MATRIX_MAX_ROWS.
+********************************************************************************/
+int matrix_init_charlieplexed(const uint8_t* pins,
+                              const uint8_t num_pins);
+
+/********************************************************************************
+* matrix_led_init: Initierar ny lysdiod på angiven position i aktuell matris.
+*                  Vid charlieplexing anger kolumnen index för pinnen som
+*                  driver lysdiodens anod. Ifall positionen ligger utanför
+*                  matrisen, eller rad och kolumn är lika vid
+*                  charlieplexing, påverkar lysdioden inga pinnar.
+*
+*                  - self  : Pekare till lysdioden som ska initieras.
+*                  - row   : Lysdiodens rad.
+*                  - column: Lysdiodens kolumn.
+********************************************************************************/
+void matrix_led_init(led_t* self,
+                     const uint8_t row,
+                     const uint8_t column);
+
+/********************************************************************************
+* matrix_scan: Släcker aktuell rad och aktiverar nästa. Anropas av
+*              systemtimern en gång per millisekund, men är publik så att
+*              kostnaden per rad kan mätas, se simavr/cycles.c.
+********************************************************************************/
+void matrix_scan(void);
+
+/********************************************************************************
+* matrix_stop: Avslutar drivningen av aktuell matris, varefter samtliga
+*              pinnar i matrisen sätts till högimpediva inportar.
+********************************************************************************/
+void matrix_stop(void);
+
+#endif /* MATRIX_H_ */
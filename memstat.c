@@ -0,0 +1,191 @@
+/********************************************************************************
+* memstat.c: Innehåller definitioner för instrumentering av minnesanvändningen.
+********************************************************************************/
+#include "memstat.h"
+
+#if MEMSTAT_ENABLED
+
+/* Globala variabler: */
+uint8_t memstat_objects[MEMSTAT_NUM_TYPES];
+
+/* Statiska variabler: */
+static uint16_t memstat_heap_used = 0;   /* Antalet för tillfället allokerade byte. */
+static uint16_t memstat_heap_peak = 0;   /* Högsta antalet samtidigt allokerade byte. */
+static uint16_t memstat_heap_failed = 0; /* Antalet misslyckade allokeringar. */
+
+#ifdef __AVR__
+
+/* Symboler definierade av länkaren samt avr-libc: */
+extern uint8_t __heap_start;
+extern char* __brkval;
+
+/* Statiska variabler: */
+static const uint8_t* memstat_brk_peak = 0; /* Högsta uppmätta heapslut (__brkval). */
+
+/* Statiska funktioner: */
+static void memstat_paint(void) __attribute__((naked, used, section(".init1")));
+
+/********************************************************************************
+* memstat_paint: Målar samtliga byte från slutet av .bss (__heap_start) till och med
+*                stackens topp (__stack) med värdet MEMSTAT_PAINT. Placeras i
+*                sektionen .init1, som körs före initiering av stackpekaren
+*                och variabler, och skrivs därför i assembler utan stack.
+********************************************************************************/
+static void memstat_paint(void)
+{
+   __asm__ __volatile__(
+      "    ldi r30, lo8(__heap_start)\n"
+      "    ldi r31, hi8(__heap_start)\n"
+      "    ldi r24, %0\n"
+      "    ldi r25, hi8(__stack)\n"
+      "    rjmp 2f\n"
+      "1:  st Z+, r24\n"
+      "2:  cpi r30, lo8(__stack)\n"
+      "    cpc r31, r25\n"
+      "    brlo 1b\n"
+      "    breq 1b\n"
+      :: "M" (MEMSTAT_PAINT));
+}
+
+#endif /* __AVR__ */
+
+/********************************************************************************
+* memstat_heap_add: Uppdaterar aktuell samt högsta heapanvändning. På AVR
+*                   uppdateras även heapens högsta slut, eftersom avr-libc
+*                   sänker __brkval när heapens översta block frigörs.
+*
+*                   - size_added  : Antalet tillkommande byte.
+*                   - size_removed: Antalet frigjorda byte.
+********************************************************************************/
+static void memstat_heap_add(const size_t size_added,
+                             const size_t size_removed)
+{
+   memstat_heap_used += size_added - size_removed;
+   if (memstat_heap_used > memstat_heap_peak) memstat_heap_peak = memstat_heap_used;
+#ifdef __AVR__
+   if ((const uint8_t*)__brkval > memstat_brk_peak) memstat_brk_peak = (const uint8_t*)__brkval;
+#endif /* __AVR__ */
+   return;
+}
+
+/********************************************************************************
+* memstat_malloc: Allokerar angivet antal byte på heapen och returnerar en
+*                 pekare till minnet efter lagrad storlek.
+*
+*                 - size: Antalet byte som ska allokeras.
+********************************************************************************/
+void* memstat_malloc(const size_t size)
+{
+   size_t* header = (size_t*)malloc(sizeof(size_t) + size);
+
+   if (!header)
+   {
+      memstat_heap_failed++;
+      return 0;
+   }
+
+   *header = size;
+   memstat_heap_add(size, 0);
+   return header + 1;
+}
+
+/********************************************************************************
+* memstat_realloc: Omallokerar minne allokerat via memstat_malloc till angiven
+*                  storlek.
+*
+*                  - block: Pekare till minnet, eller null för ny allokering.
+*                  - size : Minnets nya storlek mätt i byte.
+********************************************************************************/
+void* memstat_realloc(void* block,
+                      const size_t size)
+{
+   size_t* header;
+   size_t old_size;
+
+   if (!block) return memstat_malloc(size);
+   header = (size_t*)block - 1;
+   old_size = *header;
+   header = (size_t*)realloc(header, sizeof(size_t) + size);
+
+   if (!header)
+   {
+      memstat_heap_failed++;
+      return 0;
+   }
+
+   *header = size;
+   memstat_heap_add(size, old_size);
+   return header + 1;
+}
+
+/********************************************************************************
+* memstat_free: Frigör minne allokerat via memstat_malloc eller
+*               memstat_realloc.
+*
+*               - block: Pekare till minnet som ska frigöras.
+********************************************************************************/
+void memstat_free(void* block)
+{
+   size_t* header;
+   if (!block) return;
+   header = (size_t*)block - 1;
+   memstat_heap_used -= *header;
+   free(header);
+   return;
+}
+
+#endif /* MEMSTAT_ENABLED */
+
+/********************************************************************************
+* memstat_get: Kopierar aktuell statistik över minnesanvändningen. Sökningen
+*              efter stackens största djup startar vid heapens högsta
+*              slut hittills (eller början, ifall ingen allokering har
+*              skett) och fortsätter uppåt till första byte som inte har
+*              målat värde. Minne som tidigare har tillhört heapen är inte
+*              längre målat och hoppas därför över, även om avr-libc har
+*              sänkt __brkval efter frigörning. Stackens marginal räknas
+*              från heapens nuvarande slut.
+*
+*              - stats: Pekare till strukten som statistiken ska kopieras till.
+********************************************************************************/
+void memstat_get(memstat_t* stats)
+{
+   uint8_t i;
+#if MEMSTAT_ENABLED
+   stats->heap_used = memstat_heap_used;
+   stats->heap_peak = memstat_heap_peak;
+   stats->heap_failed = memstat_heap_failed;
+
+   for (i = 0; i < MEMSTAT_NUM_TYPES; ++i)
+   {
+      stats->objects[i] = memstat_objects[i];
+   }
+
+#ifdef __AVR__
+   {
+      const uint8_t* const heap_end = __brkval ? (const uint8_t*)__brkval : &__heap_start;
+      const uint8_t* stack_low;
+      if (heap_end > memstat_brk_peak) memstat_brk_peak = heap_end;
+      stack_low = memstat_brk_peak;
+      while (stack_low <= (const uint8_t*)RAMEND && *stack_low == MEMSTAT_PAINT) stack_low++;
+      stats->stack_peak = (uint16_t)((const uint8_t*)RAMEND - stack_low + 1);
+      stats->stack_margin = (uint16_t)(stack_low - heap_end);
+   }
+#else
+   stats->stack_peak = 0;
+   stats->stack_margin = 0;
+#endif /* __AVR__ */
+#else
+   stats->heap_used = 0;
+   stats->heap_peak = 0;
+   stats->heap_failed = 0;
+   stats->stack_peak = 0;
+   stats->stack_margin = 0;
+
+   for (i = 0; i < MEMSTAT_NUM_TYPES; ++i)
+   {
+      stats->objects[i] = 0;
+   }
+#endif /* MEMSTAT_ENABLED */
+   return;
+}
@@ -0,0 +1,123 @@
+/********************************************************************************
+* memstat.h: Instrumentering av minnesanvändningen i mikrodatorns 2 kB SRAM.
+*            Vid uppstart målas oanvänt minne mellan .bss och stackens topp
+*            med värdet MEMSTAT_PAINT, varefter stackens största djup kan
+*            beräknas genom att söka efter första övermålade byte. Dynamisk
+*            minnesallokering sker via memstat_malloc, memstat_realloc samt
+*            memstat_free, som räknar aktuell och högsta heapanvändning samt
+*            misslyckade allokeringar. Antalet levande objekt räknas per typ.
+*
+*            Instrumenteringen aktiveras vid kompilering via MEMSTAT_ENABLED.
+*            Vid inaktiverad instrumentering ersätts allokeringsfunktionerna
+*            av malloc, realloc och free, räknarna tas bort och ingen målning
+*            sker, vilket medför att instrumenteringen inte kostar någonting.
+*            Funktionen memstat_get returnerar då enbart nollor.
+********************************************************************************/
+#ifndef MEMSTAT_H_
+#define MEMSTAT_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#ifndef MEMSTAT_ENABLED
+#define MEMSTAT_ENABLED 0 /* Aktiverar instrumenteringen, 0 = inaktiverad. */
+#endif
+
+#define MEMSTAT_PAINT 0xC5 /* Värde som oanvänt minne målas med vid uppstart. */
+
+/********************************************************************************
+* memstat_type: Enumeration för de objekttyper vars antal räknas.
+********************************************************************************/
+enum memstat_type
+{
+   MEMSTAT_LED,       /* Lysdioder allokerade via led_new. */
+   MEMSTAT_BUTTON,    /* Tryckknappar allokerade via button_new. */
+   MEMSTAT_LED_ARRAY, /* Led-arrayer med dynamiskt allokerat minne. */
+   MEMSTAT_NUM_TYPES  /* Antalet objekttyper. */
+};
+
+/********************************************************************************
+* memstat: Strukt innehållande statistik över minnesanvändningen. Heapens
+*          användning avser begärt antal byte, exklusive allokeringens
+*          administrativa overhead.
+********************************************************************************/
+typedef struct memstat
+{
+   uint16_t heap_used;                 /* Antalet för tillfället allokerade byte. */
+   uint16_t heap_peak;                 /* Högsta antalet samtidigt allokerade byte. */
+   uint16_t heap_failed;               /* Antalet misslyckade allokeringar. */
+   uint16_t stack_peak;                /* Stackens största djup mätt i byte. */
+   uint16_t stack_margin;              /* Minsta avstånd mellan heap och stack. */
+   uint8_t objects[MEMSTAT_NUM_TYPES]; /* Antalet levande objekt per typ. */
+} memstat_t;
+
+#if MEMSTAT_ENABLED
+
+/* Antalet levande objekt per typ, uppdateras via makron nedan: */
+extern uint8_t memstat_objects[MEMSTAT_NUM_TYPES];
+
+/********************************************************************************
+* memstat_object_add, memstat_object_remove: Räknar upp respektive ned
+*                                            antalet levande objekt av
+*                                            angiven typ.
+*
+*                                            - type: Objekttypen, se
+*                                                    memstat_type.
+********************************************************************************/
+#define memstat_object_add(type) (memstat_objects[(type)]++)
+#define memstat_object_remove(type) (memstat_objects[(type)]--)
+
+/********************************************************************************
+* memstat_malloc: Allokerar angivet antal byte på heapen och returnerar en
+*                 pekare till minnet, alternativt en nullpekare vid
+*                 misslyckad allokering. Storleken lagras före minnet, vilket
+*                 ökar varje allokering med sizeof(size_t) byte.
+*
+*                 - size: Antalet byte som ska allokeras.
+********************************************************************************/
+void* memstat_malloc(const size_t size);
+
+/********************************************************************************
+* memstat_realloc: Omallokerar minne allokerat via memstat_malloc till angiven
+*                  storlek. Vid misslyckad allokering returneras en nullpekare
+*                  och ursprungligt minne lämnas orört.
+*
+*                  - block: Pekare till minnet, eller null för ny allokering.
+*                  - size : Minnets nya storlek mätt i byte.
+********************************************************************************/
+void* memstat_realloc(void* block,
+                      const size_t size);
+
+/********************************************************************************
+* memstat_free: Frigör minne allokerat via memstat_malloc eller
+*               memstat_realloc. En nullpekare ignoreras.
+*
+*               - block: Pekare till minnet som ska frigöras.
+********************************************************************************/
+void memstat_free(void* block);
+
+#else
+
+#define memstat_object_add(type) ((void)0)
+#define memstat_object_remove(type) ((void)0)
+#define memstat_malloc(size) malloc(size)
+#define memstat_realloc(block, size) realloc(block, size)
+#define memstat_free(block) free(block)
+
+#endif /* MEMSTAT_ENABLED */
+
+/********************************************************************************
+* memstat_get: Kopierar aktuell statistik över minnesanvändningen. Stackens
+*              största djup beräknas genom sökning efter första övermålade
+*              byte ovanför heapen, vilket tar tid proportionellt mot
+*              oanvänt minne. Ifall heapen och stacken har mötts sätts
+*              stack_margin till 0. Vid inaktiverad instrumentering, samt
+*              för stacken vid kompilering för annan processor än AVR,
+*              sätts samtliga värden till 0.
+*
+*              - stats: Pekare till strukten som statistiken ska kopieras till.
+********************************************************************************/
+void memstat_get(memstat_t* stats);
+
+#endif /* MEMSTAT_H_ */
@@ -1,98 +1,178 @@
-/********************************************************************************
-* misc.h: Innehller diverse bibliotek, definitioner samt enumerationer fr
-*         implementering av mikrodatorsystemet.
-********************************************************************************/
-#ifndef MISC_H_
-#define MISC_H_
-
-/* Inkluderingsdirektiv: */
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <stdint.h>
-#include <stdlib.h>
-
-/* Makrodefinitioner fr port-nummer p ATmega328P samt motsvarande pin-nummer p Arduino Uno: */
-#define D0 0 /* PORTD0 / pin 0. */
-#define D1 1 /* PORTD1 / pin 1. */
-#define D2 2 /* PORTD2 / pin 2. */
-#define D3 3 /* PORTD3 / pin 3. */
-#define D4 4 /* PORTD4 / pin 4. */
-#define D5 5 /* PORTD5 / pin 5. */
-#define D6 6 /* PORTD6 / pin 6. */
-#define D7 7 /* PORTD7 / pin 7. */
-
-#define B0 8  /* PORTB0 / pin 8. */
-#define B1 9  /* PORTB1 / pin 9. */
-#define B2 10 /* PORTB2 / pin 10. */
-#define B3 11 /* PORTB3 / pin 11. */
-#define B4 12 /* PORTB4 / pin 12. */
-#define B5 13 /* PORTB5 / pin 13. */
-
-#define C0 14 /* PORTC0 / pin A0. */
-#define C1 15 /* PORTC1 / pin A1. */
-#define C2 16 /* PORTC2 / pin A2. */
-#define C3 17 /* PORTC3 / pin A3. */
-#define C4 18 /* PORTC4 / pin A4. */
-#define C5 19 /* PORTC5 / pin A5. */
-
-#define A0 14 /* PORTC0 / pin A0. */
-#define A1 15 /* PORTC1 / pin A1. */
-#define A2 16 /* PORTC2 / pin A2. */
-#define A3 17 /* PORTC3 / pin A3. */
-#define A4 18 /* PORTC4 / pin A4. */
-#define A5 19 /* PORTC5 / pin A5. */
-
-/********************************************************************************
-* bool: Enumeration fr booleska vrden 0 och 1.
-********************************************************************************/
-typedef enum { false, true } bool;
-
-/********************************************************************************
-* io_port: Enumeration fr val av I/O-port mellan I/O-portar B, C och D.
-********************************************************************************/
-enum io_port
-{
-   IO_PORTB,    /* I/O-port B (pin 8 - 13 p Arduino Uno). */
-   IO_PORTC,    /* I/O-port C (pin A0 - A5 p Arduino Uno). */
-   IO_PORTD,    /* I/O-port D (pin 0 - 7 p Arduino Uno). */
-   IO_PORT_NONE /* Icke-specificerad I/O-port. */
-};
-
-/********************************************************************************
-* set: Ettstller bit i angivet register utan att pverka vriga bitar.
-*
-*      - reg: Registret vars innehll ska modifieras.
-*      - bit: Biten i registret som ska ettstllas.
-********************************************************************************/
-#define set(reg, bit) reg |= (1 << bit)
-
-/********************************************************************************
-* clr: Nollstller bit i angivet register utan att pverka vriga bitar.
-*
-*      - reg: Registret vars innehll ska modifieras.
-*      - bit: Biten i registret som ska nollstllas.
-********************************************************************************/
-#define clr(reg, bit) reg &= ~(1 << bit)
-
-/********************************************************************************
-* read: Lser av bit i angivet register, returnerar vrdet som logiska nolla
-*       eller etta via booleska vrden true och false.
-*
-*      - reg: Registret dr biten som ska lsas av ligger i.
-*      - bit: Biten i registret som ska lsas av.
-********************************************************************************/
-#define read(reg, bit) (bool)(reg & (1 << (bit)))
-
-/********************************************************************************
-* delay_ms: Genererar frdrjning mtt i millisekunder.
-*
-*           - delay_time_ms: Angiven frdrjningstid i millisekunder.
-********************************************************************************/
-#define delay_ms(delay_time_ms) ({ \
-   volatile uint16_t i, j; \
-   for (i = 0; i < delay_time_ms; ++i) { \
-      for (j = 0; j < 1000; ++j) ; \
-   } \
-})
-
+/********************************************************************************
+* misc.h: Innehåller diverse bibliotek, definitioner samt enumerationer för
+*         implementering av mikrodatorsystemet.
+********************************************************************************/
+#ifndef MISC_H_
+#define MISC_H_
+
+/* Mikrodatorns klockfrekvens, används för beräkning av timerinställningar samt
+   av util/delay.h. Måste därmed definieras före inkluderingsdirektiven, annars
+   antar avr-libc 1 MHz: */
+#ifndef F_CPU
+#define F_CPU 16000000UL /* 16 MHz. */
+#endif
+
+/* Inkluderingsdirektiv: */
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <util/delay_basic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Makrodefinitioner för port-nummer på ATmega328P samt motsvarande pin-nummer på Arduino Uno: */
+#define D0 0 /* PORTD0 / pin 0. */
+#define D1 1 /* PORTD1 / pin 1. */
+#define D2 2 /* PORTD2 / pin 2. */
+#define D3 3 /* PORTD3 / pin 3. */
+#define D4 4 /* PORTD4 / pin 4. */
+#define D5 5 /* PORTD5 / pin 5. */
+#define D6 6 /* PORTD6 / pin 6. */
+#define D7 7 /* PORTD7 / pin 7. */
+
+#define B0 8  /* PORTB0 / pin 8. */
+#define B1 9  /* PORTB1 / pin 9. */
+#define B2 10 /* PORTB2 / pin 10. */
+#define B3 11 /* PORTB3 / pin 11. */
+#define B4 12 /* PORTB4 / pin 12. */
+#define B5 13 /* PORTB5 / pin 13. */
+
+#define C0 14 /* PORTC0 / pin A0. */
+#define C1 15 /* PORTC1 / pin A1. */
+#define C2 16 /* PORTC2 / pin A2. */
+#define C3 17 /* PORTC3 / pin A3. */
+#define C4 18 /* PORTC4 / pin A4. */
+#define C5 19 /* PORTC5 / pin A5. */
+
+#define A0 14 /* PORTC0 / pin A0. */
+#define A1 15 /* PORTC1 / pin A1. */
+#define A2 16 /* PORTC2 / pin A2. */
+#define A3 17 /* PORTC3 / pin A3. */
+#define A4 18 /* PORTC4 / pin A4. */
+#define A5 19 /* PORTC5 / pin A5. */
+
+/********************************************************************************
+* bool: Enumeration för booleska värden 0 och 1.
+********************************************************************************/
+typedef enum { false, true } bool;
+
+/********************************************************************************
+* io_port: Enumeration för val av I/O-port mellan I/O-portar B, C och D.
+********************************************************************************/
+enum io_port
+{
+   IO_PORTB,    /* I/O-port B (pin 8 - 13 på Arduino Uno). */
+   IO_PORTC,    /* I/O-port C (pin A0 - A5 på Arduino Uno). */
+   IO_PORTD,    /* I/O-port D (pin 0 - 7 på Arduino Uno). */
+   IO_PORT_NONE /* Icke-specificerad I/O-port. */
+};
+
+/********************************************************************************
+* set: Ettställer bit i angivet register utan att påverka övriga bitar.
+*
+*      - reg: Registret vars innehåll ska modifieras.
+*      - bit: Biten i registret som ska ettställas.
+********************************************************************************/
+#define set(reg, bit) reg |= (1 << bit)
+
+/********************************************************************************
+* clr: Nollställer bit i angivet register utan att påverka övriga bitar.
+*
+*      - reg: Registret vars innehåll ska modifieras.
+*      - bit: Biten i registret som ska nollställas.
+********************************************************************************/
+#define clr(reg, bit) reg &= ~(1 << bit)
+
+/********************************************************************************
+* read: Läser av bit i angivet register, returnerar värdet som logiska nolla
+*       eller etta via booleska värden true och false.
+*
+*      - reg: Registret där biten som ska läsas av ligger i.
+*      - bit: Biten i registret som ska läsas av.
+********************************************************************************/
+#define read(reg, bit) (bool)(reg & (1 << (bit)))
+
+/********************************************************************************
+* pin_bit: Returnerar bitnumret i portregistret för angivet pin-nummer på
+*          Arduino Uno, exempelvis 2 för pin 10 (PORTB2). För konstanta
+*          pin-nummer beräknas värdet vid kompilering.
+*
+*          - pin: Pin-numret på Arduino Uno (0 - 19), alternativt D0 - C5.
+********************************************************************************/
+#define pin_bit(pin) ((pin) <= 7 ? (pin) : (pin) <= 13 ? (pin) - 8 : (pin) - 14)
+
+/********************************************************************************
+* pin_mask: Returnerar bitmasken i portregistret för angivet pin-nummer.
+*
+*           - pin: Pin-numret på Arduino Uno (0 - 19), alternativt D0 - C5.
+********************************************************************************/
+#define pin_mask(pin) (1 << pin_bit(pin))
+
+/********************************************************************************
+* pin_portx, pin_ddrx, pin_pinx: Returnerar register PORTx, DDRx respektive
+*                                PINx för den I/O-port som angivet pin-nummer
+*                                tillhör. För konstanta pin-nummer väljs
+*                                registret vid kompilering, vilket medför att
+*                                exempelvis pin_portx(pin) |= pin_mask(pin)
+*                                kompileras till en enda sbi-instruktion.
+*
+*                                - pin: Pin-numret på Arduino Uno (0 - 19),
+*                                       alternativt D0 - C5.
+********************************************************************************/
+#define pin_portx(pin) (*((pin) <= 7 ? &PORTD : (pin) <= 13 ? &PORTB : &PORTC))
+#define pin_ddrx(pin)  (*((pin) <= 7 ? &DDRD : (pin) <= 13 ? &DDRB : &DDRC))
+#define pin_pinx(pin)  (*((pin) <= 7 ? &PIND : (pin) <= 13 ? &PINB : &PINC))
+
+/********************************************************************************
+* atomic_begin: Sparar statusregistret och inaktiverar avbrott globalt, så att
+*               efterföljande kod kan genomföras utan att avbrytas. Avslutas
+*               med atomic_end, som återställer statusregistret.
+*
+*               - sreg: Variabel av typen uint8_t som statusregistret sparas i.
+********************************************************************************/
+#define atomic_begin(sreg) ({ \
+   sreg = SREG; \
+   cli(); \
+})
+
+/********************************************************************************
+* atomic_end: Återställer statusregistret sparat via atomic_begin, vilket
+*             återaktiverar avbrott ifall dessa var aktiverade innan.
+*
+*             - sreg: Variabel innehållande det sparade statusregistret.
+********************************************************************************/
+#define atomic_end(sreg) ({ \
+   SREG = sreg; \
+})
+
+/********************************************************************************
+* delay_ms: Genererar fördröjning mätt i millisekunder. Varje millisekund
+*           genereras via _delay_ms, som räknar exakt antal klockcykler
+*           utifrån F_CPU. Därmed blir fördröjningen densamma oavsett
+*           optimeringsnivå. Loopen tillför några klockcykler per millisekund.
+*
+*           - delay_time_ms: Angiven fördröjningstid i millisekunder.
+********************************************************************************/
+#define delay_ms(delay_time_ms) ({ \
+   uint16_t delay_i; \
+   for (delay_i = 0; delay_i < (delay_time_ms); ++delay_i) { \
+      _delay_ms(1); \
+   } \
+})
+
+/********************************************************************************
+* delay_us: Genererar fördröjning mätt i mikrosekunder via _delay_loop_2,
+*           som genomför exakt fyra klockcykler per varv. Antalet varv
+*           beräknas utifrån F_CPU. För konstanta fördröjningstider beräknas
+*           antalet varv vid kompilering, annars tillkommer beräkningstiden.
+*           Maximal fördröjningstid är 16 383 us vid 16 MHz.
+*
+*           - delay_time_us: Angiven fördröjningstid i mikrosekunder.
+********************************************************************************/
+#define delay_us(delay_time_us) ({ \
+   const uint16_t delay_loops = (uint16_t)(((uint32_t)(delay_time_us) * \
+      (F_CPU / 1000000UL)) >> 2); \
+   if (delay_loops) _delay_loop_2(delay_loops); \
+})
+
 #endif /* MISC_H_ */
\ No newline at end of file
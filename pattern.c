@@ -0,0 +1,190 @@
+/********************************************************************************
+* pattern.c: Innehåller funktionsdefinitioner för uppspelning av tabellstyrda
+*            blinkmönster lagrade i programminnet.
+********************************************************************************/
+#include "pattern.h"
+#include "timer.h"
+#include "framebuffer.h"
+
+/********************************************************************************
+* pattern_player: Strukt innehållande tillståndet för pågående uppspelning.
+********************************************************************************/
+struct pattern_player
+{
+   const led_array_t* leds;       /* Pekare till arrayen som mönstret spelas upp mot. */
+   const pattern_frame_t* frames; /* Pekare till mönstrets bildrutor i programminnet. */
+   uint8_t num_frames;            /* Antalet bildrutor i mönstret. */
+   uint8_t index;                 /* Index för aktuell bildruta. */
+   uint16_t unit_ms;              /* Längden på en tidsenhet mätt i millisekunder. */
+   uint32_t remaining_ms;         /* Återstående visningstid för aktuell bildruta. */
+};
+
+/* Statiska funktioner: */
+static void pattern_service(void);
+static void pattern_show_next(void);
+static void pattern_apply(const led_array_t* leds,
+                          const uint16_t bits);
+
+/* Statiska variabler: */
+static volatile struct pattern_player pattern_player; /* Aktuell uppspelning. */
+static framebuffer_t pattern_framebuffer;             /* Bildbuffert för visade bildrutor. */
+
+/* Bildrutor för de inbyggda mönstren: */
+static const pattern_frame_t pattern_forward_frames[] PROGMEM =
+{
+   { 0x0001, 1 }, { 0x0002, 1 }, { 0x0004, 1 }, { 0x0008, 1 },
+   { 0x0010, 1 }, { 0x0020, 1 }, { 0x0040, 1 }, { 0x0080, 1 },
+   { 0x0100, 1 }, { 0x0200, 1 }, { 0x0400, 1 }, { 0x0800, 1 },
+   { 0x1000, 1 }, { 0x2000, 1 }, { 0x4000, 1 }, { 0x8000, 1 }
+};
+
+static const pattern_frame_t pattern_backward_frames[] PROGMEM =
+{
+   { 0x8000, 1 }, { 0x4000, 1 }, { 0x2000, 1 }, { 0x1000, 1 },
+   { 0x0800, 1 }, { 0x0400, 1 }, { 0x0200, 1 }, { 0x0100, 1 },
+   { 0x0080, 1 }, { 0x0040, 1 }, { 0x0020, 1 }, { 0x0010, 1 },
+   { 0x0008, 1 }, { 0x0004, 1 }, { 0x0002, 1 }, { 0x0001, 1 }
+};
+
+static const pattern_frame_t pattern_collectively_frames[] PROGMEM =
+{
+   { 0xFFFF, 1 }, { 0x0000, 1 }
+};
+
+/* Inbyggda mönster: */
+const pattern_t pattern_forward PROGMEM = { pattern_forward_frames, 16 };
+const pattern_t pattern_backward PROGMEM = { pattern_backward_frames, 16 };
+const pattern_t pattern_collectively PROGMEM = { pattern_collectively_frames, 2 };
+
+/********************************************************************************
+* pattern_start: Startar uppspelning av angivet mönster mot angiven led-array.
+*                Mönstrets beskrivning läses från programminnet, varefter
+*                första bildrutan visas direkt.
+*
+*                - leds   : Pekare till arrayen som mönstret ska spelas upp mot.
+*                - pattern: Pekare till mönstret i programminnet.
+*                - unit_ms: Längden på en tidsenhet mätt i millisekunder.
+********************************************************************************/
+void pattern_start(const led_array_t* leds,
+                   const pattern_t* pattern,
+                   const uint16_t unit_ms)
+{
+   uint8_t sreg;
+   pattern_stop();
+
+   atomic_begin(sreg);
+   pattern_player.frames = (const pattern_frame_t*)pgm_read_ptr(&pattern->frames);
+   pattern_player.num_frames = pgm_read_byte(&pattern->num_frames);
+   pattern_player.unit_ms = unit_ms;
+   pattern_player.index = pattern_player.num_frames - 1;
+
+   if (pattern_player.num_frames && unit_ms && leds->size)
+   {
+      pattern_player.leds = leds;
+      pattern_show_next();
+   }
+
+   atomic_end(sreg);
+   if (pattern_player.leds) timer_add_callback(pattern_service);
+   return;
+}
+
+/********************************************************************************
+* pattern_stop: Avslutar eventuell pågående uppspelning, varefter arrayens
+*               lysdioder släcks.
+********************************************************************************/
+void pattern_stop(void)
+{
+   const led_array_t* leds;
+   uint8_t sreg;
+
+   atomic_begin(sreg);
+   leds = pattern_player.leds;
+   pattern_player.leds = 0;
+   atomic_end(sreg);
+
+   timer_remove_callback(pattern_service);
+   if (leds) pattern_apply(leds, 0);
+   return;
+}
+
+/********************************************************************************
+* pattern_is_running: Indikerar ifall ett mönster spelas upp.
+********************************************************************************/
+bool pattern_is_running(void)
+{
+   return pattern_player.leds ? true : false;
+}
+
+/********************************************************************************
+* pattern_apply: Tänder de lysdioder i arrayen vars bit är ettställd i angiven
+*                bitmask och släcker övriga. Bildrutan visas via en
+*                bildbuffert, så att samtliga lysdioder på samma I/O-port
+*                sätts i en och samma skrivning.
+*
+*                - leds: Pekare till arrayen vars lysdioder ska sättas.
+*                - bits: Bitmask för de lysdioder som ska vara tända.
+********************************************************************************/
+static void pattern_apply(const led_array_t* leds,
+                          const uint16_t bits)
+{
+   framebuffer_init(&pattern_framebuffer, leds);
+   if (pattern_framebuffer.size > 16) pattern_framebuffer.size = 16;
+   framebuffer_load(&pattern_framebuffer, bits);
+   framebuffer_commit(&pattern_framebuffer);
+   return;
+}
+
+/********************************************************************************
+* pattern_show_next: Stegar fram till nästa bildruta i mönstret och visar den.
+*                    Bildrutor som endast tänder lysdioder utanför arrayen
+*                    hoppas över. Ifall samtliga bildrutor hoppas över visas
+*                    ingenting.
+********************************************************************************/
+static void pattern_show_next(void)
+{
+   const led_array_t* leds = pattern_player.leds;
+   const uint16_t valid = leds->size >= 16 ? 0xFFFF : (uint16_t)((1U << leds->size) - 1);
+   uint8_t index = pattern_player.index;
+   uint8_t i;
+
+   for (i = 0; i < pattern_player.num_frames; ++i)
+   {
+      uint16_t bits;
+      index = index + 1 < pattern_player.num_frames ? index + 1 : 0;
+      bits = pgm_read_word(&pattern_player.frames[index].leds);
+
+      if (!bits || (bits & valid))
+      {
+         pattern_player.index = index;
+         pattern_player.remaining_ms = (uint32_t)pgm_read_word(&pattern_player.frames[index].duration) *
+            pattern_player.unit_ms;
+         pattern_apply(leds, bits & valid);
+         return;
+      }
+   }
+
+   pattern_player.remaining_ms = UINT32_MAX;
+   return;
+}
+
+/********************************************************************************
+* pattern_service: Callbackrutin som anropas av systemtimern en gång per
+*                  millisekund. När aktuell bildrutas visningstid har
+*                  förflutit visas nästa bildruta.
+********************************************************************************/
+static void pattern_service(void)
+{
+   if (!pattern_player.leds) return;
+
+   if (pattern_player.remaining_ms <= 1)
+   {
+      pattern_show_next();
+   }
+   else
+   {
+      pattern_player.remaining_ms--;
+   }
+
+   return;
+}
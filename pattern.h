@@ -0,0 +1,71 @@
+/********************************************************************************
+* pattern.h: Innehåller funktionalitet för tabellstyrda blinkmönster, som
+*            spelas upp mot en led-array via systemtimern. Ett mönster består
+*            av en sekvens av bildrutor, där varje bildruta anger vilka
+*            lysdioder i arrayen som ska vara tända samt hur länge bildrutan
+*            ska visas. Mönstren lagras i programminnet (PROGMEM), vilket
+*            medför att nya mönster inte tar något RAM-minne i anspråk.
+*            Uppspelningen blockerar inte anropande kod.
+********************************************************************************/
+#ifndef PATTERN_H_
+#define PATTERN_H_
+
+/* Inkluderingsdirektiv: */
+#include <avr/pgmspace.h>
+#include "misc.h"
+#include "led_array.h"
+
+/********************************************************************************
+* pattern_frame: Strukt för bildrutor i ett blinkmönster. Bit i i medlemmen
+*                leds motsvarar lysdiod i i arrayen, vilket medför att de
+*                första 16 lysdioderna i en array kan styras.
+********************************************************************************/
+typedef struct pattern_frame
+{
+   uint16_t leds;     /* Bitmask för de lysdioder som ska vara tända. */
+   uint16_t duration; /* Bildrutans visningstid mätt i tidsenheter. */
+} pattern_frame_t;
+
+/********************************************************************************
+* pattern: Strukt för blinkmönster, som lagras i programminnet.
+********************************************************************************/
+typedef struct pattern
+{
+   const pattern_frame_t* frames; /* Pekare till mönstrets bildrutor i programminnet. */
+   uint8_t num_frames;            /* Antalet bildrutor i mönstret. */
+} pattern_t;
+
+/* Inbyggda mönster, motsvarar blinkfunktionerna i led_array.h: */
+extern const pattern_t pattern_forward PROGMEM;      /* Sekventiell blinkning framåt. */
+extern const pattern_t pattern_backward PROGMEM;     /* Sekventiell blinkning bakåt. */
+extern const pattern_t pattern_collectively PROGMEM; /* Kollektiv blinkning. */
+
+/********************************************************************************
+* pattern_start: Startar uppspelning av angivet mönster mot angiven led-array.
+*                Mönstret upprepas tills uppspelningen avslutas via
+*                pattern_stop. Bildrutor som endast tänder lysdioder utanför
+*                arrayen hoppas över, vilket medför att de inbyggda mönstren
+*                fungerar för godtycklig arraystorlek upp till 16 lysdioder.
+*                Endast ett mönster kan spelas upp åt gången, eventuell
+*                pågående uppspelning avslutas därmed.
+*
+*                - leds   : Pekare till arrayen som mönstret ska spelas upp mot.
+*                - pattern: Pekare till mönstret i programminnet.
+*                - unit_ms: Längden på en tidsenhet mätt i millisekunder.
+********************************************************************************/
+void pattern_start(const led_array_t* leds,
+                   const pattern_t* pattern,
+                   const uint16_t unit_ms);
+
+/********************************************************************************
+* pattern_stop: Avslutar eventuell pågående uppspelning, varefter arrayens
+*               lysdioder släcks.
+********************************************************************************/
+void pattern_stop(void);
+
+/********************************************************************************
+* pattern_is_running: Indikerar ifall ett mönster spelas upp.
+********************************************************************************/
+bool pattern_is_running(void);
+
+#endif /* PATTERN_H_ */
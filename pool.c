@@ -0,0 +1,83 @@
+/********************************************************************************
+* pool.c: Innehåller funktionsdefinitioner för objektpooler med fast kapacitet.
+********************************************************************************/
+#include "pool.h"
+
+/********************************************************************************
+* pool_alloc: Allokerar ett objekt från angiven pool och returnerar en pekare
+*             till detta. I första hand återanvänds tidigare frigjorda platser,
+*             annars delas nästa aldrig använda plats ut. Ifall poolen är full
+*             returneras en nullpekare och antalet misslyckade allokeringar
+*             räknas upp.
+*
+*             - self: Pekare till poolen som objektet ska allokeras från.
+********************************************************************************/
+void* pool_alloc(pool_t* self)
+{
+   void* object;
+
+   if (self->free_list)
+   {
+      object = self->free_list;
+      self->free_list = *(void**)object;
+   }
+   else if (self->num_touched < self->capacity)
+   {
+      object = self->storage + self->object_size * self->num_touched++;
+   }
+   else
+   {
+      self->failed++;
+      return 0;
+   }
+
+   if (++self->used > self->high_water_mark)
+   {
+      self->high_water_mark = self->used;
+   }
+
+   return object;
+}
+
+/********************************************************************************
+* pool_free: Frigör angivet objekt, som därefter kan allokeras på nytt.
+*            Objektet läggs först i listan över frigjorda platser.
+*            Pekare utanför de utdelade platserna, pekare som inte pekar på
+*            början av en plats samt frigörning när inga objekt är
+*            allokerade ignoreras, så att listan över frigjorda platser och
+*            antalet allokerade objekt aldrig korrumperas. Dubbel frigörning
+*            av samma objekt medan andra objekt är allokerade detekteras
+*            dock inte.
+*
+*            - self  : Pekare till poolen som objektet tillhör.
+*            - object: Pekare till objektet som ska frigöras.
+********************************************************************************/
+void pool_free(pool_t* self,
+               void* object)
+{
+   uint8_t* ptr = (uint8_t*)object;
+   if (!self->used) return;
+   if (ptr < self->storage || ptr >= self->storage + self->object_size * self->num_touched) return;
+   if ((size_t)(ptr - self->storage) % self->object_size) return;
+
+   *(void**)object = self->free_list;
+   self->free_list = object;
+   self->used--;
+   return;
+}
+
+/********************************************************************************
+* pool_get_stats: Kopierar användningsstatistik för angiven pool.
+*
+*                 - self : Pekare till poolen vars statistik ska läsas av.
+*                 - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void pool_get_stats(const pool_t* self,
+                    pool_stats_t* stats)
+{
+   stats->capacity = self->capacity;
+   stats->used = self->used;
+   stats->high_water_mark = self->high_water_mark;
+   stats->failed = self->failed;
+   return;
+}
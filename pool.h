@@ -0,0 +1,92 @@
+/********************************************************************************
+* pool.h: Innehåller funktionalitet för objektpooler med fast kapacitet, som
+*         kan användas i stället för malloc och free vid allokering av objekt.
+*         Poolens minne allokeras statiskt, vilket medför att programmets
+*         totala minnesåtgång är känd vid länkning. Allokering samt frigörning
+*         sker i konstant tid via en länkad lista av lediga platser, som lagras
+*         i de lediga platserna själva. Därmed krävs att varje objekt rymmer
+*         minst en pekare.
+********************************************************************************/
+#ifndef POOL_H_
+#define POOL_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#define POOL_MAX_CAPACITY 255 /* Maximal kapacitet, räknarna lagras som uint8_t. */
+
+/********************************************************************************
+* pool: Strukt för implementering av objektpooler med fast kapacitet.
+*       Lediga platser som aldrig har allokerats delas ut i ordning via
+*       medlemmen num_touched, varefter frigjorda platser återanvänds via
+*       listan free_list. Därmed krävs ingen initiering av platserna.
+********************************************************************************/
+typedef struct pool
+{
+   void* free_list;         /* Pekare till första frigjorda plats i poolen. */
+   uint8_t* storage;        /* Pekare till poolens statiskt allokerade minne. */
+   size_t object_size;      /* Storleken på varje objekt i poolen mätt i byte. */
+   uint8_t capacity;        /* Poolens kapacitet, dvs. maximalt antal objekt. */
+   uint8_t num_touched;     /* Antalet platser som har delats ut minst en gång. */
+   uint8_t used;            /* Antalet för tillfället allokerade objekt. */
+   uint8_t high_water_mark; /* Högsta antalet samtidigt allokerade objekt. */
+   uint16_t failed;         /* Antalet misslyckade allokeringar. */
+} pool_t;
+
+/********************************************************************************
+* pool_stats: Strukt innehållande användningsstatistik för en objektpool.
+********************************************************************************/
+typedef struct pool_stats
+{
+   uint8_t capacity;        /* Poolens kapacitet, dvs. maximalt antal objekt. */
+   uint8_t used;            /* Antalet för tillfället allokerade objekt. */
+   uint8_t high_water_mark; /* Högsta antalet samtidigt allokerade objekt. */
+   uint16_t failed;         /* Antalet misslyckade allokeringar. */
+} pool_stats_t;
+
+/********************************************************************************
+* POOL_INIT: Initierar objektpool som använder angiven statiskt allokerad array
+*            som minne. Poolens kapacitet samt objektstorlek beräknas utifrån
+*            arrayen, vars längd får vara högst POOL_MAX_CAPACITY. Används
+*            vid deklaration av poolen, exempelvis:
+*
+*            static led_t storage[8];
+*            static pool_t pool = POOL_INIT(storage);
+*
+*            - storage: Statiskt allokerad array som utgör poolens minne.
+********************************************************************************/
+#define POOL_INIT(storage) { 0, (uint8_t*)(storage), sizeof((storage)[0]), \
+   sizeof(storage) / sizeof((storage)[0]), 0, 0, 0, 0 }
+
+/********************************************************************************
+* pool_alloc: Allokerar ett objekt från angiven pool och returnerar en pekare
+*             till detta. Ifall poolen är full returneras en nullpekare och
+*             antalet misslyckade allokeringar räknas upp.
+*
+*             - self: Pekare till poolen som objektet ska allokeras från.
+********************************************************************************/
+void* pool_alloc(pool_t* self);
+
+/********************************************************************************
+* pool_free: Frigör angivet objekt, som därefter kan allokeras på nytt.
+*            Pekare som inte pekar på början av en utdelad plats i poolen,
+*            exempelvis nullpekare, ignoreras, liksom frigörning när inga
+*            objekt är allokerade.
+*
+*            - self  : Pekare till poolen som objektet tillhör.
+*            - object: Pekare till objektet som ska frigöras.
+********************************************************************************/
+void pool_free(pool_t* self,
+               void* object);
+
+/********************************************************************************
+* pool_get_stats: Kopierar användningsstatistik för angiven pool.
+*
+*                 - self : Pekare till poolen vars statistik ska läsas av.
+*                 - stats: Pekare till strukt där statistiken ska lagras.
+********************************************************************************/
+void pool_get_stats(const pool_t* self,
+                    pool_stats_t* stats);
+
+#endif /* POOL_H_ */
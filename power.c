@@ -0,0 +1,58 @@
+/********************************************************************************
+* power.c: Innehåller funktionsdefinitioner för vilolägen samt avstängning
+*          av oanvänd kringutrustning.
+********************************************************************************/
+#include "power.h"
+#include "event_queue.h"
+#include <avr/sleep.h>
+
+/* Statiska variabler: */
+static uint32_t power_num_sleeps = 0; /* Antalet genomförda vilolägen. */
+
+/********************************************************************************
+* power_init: Stänger av AD-omvandlaren, den analoga komparatorn samt
+*             TWI-enheten. AD-omvandlaren inaktiveras innan dess klocka
+*             stängs av via PRR, eftersom den annars förblir aktiv.
+********************************************************************************/
+void power_init(void)
+{
+   clr(ADCSRA, ADEN);
+   set(ACSR, ACD);
+   PRR |= (1 << PRADC) | (1 << PRTWI);
+   return;
+}
+
+/********************************************************************************
+* power_sleep: Försätter processorn i angivet viloläge ifall eventkön är tom.
+*              Eventkön kontrolleras med avbrott inaktiverade, varefter
+*              avbrott aktiveras omedelbart före instruktionen sleep, se
+*              power.h. Efter uppvaknandet har avbrottsrutinen redan körts.
+*
+*              - mode: Viloläge som ska användas.
+********************************************************************************/
+void power_sleep(const enum power_mode mode)
+{
+   cli();
+
+   if (event_queue_size())
+   {
+      sei();
+      return;
+   }
+
+   set_sleep_mode(mode == POWER_MODE_POWER_DOWN ? SLEEP_MODE_PWR_DOWN : SLEEP_MODE_IDLE);
+   sleep_enable();
+   sei();
+   sleep_cpu();
+   sleep_disable();
+   power_num_sleeps++;
+   return;
+}
+
+/********************************************************************************
+* power_sleep_count: Returnerar antalet genomförda vilolägen sedan start.
+********************************************************************************/
+uint32_t power_sleep_count(void)
+{
+   return power_num_sleeps;
+}
@@ -0,0 +1,56 @@
+/********************************************************************************
+* power.h: Innehåller funktionalitet för strömsnål körning, där processorn
+*          försätts i viloläge i väntan på avbrott i stället för att
+*          huvudloopen snurrar. I viloläget Idle stannar enbart processorns
+*          klocka, medan samtliga timerkretsar samt USART0 fortsätter att gå,
+*          så att systemtimern väcker processorn en gång per millisekund.
+*          I viloläget Power-down stannar samtliga klockor och processorn
+*          väcks enbart av externa avbrott, exempelvis PCI-avbrott från
+*          tryckknappar. Systemtimern, PWM-generering samt USART0 står då
+*          still, vilket innebär att millis inte räknas upp under viloläget.
+*
+*          Huvudloopen ska hantera samtliga väntande event innan viloläge
+*          begärs. Kontrollen av eventkön och insomningen sker med avbrott
+*          inaktiverade, där avbrott aktiveras via instruktionen sei precis
+*          före instruktionen sleep. Eftersom instruktionen efter sei alltid
+*          genomförs före väntande avbrott kan ett event som läggs till
+*          efter kontrollen inte missas.
+********************************************************************************/
+#ifndef POWER_H_
+#define POWER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/********************************************************************************
+* power_mode: Enumeration för viloläge.
+********************************************************************************/
+enum power_mode
+{
+   POWER_MODE_IDLE,      /* Processorn stannar, timerkretsar och USART0 går. */
+   POWER_MODE_POWER_DOWN /* Samtliga klockor stannar, väcks av externa avbrott. */
+};
+
+/********************************************************************************
+* power_init: Stänger av kringutrustning som inte används av drivrutinerna,
+*             det vill säga AD-omvandlaren, den analoga komparatorn samt
+*             TWI-enheten, för minskad strömförbrukning.
+********************************************************************************/
+void power_init(void);
+
+/********************************************************************************
+* power_sleep: Försätter processorn i angivet viloläge tills nästa avbrott,
+*              förutsatt att eventkön är tom. Annars returnerar funktionen
+*              direkt. Avbrott är aktiverade globalt efter anropet.
+*
+*              - mode: Viloläge som ska användas.
+********************************************************************************/
+void power_sleep(const enum power_mode mode);
+
+/********************************************************************************
+* power_sleep_count: Returnerar antalet genomförda vilolägen sedan start,
+*                    vilket motsvarar antalet uppvaknanden.
+********************************************************************************/
+uint32_t power_sleep_count(void);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,168 @@
+/********************************************************************************
+* pwm.c: Innehåller funktionsdefinitioner för mjukvarubaserad
+*        ljusstyrkereglering via bitvinkelmodulering på Timer 2.
+********************************************************************************/
+#include <stddef.h>
+#include "pwm.h"
+#include "trace.h"
+
+/* Statiska funktioner: */
+static uint8_t pwm_port_offset(const led_t* led);
+
+/* Statiska variabler: */
+static volatile led_array_mask_t pwm_planes[PWM_NUM_PLANES]; /* Portmasker per bitplan. */
+static volatile led_array_mask_t pwm_mask; /* Pinnar som styrs via PWM. */
+static volatile uint8_t pwm_plane = 0; /* Bitplan som för tillfället visas. */
+static bool pwm_initialized = false; /* Indikerar ifall Timer 2 är initierad. */
+
+/********************************************************************************
+* pwm_init: Initierar Timer 2 i CTC-mod med prescaler 64, där första
+*           bitplanet visas under en tidsenhet (två timertick).
+********************************************************************************/
+void pwm_init(void)
+{
+   if (pwm_initialized) return;
+
+   TCCR2A = (1 << WGM21);
+   TCNT2 = 0;
+   OCR2A = 1;
+   TCCR2B = (1 << CS22);
+   set(TIMSK2, OCIE2A);
+   pwm_initialized = true;
+   sei();
+   return;
+}
+
+/********************************************************************************
+* pwm_set_brightness: Sätter ljusstyrkan på angiven lysdiod genom att dess bit
+*                     ettställs i portmasken för de bitplan som motsvarar
+*                     ettställda bitar i ljusstyrkan och nollställs i övriga.
+*                     Varje portmask uppdateras med en skrivning, vilket
+*                     medför att avbrottsrutinen inte behöver inaktiveras.
+*
+*                     - led       : Pekare till lysdioden vars ljusstyrka
+*                                   ska sättas.
+*                     - brightness: Ljusstyrkan mellan 0 - 255.
+********************************************************************************/
+void pwm_set_brightness(const led_t* led,
+                        const uint8_t brightness)
+{
+   const uint8_t offset = pwm_port_offset(led);
+   uint8_t i;
+
+   if (offset >= IO_PORT_NONE) return;
+
+   for (i = 0; i < PWM_NUM_PLANES; ++i)
+   {
+      volatile uint8_t* plane = (volatile uint8_t*)&pwm_planes[i] + offset;
+
+      if (brightness & (1 << i))
+      {
+         *plane |= led->mask;
+      }
+      else
+      {
+         *plane &= ~led->mask;
+      }
+   }
+
+   *((volatile uint8_t*)&pwm_mask + offset) |= led->mask;
+   pwm_init();
+   return;
+}
+
+/********************************************************************************
+* pwm_array_set_brightness: Sätter samma ljusstyrka på samtliga lysdioder
+*                           lagrade i angiven array.
+*
+*                           - self      : Pekare till arrayen vars lysdioder
+*                                         ska dimras.
+*                           - brightness: Ljusstyrkan mellan 0 - 255.
+********************************************************************************/
+void pwm_array_set_brightness(const led_array_t* self,
+                              const uint8_t brightness)
+{
+   led_t** i;
+
+   for (i = self->leds; i < self->leds + self->size; ++i)
+   {
+      pwm_set_brightness(*i, brightness);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* pwm_release: Avslutar ljusstyrkereglering av angiven lysdiod. Lysdioden
+*              tas först bort ur masken över styrda pinnar, så att
+*              avbrottsrutinen inte längre påverkar den, varefter dess bit
+*              nollställs i samtliga bitplan och lysdioden släcks.
+*
+*              - led: Pekare till lysdioden som ska släppas.
+********************************************************************************/
+void pwm_release(led_t* led)
+{
+   const uint8_t offset = pwm_port_offset(led);
+   uint8_t i;
+
+   if (offset >= IO_PORT_NONE) return;
+   *((volatile uint8_t*)&pwm_mask + offset) &= ~led->mask;
+
+   for (i = 0; i < PWM_NUM_PLANES; ++i)
+   {
+      *((volatile uint8_t*)&pwm_planes[i] + offset) &= ~led->mask;
+   }
+
+   led->vptr->off(led);
+   return;
+}
+
+/********************************************************************************
+* pwm_port_offset: Returnerar positionen för angiven lysdiods I/O-port i
+*                  strukten led_array_mask, dvs. 0 för port B, 1 för port C
+*                  och 2 för port D. För ogiltig I/O-port returneras
+*                  IO_PORT_NONE.
+*
+*                  - led: Pekare till lysdioden vars I/O-port ska kontrolleras.
+********************************************************************************/
+static uint8_t pwm_port_offset(const led_t* led)
+{
+   if (led->io_port == IO_PORTB)
+   {
+      return offsetof(led_array_mask_t, portb);
+   }
+   else if (led->io_port == IO_PORTC)
+   {
+      return offsetof(led_array_mask_t, portc);
+   }
+   else if (led->io_port == IO_PORTD)
+   {
+      return offsetof(led_array_mask_t, portd);
+   }
+   else
+   {
+      return IO_PORT_NONE;
+   }
+}
+
+/********************************************************************************
+* ISR (TIMER2_COMPA_vect): Avbrottsrutin som anropas vid slutet av varje
+*                          bitplan. Visningstiden för nästa bitplan skrivs
+*                          först till OCR2A, så att den hinner uppdateras
+*                          även för det kortaste bitplanet. Visningstiden
+*                          fördubblas för varje bitplan, vilket ger 2, 4, 8
+*                          ... 256 timertick. Därefter skrivs nästa bitplans
+*                          portmasker till samtliga tre portar.
+********************************************************************************/
+ISR (TIMER2_COMPA_vect)
+{
+   const uint8_t plane = (pwm_plane + 1) & (PWM_NUM_PLANES - 1);
+   OCR2A = plane ? (OCR2A << 1) | 1 : 1;
+   trace_enter(TRACE_ISR_TIMER2);
+
+   PORTB = (PORTB & ~pwm_mask.portb) | pwm_planes[plane].portb;
+   PORTC = (PORTC & ~pwm_mask.portc) | pwm_planes[plane].portc;
+   PORTD = (PORTD & ~pwm_mask.portd) | pwm_planes[plane].portd;
+   pwm_plane = plane;
+   trace_exit(TRACE_ISR_TIMER2);
+}
@@ -0,0 +1,71 @@
+/********************************************************************************
+* pwm.h: Innehåller funktionalitet för mjukvarubaserad ljusstyrkereglering av
+*        lysdioder på godtyckliga pinnar via bitvinkelmodulering (BAM).
+*        Varje lysdiod tilldelas en ljusstyrka mellan 0 - 255. Timer 2
+*        genererar avbrott vid slutet av varje bitplan, där bitplan i visas
+*        under 2^i tidsenheter. I varje avbrott skrivs förberäknade
+*        portmasker för nästa bitplan till PORTB, PORTC och PORTD, vilket
+*        medför att avbrottsrutinens kostnad är konstant, oavsett antalet
+*        lysdioder som dimras.
+*
+*        Vid 16 MHz är en tidsenhet 8 us (två timertick vid prescaler 64),
+*        vilket ger en period på 255 * 8 us = 2,04 ms, dvs. cirka 490 Hz,
+*        eller 32 640 klockcykler. Avbrottsrutinen genomförs åtta gånger
+*        per period, vilket ger en processorbelastning på 8 * n / 32 640,
+*        där n är rutinens kostnad i klockcykler. Kostnaden mäts exakt av
+*        mätningen CYCLES_PWM_ISR i simavr/cycles.c, inklusive in- och
+*        uthopp, som körs via make i katalogen simavr.
+*
+*        Lysdioder som styrs via PWM ska inte tändas eller släckas via
+*        strukten led, då avbrottsrutinen skriver över deras utsignaler.
+********************************************************************************/
+#ifndef PWM_H_
+#define PWM_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led.h"
+#include "led_array.h"
+
+/* Makrodefinitioner: */
+#define PWM_NUM_PLANES 8 /* Antalet bitplan, motsvarar 8 bitars upplösning. */
+
+/********************************************************************************
+* pwm_init: Initierar Timer 2 i CTC-mod för bitvinkelmodulering samt aktiverar
+*           avbrott globalt. Upprepade anrop har ingen effekt.
+********************************************************************************/
+void pwm_init(void);
+
+/********************************************************************************
+* pwm_set_brightness: Sätter ljusstyrkan på angiven lysdiod, som därefter
+*                     styrs av avbrottsrutinen tills pwm_release anropas.
+*                     Timer 2 initieras vid behov. Ljusstyrkan 0 motsvarar
+*                     släckt och 255 fullt tänd.
+*
+*                     - led       : Pekare till lysdioden vars ljusstyrka
+*                                   ska sättas.
+*                     - brightness: Ljusstyrkan mellan 0 - 255.
+********************************************************************************/
+void pwm_set_brightness(const led_t* led,
+                        const uint8_t brightness);
+
+/********************************************************************************
+* pwm_array_set_brightness: Sätter samma ljusstyrka på samtliga lysdioder
+*                           lagrade i angiven array.
+*
+*                           - self      : Pekare till arrayen vars lysdioder
+*                                         ska dimras.
+*                           - brightness: Ljusstyrkan mellan 0 - 255.
+********************************************************************************/
+void pwm_array_set_brightness(const led_array_t* self,
+                              const uint8_t brightness);
+
+/********************************************************************************
+* pwm_release: Avslutar ljusstyrkereglering av angiven lysdiod, som därefter
+*              släcks och åter kan styras via strukten led.
+*
+*              - led: Pekare till lysdioden som ska släppas.
+********************************************************************************/
+void pwm_release(led_t* led);
+
+#endif /* PWM_H_ */
@@ -0,0 +1,152 @@
+/********************************************************************************
+* scheduler.c: Innehåller funktionsdefinitioner för den kooperativa
+*              schemaläggaren av stacklösa uppgifter.
+********************************************************************************/
+#include "scheduler.h"
+#include "timer.h"
+
+/* Statiska funktioner: */
+static void scheduler_dispatch(const event_t* event,
+                               const uint32_t now);
+
+/* Statiska variabler: */
+static task_t* scheduler_tasks[SCHEDULER_MAX_TASKS]; /* Registrerade uppgifter. */
+static uint8_t scheduler_num_tasks = 0; /* Antalet registrerade uppgifter. */
+static uint8_t scheduler_index = 0; /* Index för uppgiften som körs av scheduler_dispatch. */
+
+/********************************************************************************
+* scheduler_add: Registrerar angiven uppgift, som körs från början vid nästa
+*                varv i schemaläggaren. Ifall uppgiften lyckas registreras
+*                returneras 0. Om maximalt antal uppgifter redan är
+*                registrerade returneras felkod 1.
+*
+*                - self    : Pekare till uppgiften.
+*                - function: Uppgiftens funktion.
+*                - context : Pekare till uppgiftens tillstånd, eller null.
+********************************************************************************/
+int scheduler_add(task_t* self,
+                  const task_function_t function,
+                  void* context)
+{
+   if (scheduler_num_tasks >= SCHEDULER_MAX_TASKS) return 1;
+
+   self->function = function;
+   self->context = context;
+   self->line = 0;
+   self->sleeping = false;
+   self->wake_ms = millis();
+   self->event.type = EVENT_NONE;
+   self->event.source = 0;
+   self->event.data = 0;
+   scheduler_tasks[scheduler_num_tasks++] = self;
+   return 0;
+}
+
+/********************************************************************************
+* scheduler_remove: Avregistrerar angiven uppgift, som därmed inte längre
+*                   körs. Övriga uppgifter behåller sin inbördes ordning.
+*                   Ifall uppgiften ligger på eller före uppgiften som körs
+*                   av scheduler_dispatch räknas dess index ned, så att
+*                   ingen uppgift hoppas över när arrayen packas om under
+*                   ett varv. Indexet kan då tillfälligt slå runt till 255,
+*                   vilket upphävs av uppräkningen i scheduler_dispatch.
+*
+*                   - self: Pekare till uppgiften.
+********************************************************************************/
+void scheduler_remove(task_t* self)
+{
+   uint8_t i, j;
+
+   for (i = 0, j = 0; i < scheduler_num_tasks; ++i)
+   {
+      if (scheduler_tasks[i] != self)
+      {
+         scheduler_tasks[j++] = scheduler_tasks[i];
+      }
+      else if (i <= scheduler_index)
+      {
+         scheduler_index--;
+      }
+   }
+
+   scheduler_num_tasks = j;
+   return;
+}
+
+/********************************************************************************
+* scheduler_service: Kör ett varv i schemaläggaren. Varje event i eventkön
+*                    levereras till samtliga vakna uppgifter, varefter
+*                    uppgifterna körs en gång till utan event. Tidpunkten
+*                    läses av en gång per varv.
+********************************************************************************/
+void scheduler_service(void)
+{
+   const uint32_t now = millis();
+   event_t event;
+
+   while (event_queue_pop(&event))
+   {
+      scheduler_dispatch(&event, now);
+   }
+
+   event.type = EVENT_NONE;
+   event.source = 0;
+   event.data = 0;
+   scheduler_dispatch(&event, now);
+   return;
+}
+
+/********************************************************************************
+* scheduler_needs_timer: Indikerar ifall någon uppgift sover via task_sleep
+*                        och därmed behöver systemtimern för att väckas.
+********************************************************************************/
+bool scheduler_needs_timer(void)
+{
+   uint8_t i;
+
+   for (i = 0; i < scheduler_num_tasks; ++i)
+   {
+      if (scheduler_tasks[i]->sleeping) return true;
+   }
+
+   return false;
+}
+
+/********************************************************************************
+* scheduler_dispatch: Levererar angivet event till samtliga vakna uppgifter
+*                     och kör dem. En sovande uppgift väcks när dess tid har
+*                     löpt ut, varvid tidpunkten behålls som utgångspunkt för
+*                     nästa task_sleep. För vakna uppgifter sätts tidpunkten
+*                     till aktuell tid. Avslutade uppgifter avregistreras.
+*                     Uppgifter får avregistrera andra uppgifter under
+*                     varvet, se scheduler_remove.
+*
+*                     - event: Pekare till eventet som ska levereras.
+*                     - now  : Aktuell tid mätt i millisekunder.
+********************************************************************************/
+static void scheduler_dispatch(const event_t* event,
+                               const uint32_t now)
+{
+   for (scheduler_index = 0; scheduler_index < scheduler_num_tasks; ++scheduler_index)
+   {
+      task_t* task = scheduler_tasks[scheduler_index];
+
+      if (task->sleeping)
+      {
+         if ((int32_t)(now - task->wake_ms) < 0) continue;
+         task->sleeping = false;
+      }
+      else
+      {
+         task->wake_ms = now;
+      }
+
+      task->event = *event;
+      if (task->function(task) == TASK_EXITED)
+      {
+         scheduler_remove(task);
+      }
+   }
+
+   return;
+}
@@ -0,0 +1,184 @@
+/********************************************************************************
+* scheduler.h: Innehåller funktionalitet för en kooperativ schemaläggare av
+*              stacklösa uppgifter i stil med protothreads. Varje uppgift är
+*              en vanlig funktion som körs från början till nästa
+*              väntepunkt, exempelvis task_yield, task_sleep eller
+*              task_wait_event, varefter den returnerar till schemaläggaren.
+*              Vid nästa anrop återupptas uppgiften vid väntepunkten via
+*              en switch-sats över radnumret där den avbröts. Samtliga
+*              uppgifter delar därmed huvudloopens stack, och varje uppgift
+*              kostar enbart sin strukt task i RAM.
+*
+*              Eftersom stacken inte bevaras mellan anropen bevaras inte
+*              heller lokala variabler över väntepunkter. Tillstånd som
+*              behövs efter en väntepunkt lagras i stället i strukten som
+*              medlemmen context pekar på, alternativt i statiska variabler.
+*              Av samma anledning kan switch-satser inte innehålla
+*              väntepunkter, och väntepunkter får endast användas direkt i
+*              uppgiftens funktion, inte i anropade funktioner.
+*
+*              Schemaläggaren körs från huvudloopen via scheduler_service,
+*              som först levererar samtliga event i eventkön till
+*              uppgifterna och därefter kör varje uppgift vars väntevillkor
+*              kan ha uppfyllts. Sovande uppgifter hoppas över utan anrop
+*              tills deras tid har löpt ut, så att periodiska uppgifter inte
+*              fördröjer övriga. Väntevillkor via task_wait_until kontrolleras
+*              vid varje varv, det vill säga efter varje avbrott.
+********************************************************************************/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "event_queue.h"
+
+/* Makrodefinitioner: */
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 4 /* Maximalt antal registrerade uppgifter. */
+#endif
+
+/********************************************************************************
+* task_status: Enumeration för returvärden från uppgifternas funktioner.
+********************************************************************************/
+enum task_status
+{
+   TASK_WAITING, /* Uppgiften väntar vid en väntepunkt. */
+   TASK_EXITED   /* Uppgiften har avslutats och avregistreras. */
+};
+
+struct task; /* Fördeklarerar inför deklaration av typen task_function_t. */
+
+/********************************************************************************
+* task_function_t: Typ för uppgifternas funktioner, som inleds med task_begin
+*                  och avslutas med task_end.
+********************************************************************************/
+typedef enum task_status (*task_function_t)(struct task* self);
+
+/********************************************************************************
+* task: Strukt för implementering av stacklösa uppgifter.
+********************************************************************************/
+typedef struct task
+{
+   task_function_t function; /* Uppgiftens funktion. */
+   void* context;            /* Pekare till uppgiftens tillstånd, se ovan. */
+   uint16_t line;            /* Radnummer där uppgiften återupptas, 0 = början. */
+   bool sleeping;            /* Indikerar ifall uppgiften sover via task_sleep. */
+   uint32_t wake_ms;         /* Tidpunkt då uppgiften senast väcktes eller ska väckas. */
+   event_t event;            /* Event som levereras, typen är EVENT_NONE mellan event. */
+} task_t;
+
+/********************************************************************************
+* task_begin: Inleder uppgiftens funktion och hoppar till den väntepunkt där
+*             uppgiften senast avbröts. Makrona för uppgifter är inte
+*             satsuttryck, eftersom case-etiketterna måste tillhöra
+*             switch-satsen i task_begin.
+*
+*             - self: Pekare till uppgiften.
+********************************************************************************/
+#define task_begin(self) switch ((self)->line) { case 0:
+
+/********************************************************************************
+* task_end: Avslutar uppgiftens funktion. Ifall uppgiften når hit avslutas
+*           den och avregistreras av schemaläggaren.
+*
+*           - self: Pekare till uppgiften.
+********************************************************************************/
+#define task_end(self) } (self)->line = 0; return TASK_EXITED
+
+/********************************************************************************
+* task_yield: Lämnar över till övriga uppgifter. Uppgiften återupptas efter
+*             väntepunkten vid nästa varv i schemaläggaren.
+*
+*             - self: Pekare till uppgiften.
+********************************************************************************/
+#define task_yield(self) do { \
+   (self)->line = __LINE__; \
+   return TASK_WAITING; \
+   case __LINE__:; \
+} while (0)
+
+/********************************************************************************
+* task_wait_until: Väntar tills angivet villkor är uppfyllt. Villkoret
+*                  kontrolleras direkt samt vid varje varv i schemaläggaren.
+*
+*                  - self     : Pekare till uppgiften.
+*                  - condition: Villkoret som ska vara uppfyllt.
+********************************************************************************/
+#define task_wait_until(self, condition) do { \
+   (self)->line = __LINE__; \
+   case __LINE__: \
+   if (!(condition)) return TASK_WAITING; \
+} while (0)
+
+/********************************************************************************
+* task_wait_event: Väntar tills ett event av angiven typ levereras. Eventet
+*                  kan därefter läsas av via medlemmen event fram till nästa
+*                  väntepunkt. Föregående event nollställs först, så att
+*                  varje väntan kräver ett nytt event. Event som levereras
+*                  medan uppgiften sover eller väntar på annan typ
+*                  förkastas för uppgiften.
+*
+*                  - self      : Pekare till uppgiften.
+*                  - event_type: Eventtypen som ska inväntas.
+********************************************************************************/
+#define task_wait_event(self, event_type) do { \
+   (self)->event.type = EVENT_NONE; \
+   task_wait_until(self, (self)->event.type == (event_type)); \
+} while (0)
+
+/********************************************************************************
+* task_sleep: Låter uppgiften sova angivet antal millisekunder räknat från
+*             tidpunkten då den senast väcktes. Uppgifter som sover i en
+*             loop körs därmed med fast period utan ackumulerad drift,
+*             oberoende av hur länge övriga uppgifter körs.
+*
+*             - self: Pekare till uppgiften.
+*             - ms  : Antalet millisekunder som uppgiften ska sova.
+********************************************************************************/
+#define task_sleep(self, ms) do { \
+   (self)->wake_ms += (ms); \
+   (self)->sleeping = true; \
+   task_yield(self); \
+} while (0)
+
+/********************************************************************************
+* scheduler_add: Registrerar angiven uppgift, som körs från början vid nästa
+*                varv i schemaläggaren. Ifall uppgiften lyckas registreras
+*                returneras 0. Om maximalt antal uppgifter redan är
+*                registrerade returneras felkod 1.
+*
+*                - self    : Pekare till uppgiften.
+*                - function: Uppgiftens funktion.
+*                - context : Pekare till uppgiftens tillstånd, eller null.
+********************************************************************************/
+int scheduler_add(task_t* self,
+                  const task_function_t function,
+                  void* context);
+
+/********************************************************************************
+* scheduler_remove: Avregistrerar angiven uppgift, som därmed inte längre
+*                   körs. Kan anropas från en uppgift, även för andra
+*                   uppgifter, utan att någon kvarvarande uppgift hoppas
+*                   över under pågående varv.
+*
+*                   - self: Pekare till uppgiften.
+********************************************************************************/
+void scheduler_remove(task_t* self);
+
+/********************************************************************************
+* scheduler_service: Kör ett varv i schemaläggaren. Varje event i eventkön
+*                    levereras till samtliga vakna uppgifter, varefter
+*                    uppgifterna körs en gång till utan event. Sovande
+*                    uppgifter körs först när deras tid har löpt ut.
+*                    Avslutade uppgifter avregistreras. Anropas från
+*                    huvudloopen, exempelvis före power_sleep.
+********************************************************************************/
+void scheduler_service(void);
+
+/********************************************************************************
+* scheduler_needs_timer: Indikerar ifall någon uppgift sover via task_sleep
+*                        och därmed behöver systemtimern för att väckas.
+********************************************************************************/
+bool scheduler_needs_timer(void);
+
+#endif /* SCHEDULER_H_ */
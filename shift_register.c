@@ -0,0 +1,220 @@
+/********************************************************************************
+* shift_register.c: Innehåller funktionsdefinitioner för lysdioder anslutna
+*                   via seriekopplade skiftregister av typen 74HC595.
+********************************************************************************/
+#include "shift_register.h"
+#include "timer.h"
+
+/* Makrodefinitioner: */
+#define SHIFT_REGISTER_MOSI 3 /* MOSI på I/O-port B (pin 11). */
+#define SHIFT_REGISTER_SCK 5  /* SCK på I/O-port B (pin 13). */
+#define SHIFT_REGISTER_SS 2   /* SS på I/O-port B (pin 10), måste vara utport. */
+
+/* Statiska funktioner: */
+static void shift_register_led_on(led_t* self);
+static void shift_register_led_off(led_t* self);
+static void shift_register_led_toggle(led_t* self);
+static void shift_register_led_blink(led_t* self,
+                                     const uint16_t blink_speed_ms);
+static void shift_register_write_frame(void);
+static led_vptr_t shift_register_vptr_new(void);
+
+/* Statiska variabler: */
+static volatile uint8_t shift_register_frame[SHIFT_REGISTER_CHIPS]; /* Bildbuffert, en byte per krets. */
+static volatile bool shift_register_dirty = false; /* Indikerar ändrad bildbuffert. */
+static volatile uint8_t shift_register_dummy_reg = 0; /* Ersättningsbyte för ogiltigt index. */
+static bool shift_register_enabled = false; /* Indikerar ifall SPI-enheten har initierats. */
+
+/********************************************************************************
+* shift_register_init: Initierar SPI-enheten som master med klockfrekvensen
+*                      F_CPU / 2, mest signifikant bit först. SS sätts till
+*                      utport, eftersom SPI-enheten annars kan växla till
+*                      slavläge. RCLK hålls låg mellan utskrivningarna.
+********************************************************************************/
+void shift_register_init(void)
+{
+   if (shift_register_enabled) return;
+
+   clr(PRR, PRSPI);
+   DDRB |= (1 << SHIFT_REGISTER_MOSI) | (1 << SHIFT_REGISTER_SCK) | (1 << SHIFT_REGISTER_SS);
+   pin_ddrx(SHIFT_REGISTER_LATCH_PIN) |= pin_mask(SHIFT_REGISTER_LATCH_PIN);
+   pin_portx(SHIFT_REGISTER_LATCH_PIN) &= ~pin_mask(SHIFT_REGISTER_LATCH_PIN);
+   SPCR = (1 << SPE) | (1 << MSTR);
+   SPSR = (1 << SPI2X);
+
+   shift_register_enabled = true;
+   shift_register_dirty = true;
+   timer_add_callback(shift_register_refresh);
+   return;
+}
+
+/********************************************************************************
+* shift_register_led_init: Initierar ny lysdiod ansluten till angiven utgång
+*                          i kedjan av skiftregister. Portpekaren sätts till
+*                          aktuell byte i bildbufferten, vilket medför att
+*                          lysdiodens tillstånd kan läsas av som för övriga
+*                          lysdioder, exempelvis av telemetrin.
+*
+*                          - self : Pekare till lysdioden som ska initieras.
+*                          - index: Utgångens index i kedjan.
+********************************************************************************/
+void shift_register_led_init(led_t* self,
+                             const uint8_t index)
+{
+   if (index < SHIFT_REGISTER_NUM_LEDS)
+   {
+      self->pin = index & 0x07;
+      self->mask = 1 << self->pin;
+      self->port = &shift_register_frame[index >> 3];
+   }
+   else
+   {
+      self->pin = 0;
+      self->mask = 0;
+      self->port = &shift_register_dummy_reg;
+   }
+
+   self->io_port = IO_PORT_NONE;
+   self->pin_reg = self->port;
+   self->enabled = false;
+   self->blink_speed_ms = 0;
+   self->blink_counter_ms = 0;
+   self->blink_next = 0;
+   self->vptr = shift_register_vptr_new();
+   return;
+}
+
+/********************************************************************************
+* shift_register_refresh: Skriver ut bildbufferten ifall den har ändrats
+*                         sedan föregående utskrivning.
+********************************************************************************/
+void shift_register_refresh(void)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+
+   if (shift_register_dirty && shift_register_enabled)
+   {
+      shift_register_dirty = false;
+      shift_register_write_frame();
+   }
+
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* shift_register_write_frame: Skiftar ut bildbufferten via SPI-enheten och
+*                             pulsar RCLK, varvid skiftregistrens utgångar
+*                             uppdateras samtidigt. Bytet till den sista
+*                             kretsen i kedjan skickas först. Överföringen
+*                             sker utan avbrott, eftersom en byte vid
+*                             F_CPU / 2 tar 16 klockcykler, vilket är
+*                             kortare än en avbrottsrutin.
+********************************************************************************/
+static void shift_register_write_frame(void)
+{
+   uint8_t i;
+
+   for (i = SHIFT_REGISTER_CHIPS; i > 0; --i)
+   {
+      SPDR = shift_register_frame[i - 1];
+      while (!read(SPSR, SPIF));
+   }
+
+   pin_portx(SHIFT_REGISTER_LATCH_PIN) |= pin_mask(SHIFT_REGISTER_LATCH_PIN);
+   pin_portx(SHIFT_REGISTER_LATCH_PIN) &= ~pin_mask(SHIFT_REGISTER_LATCH_PIN);
+   return;
+}
+
+/********************************************************************************
+* shift_register_led_on: Tänder angiven lysdiod i bildbufferten. Bufferten
+*                        markeras som ändrad efter skrivningen, så att en
+*                        utskrivning som sker däremellan aldrig missar
+*                        ändringen. Bildbufferten uppdateras med avbrott
+*                        inaktiverade, eftersom asynkron blinkning samt
+*                        blinkmönster kan skriva till samma byte från
+*                        avbrottsrutiner.
+*
+*                        - self: Pekare till lysdioden som ska tändas.
+********************************************************************************/
+static void shift_register_led_on(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   *self->port |= self->mask;
+   self->enabled = true;
+   shift_register_dirty = true;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* shift_register_led_off: Släcker angiven lysdiod i bildbufferten, med
+*                         avbrott inaktiverade.
+*
+*                         - self: Pekare till lysdioden som ska släckas.
+********************************************************************************/
+static void shift_register_led_off(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   *self->port &= ~self->mask;
+   self->enabled = false;
+   shift_register_dirty = true;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* shift_register_led_toggle: Togglar angiven lysdiod i bildbufferten, med
+*                            avbrott inaktiverade.
+*
+*                            - self: Pekare till lysdioden som ska togglas.
+********************************************************************************/
+static void shift_register_led_toggle(led_t* self)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   *self->port ^= self->mask;
+   self->enabled = !self->enabled;
+   shift_register_dirty = true;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* shift_register_led_blink: Blinkar lysdiod en gång med angiven
+*                           blinkhastighet. Utskrivning sker av
+*                           systemtimern under fördröjningen.
+*
+*                           - self          : Pekare till lysdioden som ska
+*                                             blinkas.
+*                           - blink_speed_ms: Blinkhastigheten mätt i
+*                                             millisekunder.
+********************************************************************************/
+static void shift_register_led_blink(led_t* self,
+                                     const uint16_t blink_speed_ms)
+{
+   shift_register_led_toggle(self);
+   delay_ms(blink_speed_ms);
+   return;
+}
+
+/********************************************************************************
+* shift_register_vptr_new: Returnerar en pekare till ett vtable innehållande
+*                          pekare till associerade funktioner för lysdioder
+*                          anslutna via skiftregister.
+********************************************************************************/
+static led_vptr_t shift_register_vptr_new(void)
+{
+   static struct led_vtable self =
+   {
+      .on = shift_register_led_on,
+      .off = shift_register_led_off,
+      .toggle = shift_register_led_toggle,
+      .blink = shift_register_led_blink,
+   };
+
+   return &self;
+}
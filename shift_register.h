@@ -0,0 +1,88 @@
+/********************************************************************************
+* shift_register.h: Innehåller funktionalitet för lysdioder anslutna via en
+*                   kedja av skiftregister av typen 74HC595, som matas via
+*                   SPI-enheten. Varje lysdiod utgörs av ett objekt av
+*                   strukten led, se led.h, vars portpekare pekar på en byte
+*                   i en bildbuffert i RAM i stället för ett portregister.
+*                   Lysdioderna har ett eget vtable, där tändning, släckning
+*                   och toggling enbart uppdaterar bildbufferten. Därmed
+*                   fungerar led-arrayer, blinkmönster, asynkron blinkning
+*                   samt telemetri oförändrat. Portmaskerna i led_array.h
+*                   omfattar dock endast lysdioder på I/O-port B, C och D.
+*
+*                   Bildbufferten skrivs ut i sin helhet av systemtimern
+*                   högst en gång per millisekund, och enbart ifall den har
+*                   ändrats sedan föregående utskrivning. Ändringar gjorda
+*                   under samma millisekund skrivs därmed ut som en bildruta.
+*                   Skiftregistrens utgångsregister utgör den andra
+*                   bufferten: utgångarna ändras först när hela bildrutan
+*                   har skiftats in och RCLK pulsas, vilket medför att
+*                   samtliga lysdioder uppdateras samtidigt.
+*
+*                   Anslutning: MOSI (pin 11) till SER på första kretsen,
+*                   SCK (pin 13) till SRCLK på samtliga kretsar samt
+*                   SHIFT_REGISTER_LATCH_PIN (standard pin 10) till RCLK på
+*                   samtliga kretsar. QH' ansluts till SER på nästa krets.
+*                   Lysdiod i motsvarar utgång Q(i % 8) på krets i / 8,
+*                   räknat från kretsen närmast mikrodatorn. Pin 11 - 13 kan
+*                   därmed inte användas till annat.
+*
+*                   Varje lysdiod kräver ett objekt av strukten led samt en
+*                   pekare i led-arrayen, vilket för 64 lysdioder motsvarar
+*                   drygt 1 kB RAM.
+********************************************************************************/
+#ifndef SHIFT_REGISTER_H_
+#define SHIFT_REGISTER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led.h"
+
+/* Makrodefinitioner: */
+#ifndef SHIFT_REGISTER_CHIPS
+#define SHIFT_REGISTER_CHIPS 8 /* Antalet seriekopplade kretsar, åtta lysdioder per krets. */
+#endif
+
+#ifndef SHIFT_REGISTER_LATCH_PIN
+#define SHIFT_REGISTER_LATCH_PIN 10 /* Pin ansluten till RCLK, måste vara en konstant. */
+#endif
+
+#define SHIFT_REGISTER_NUM_LEDS (SHIFT_REGISTER_CHIPS * 8) /* Antalet lysdioder i kedjan. */
+
+#if SHIFT_REGISTER_CHIPS < 1 || SHIFT_REGISTER_CHIPS > 32
+#error "SHIFT_REGISTER_CHIPS måste vara mellan 1 och 32!"
+#endif
+
+/********************************************************************************
+* shift_register_init: Initierar SPI-enheten som master med klockfrekvensen
+*                      F_CPU / 2 samt registrerar utskrivning av bildbufferten
+*                      hos systemtimern, som initieras vid behov. Samtliga
+*                      lysdioder släcks vid första utskrivningen. Upprepade
+*                      anrop har ingen effekt.
+********************************************************************************/
+void shift_register_init(void);
+
+/********************************************************************************
+* shift_register_led_init: Initierar ny lysdiod ansluten till angiven utgång
+*                          i kedjan av skiftregister. Lysdioden nollställs
+*                          via led_clear som vanligt. Ifall index ligger
+*                          utanför kedjan påverkar lysdioden ingen utgång.
+*
+*                          - self : Pekare till lysdioden som ska initieras.
+*                          - index: Utgångens index i kedjan, 0 - 
+*                                   SHIFT_REGISTER_NUM_LEDS - 1.
+********************************************************************************/
+void shift_register_led_init(led_t* self,
+                             const uint8_t index);
+
+/********************************************************************************
+* shift_register_refresh: Skriver ut bildbufferten direkt ifall den har
+*                         ändrats sedan föregående utskrivning. Anropas
+*                         automatiskt av systemtimern, men kan anropas för
+*                         att visa en ändring utan att invänta nästa
+*                         millisekund. Utskrivningen sker med avbrott
+*                         inaktiverade.
+********************************************************************************/
+void shift_register_refresh(void);
+
+#endif /* SHIFT_REGISTER_H_ */
@@ -0,0 +1,299 @@
+/********************************************************************************
+* cycles.c: Mätprogram som kompileras med avr-gcc för ATmega328P och körs i
+*           simavr via run_cycles. Varje operation omges av markörer, se
+*           cycles.h. Samtliga led-arrayer innehåller fem lysdioder på
+*           pin 6 - 10, dvs. samma uppsättning som i main.c, fördelade över
+*           I/O-port B och D. Blinkfunktionerna mäts inte, eftersom deras
+*           exekveringstid domineras av fördröjningen. Avbrottsrutinen för
+*           mjukvaru-PWM samt radbytet i lysdiodmatrisen mäts sist, med
+*           avbrott inaktiverade.
+********************************************************************************/
+#include "../led.h"
+#include "../button.h"
+#include "../led_array.h"
+#include "../matrix.h"
+#include "../pwm.h"
+#include "cycles.h"
+
+/* Makrodefinitioner: */
+#define CYCLES_NUM_LEDS 5 /* Antalet lysdioder i mätningarnas led-arrayer. */
+
+/********************************************************************************
+* cycles_begin: Startar mätning med angivet id. Kompilatorbarriärerna
+*               förhindrar att minnesoperationer flyttas förbi markören.
+*
+*               - id: Mätningens id, se enumerationen cycles_id.
+********************************************************************************/
+#define cycles_begin(id) ({ \
+   __asm__ __volatile__("" ::: "memory"); \
+   GPIOR0 = (id); \
+   __asm__ __volatile__("" ::: "memory"); \
+})
+
+/********************************************************************************
+* cycles_end: Avslutar pågående mätning.
+********************************************************************************/
+#define cycles_end() ({ \
+   __asm__ __volatile__("" ::: "memory"); \
+   GPIOR0 = CYCLES_END; \
+   __asm__ __volatile__("" ::: "memory"); \
+})
+
+/* Statiska variabler: */
+static led_t cycles_leds[CYCLES_NUM_LEDS];
+static led_t* cycles_storage[CYCLES_NUM_LEDS];
+static button_t cycles_button;
+
+/********************************************************************************
+* cycles_led: Mäter initiering, tändning, släckning och toggling av lysdiod
+*             samt initiering och avläsning av tryckknapp.
+********************************************************************************/
+static void cycles_led(void)
+{
+   uint8_t i;
+
+   cycles_begin(CYCLES_LED_INIT);
+   led_init(&cycles_leds[0], 6);
+   cycles_end();
+
+   for (i = 1; i < CYCLES_NUM_LEDS; ++i)
+   {
+      led_init(&cycles_leds[i], 6 + i);
+   }
+
+   cycles_begin(CYCLES_LED_ON);
+   cycles_leds[0].vptr->on(&cycles_leds[0]);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_OFF);
+   cycles_leds[0].vptr->off(&cycles_leds[0]);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_TOGGLE);
+   cycles_leds[0].vptr->toggle(&cycles_leds[0]);
+   cycles_end();
+
+   cycles_begin(CYCLES_BUTTON_INIT);
+   button_init(&cycles_button, 13);
+   cycles_end();
+
+   cycles_begin(CYCLES_BUTTON_IS_PRESSED);
+   GPIOR1 = cycles_button.vptr->is_pressed(&cycles_button);
+   cycles_end();
+   return;
+}
+
+/********************************************************************************
+* cycles_led_array_static: Mäter operationer på en led-array med statiskt
+*                          minne.
+********************************************************************************/
+static void cycles_led_array_static(void)
+{
+   led_array_t leds;
+   uint8_t i;
+
+   cycles_begin(CYCLES_LED_ARRAY_INIT_STATIC);
+   led_array_init_static(&leds, cycles_storage, CYCLES_NUM_LEDS);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_PUSH_STATIC);
+   led_array_push(&leds, &cycles_leds[0]);
+   cycles_end();
+
+   for (i = 1; i < CYCLES_NUM_LEDS; ++i)
+   {
+      led_array_push(&leds, &cycles_leds[i]);
+   }
+
+   cycles_begin(CYCLES_LED_ARRAY_ON);
+   led_array_on(&leds);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_OFF);
+   led_array_off(&leds);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_MASK_UPDATE);
+   led_array_mask_update(&leds.mask, leds.leds, leds.size);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_MASK_ON);
+   led_array_mask_on(&leds.mask);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_MASK_OFF);
+   led_array_mask_off(&leds.mask);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_MASK_TOGGLE);
+   led_array_mask_toggle(&leds.mask);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_MASK_SET);
+   led_array_mask_set(&leds.mask, &leds.mask);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_POP);
+   led_array_pop(&leds);
+   cycles_end();
+   return;
+}
+
+/********************************************************************************
+* cycles_led_array_dynamic: Mäter operationer på en led-array med dynamiskt
+*                           allokerat minne. Första tillägget allokerar minne
+*                           för LED_ARRAY_MIN_CAPACITY lysdioder, tillägget
+*                           därefter som överskrider kapaciteten omallokerar.
+********************************************************************************/
+static void cycles_led_array_dynamic(void)
+{
+   led_array_t leds;
+   uint8_t i;
+
+   cycles_begin(CYCLES_LED_ARRAY_INIT);
+   led_array_init(&leds);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_PUSH_FIRST);
+   led_array_push(&leds, &cycles_leds[0]);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_PUSH);
+   led_array_push(&leds, &cycles_leds[1]);
+   cycles_end();
+
+   for (i = 2; i < LED_ARRAY_MIN_CAPACITY; ++i)
+   {
+      led_array_push(&leds, &cycles_leds[i]);
+   }
+
+   cycles_begin(CYCLES_LED_ARRAY_PUSH_GROW);
+   led_array_push(&leds, &cycles_leds[LED_ARRAY_MIN_CAPACITY]);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_SHRINK_TO_FIT);
+   led_array_shrink_to_fit(&leds);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_RESERVE);
+   led_array_reserve(&leds, 2 * CYCLES_NUM_LEDS);
+   cycles_end();
+
+   cycles_begin(CYCLES_LED_ARRAY_CLEAR);
+   led_array_clear(&leds);
+   cycles_end();
+   return;
+}
+
+/********************************************************************************
+* TIMER2_COMPA_vect: Avbrottsrutinen för mjukvaru-PWM, se pwm.c, deklareras
+*                    här så att den kan anropas direkt vid mätningen.
+********************************************************************************/
+void TIMER2_COMPA_vect(void);
+
+/********************************************************************************
+* cycles_pwm: Mäter avbrottsrutinen för mjukvaru-PWM med fem dimrade
+*             lysdioder, fördelade över I/O-port B och D. Rutinens kostnad
+*             är oberoende av antalet lysdioder. Avbrottet från Timer 2
+*             inaktiveras och rutinen anropas direkt, vilket inkluderar
+*             in- och uthopp (call samt reti) men inte hoppet via
+*             avbrottsvektorn (tre klockcykler) samt hårdvarans svarstid.
+*             Eftersom reti aktiverar avbrott inaktiveras dessa igen efter
+*             mätningen.
+********************************************************************************/
+static void cycles_pwm(void)
+{
+   uint8_t i;
+
+   for (i = 0; i < CYCLES_NUM_LEDS; ++i)
+   {
+      pwm_set_brightness(&cycles_leds[i], 0x55);
+   }
+
+   cli();
+   clr(TIMSK2, OCIE2A);
+
+   cycles_begin(CYCLES_PWM_ISR);
+   TIMER2_COMPA_vect();
+   cycles_end();
+   cli();
+
+   for (i = 0; i < CYCLES_NUM_LEDS; ++i)
+   {
+      pwm_release(&cycles_leds[i]);
+   }
+
+   return;
+}
+
+/********************************************************************************
+* cycles_matrix: Mäter radbytet i en multiplexerad matris med fyra rader och
+*                fyra kolumner samt i en charlieplexad matris med åtta
+*                pinnar, fördelade över I/O-port B och D. Systemtimern
+*                aktiverar avbrott vid initieringen, varför avbrott
+*                inaktiveras före mätningarna.
+********************************************************************************/
+static void cycles_matrix(void)
+{
+   const uint8_t rows[4] = { 2, 3, 4, 5 };
+   const uint8_t columns[4] = { 6, 7, 8, 9 };
+   const uint8_t pins[8] = { 2, 3, 4, 5, 6, 7, 8, 9 };
+   uint8_t r, c;
+
+   matrix_init(rows, 4, columns, 4);
+   cli();
+
+   for (r = 0; r < 4; ++r)
+   {
+      for (c = 0; c < 4; ++c)
+      {
+         matrix_led_init(&cycles_leds[0], r, c);
+         cycles_leds[0].vptr->on(&cycles_leds[0]);
+      }
+   }
+
+   cycles_begin(CYCLES_MATRIX_SCAN);
+   matrix_scan();
+   cycles_end();
+
+   matrix_init_charlieplexed(pins, 8);
+   cli();
+
+   for (r = 0; r < 8; ++r)
+   {
+      for (c = 0; c < 8; ++c)
+      {
+         matrix_led_init(&cycles_leds[0], r, c);
+         cycles_leds[0].vptr->on(&cycles_leds[0]);
+      }
+   }
+
+   cycles_begin(CYCLES_MATRIX_SCAN_CHARLIEPLEXED);
+   matrix_scan();
+   cycles_end();
+   matrix_stop();
+   return;
+}
+
+/********************************************************************************
+* main: Genomför samtliga mätningar och signalerar därefter att körningen är
+*       klar, varefter processorn försätts i viloläge med avbrott
+*       inaktiverade, vilket avslutar simuleringen.
+********************************************************************************/
+int main(void)
+{
+   cycles_begin(CYCLES_EMPTY);
+   cycles_end();
+
+   cycles_led();
+   cycles_led_array_static();
+   cycles_led_array_dynamic();
+   cycles_pwm();
+   cycles_matrix();
+
+   GPIOR0 = CYCLES_DONE;
+   cli();
+   SMCR = (1 << SE);
+   __asm__ __volatile__("sleep");
+   return 0;
+}
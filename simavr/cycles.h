@@ -0,0 +1,96 @@
+/********************************************************************************
+* cycles.h: Gemensamma definitioner för cykelmätningarna i simavr. Mätningarna
+*           körs av cycles.c, som kompileras med avr-gcc för ATmega328P.
+*           Varje mätning omges av markörer i form av skrivningar till
+*           registret GPIOR0, som fångas upp av run_cycles.c i simavr:
+*
+*           GPIOR0 = id   : Mätning id startar.
+*           GPIOR0 = 0    : Pågående mätning avslutas.
+*           GPIOR0 = 0xFF : Samtliga mätningar är genomförda.
+*
+*           Antalet cykler mellan markörerna minskas med resultatet för den
+*           tomma mätningen CYCLES_EMPTY, så att markörernas kostnad inte
+*           ingår i rapporterade värden.
+********************************************************************************/
+#ifndef CYCLES_H_
+#define CYCLES_H_
+
+/* Makrodefinitioner: */
+#define CYCLES_END 0x00  /* Markör för avslutad mätning. */
+#define CYCLES_DONE 0xFF /* Markör för samtliga mätningar genomförda. */
+
+/********************************************************************************
+* cycles_id: Enumeration för mätningarna. Ordningen måste överensstämma med
+*            namnen i cycles_names.
+********************************************************************************/
+enum cycles_id
+{
+   CYCLES_EMPTY = 1,
+   CYCLES_LED_INIT,
+   CYCLES_LED_ON,
+   CYCLES_LED_OFF,
+   CYCLES_LED_TOGGLE,
+   CYCLES_BUTTON_INIT,
+   CYCLES_BUTTON_IS_PRESSED,
+   CYCLES_LED_ARRAY_INIT,
+   CYCLES_LED_ARRAY_INIT_STATIC,
+   CYCLES_LED_ARRAY_PUSH_STATIC,
+   CYCLES_LED_ARRAY_PUSH_FIRST,
+   CYCLES_LED_ARRAY_PUSH_GROW,
+   CYCLES_LED_ARRAY_PUSH,
+   CYCLES_LED_ARRAY_POP,
+   CYCLES_LED_ARRAY_RESERVE,
+   CYCLES_LED_ARRAY_SHRINK_TO_FIT,
+   CYCLES_LED_ARRAY_ON,
+   CYCLES_LED_ARRAY_OFF,
+   CYCLES_LED_ARRAY_MASK_UPDATE,
+   CYCLES_LED_ARRAY_MASK_ON,
+   CYCLES_LED_ARRAY_MASK_OFF,
+   CYCLES_LED_ARRAY_MASK_TOGGLE,
+   CYCLES_LED_ARRAY_MASK_SET,
+   CYCLES_LED_ARRAY_CLEAR,
+   CYCLES_PWM_ISR,
+   CYCLES_MATRIX_SCAN,
+   CYCLES_MATRIX_SCAN_CHARLIEPLEXED,
+   CYCLES_NUM_IDS
+};
+
+/********************************************************************************
+* cycles_names: Mätningarnas namn i samma ordning som enumerationen
+*               cycles_id, används enbart av run_cycles.c på värddatorn.
+********************************************************************************/
+#ifndef __AVR__
+static const char* const cycles_names[CYCLES_NUM_IDS] =
+{
+   0,
+   "empty",
+   "led_init",
+   "led_on",
+   "led_off",
+   "led_toggle",
+   "button_init",
+   "button_is_pressed",
+   "led_array_init",
+   "led_array_init_static",
+   "led_array_push (static)",
+   "led_array_push (first)",
+   "led_array_push (grow)",
+   "led_array_push",
+   "led_array_pop",
+   "led_array_reserve",
+   "led_array_shrink_to_fit",
+   "led_array_on",
+   "led_array_off",
+   "led_array_mask_update",
+   "led_array_mask_on",
+   "led_array_mask_off",
+   "led_array_mask_toggle",
+   "led_array_mask_set",
+   "led_array_clear",
+   "pwm isr (TIMER2_COMPA_vect)",
+   "matrix_scan (4 x 4)",
+   "matrix_scan (charlieplexed, 8 pins)",
+};
+#endif /* __AVR__ */
+
+#endif /* CYCLES_H_ */
@@ -0,0 +1,129 @@
+/********************************************************************************
+* run_cycles.c: Kör mätprogrammet cycles.c i simavr och skriver ut exakt
+*               antal klockcykler per mätning. Skrivningar till GPIOR0
+*               fångas upp och tidsstämplas med simulatorns cykelräknare,
+*               se cycles.h. Resultatet skrivs ut med en mätning per rad
+*               på formatet "namn<TAB>cykler", vilket jämförs mot sparade
+*               referensvärden av Makefile.
+*
+*               Användning: run_cycles <firmware.elf>
+********************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include "cycles.h"
+
+/* Makrodefinitioner: */
+#define GPIOR0_ADDR 0x3E                /* GPIOR0:s adress i dataminnet. */
+#define RUN_CYCLES_LIMIT 100000000ULL /* Högsta antal cykler innan avbrott. */
+
+/* Statiska variabler: */
+static avr_cycle_count_t run_cycles_start;            /* Pågående mätnings start. */
+static uint8_t run_cycles_current = 0;                  /* Pågående mätnings id. */
+static long run_cycles_result[CYCLES_NUM_IDS];          /* Uppmätta cykler, -1 = saknas. */
+static int run_cycles_done = 0;                         /* Indikerar att körningen är klar. */
+
+/********************************************************************************
+* run_cycles_marker: Anropas av simavr vid skrivning till GPIOR0. Startar,
+*                    avslutar eller registrerar slutet på mätningarna.
+********************************************************************************/
+static void run_cycles_marker(struct avr_t* avr,
+                              avr_io_addr_t addr,
+                              uint8_t value,
+                              void* param)
+{
+   (void)param;
+   avr->data[addr] = value;
+
+   if (value == CYCLES_DONE)
+   {
+      run_cycles_done = 1;
+   }
+   else if (value == CYCLES_END)
+   {
+      if (run_cycles_current)
+      {
+         run_cycles_result[run_cycles_current] = (long)(avr->cycle - run_cycles_start);
+         run_cycles_current = 0;
+      }
+   }
+   else if (value < CYCLES_NUM_IDS)
+   {
+      run_cycles_current = value;
+      run_cycles_start = avr->cycle;
+   }
+   return;
+}
+
+/********************************************************************************
+* main: Laddar angiven firmware i en simulerad ATmega328P, kör denna tills
+*       samtliga mätningar är genomförda och skriver ut resultatet.
+*       Returnerar 1 vid fel, exempelvis saknade mätningar.
+********************************************************************************/
+int main(int argc, char** argv)
+{
+   elf_firmware_t firmware;
+   avr_t* avr;
+   int state = cpu_Running;
+   int status = 0;
+   long overhead;
+   int i;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "usage: %s <firmware.elf>\n", argv[0]);
+      return 1;
+   }
+
+   if (elf_read_firmware(argv[1], &firmware))
+   {
+      fprintf(stderr, "run_cycles: cannot read %s\n", argv[1]);
+      return 1;
+   }
+
+   avr = avr_make_mcu_by_name("atmega328p");
+   if (!avr)
+   {
+      fprintf(stderr, "run_cycles: atmega328p not supported by simavr\n");
+      return 1;
+   }
+
+   avr_init(avr);
+   avr->frequency = 16000000;
+   avr_load_firmware(avr, &firmware);
+   avr_register_io_write(avr, GPIOR0_ADDR, run_cycles_marker, 0);
+
+   for (i = 0; i < CYCLES_NUM_IDS; ++i)
+   {
+      run_cycles_result[i] = -1;
+   }
+
+   while (!run_cycles_done && state != cpu_Done && state != cpu_Crashed &&
+          avr->cycle < RUN_CYCLES_LIMIT)
+   {
+      state = avr_run(avr);
+   }
+
+   if (!run_cycles_done)
+   {
+      fprintf(stderr, "run_cycles: firmware did not finish (state %d)\n", state);
+      return 1;
+   }
+
+   overhead = run_cycles_result[CYCLES_EMPTY];
+   if (overhead < 0) overhead = 0;
+
+   for (i = CYCLES_EMPTY + 1; i < CYCLES_NUM_IDS; ++i)
+   {
+      if (run_cycles_result[i] < 0)
+      {
+         fprintf(stderr, "run_cycles: no result for %s\n", cycles_names[i]);
+         status = 1;
+         continue;
+      }
+      printf("%s\t%ld\n", cycles_names[i], run_cycles_result[i] - overhead);
+   }
+   return status;
+}
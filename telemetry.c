@@ -0,0 +1,190 @@
+/********************************************************************************
+* telemetry.c: Innehåller funktionsdefinitioner för telemetriströmmen.
+********************************************************************************/
+#include "telemetry.h"
+#include "uart.h"
+#include "timer.h"
+#include "event_queue.h"
+
+/* Statiska funktioner: */
+static void telemetry_timer(void);
+static uint8_t* telemetry_put16(uint8_t* dest,
+                                const uint16_t value);
+
+/* Statiska variabler: */
+static const led_array_t* telemetry_leds = 0; /* Rapporterade lysdioder. */
+static const button_group_t* telemetry_buttons = 0; /* Rapporterade tryckknappar. */
+static volatile uint16_t telemetry_period_ms = 0; /* Tid mellan paketen. */
+static volatile uint16_t telemetry_counter_ms = 0; /* Förfluten tid sedan senaste paket. */
+static volatile bool telemetry_due = false; /* Indikerar att nästa paket ska skickas. */
+static volatile uint16_t telemetry_presses = 0; /* Antalet nedtryckningar sedan start. */
+static button_group_t telemetry_last_pressed; /* Nedtryckta tryckknappar vid senaste avläsning. */
+static uint8_t telemetry_mode = 0; /* Applikationens läge. */
+static uint8_t telemetry_sequence = 0; /* Nästa pakets sekvensnummer. */
+
+/********************************************************************************
+* telemetry_init: Startar telemetriströmmen för angiven led-array och grupp
+*                 av tryckknappar.
+*
+*                 - leds     : Pekare till arrayen vars lysdioder rapporteras.
+*                 - buttons  : Pekare till gruppen vars tryckknappar
+*                              rapporteras.
+*                 - period_ms: Tid mellan paketen mätt i millisekunder.
+********************************************************************************/
+void telemetry_init(const led_array_t* leds,
+                    const button_group_t* buttons,
+                    const uint16_t period_ms)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   telemetry_leds = leds;
+   telemetry_buttons = buttons;
+   button_group_read(buttons, &telemetry_last_pressed);
+   atomic_end(sreg);
+
+   telemetry_set_period(period_ms);
+   timer_add_callback(telemetry_timer);
+   return;
+}
+
+/********************************************************************************
+* telemetry_set_period: Sätter tiden mellan paketen. Räknaren nollställs, så
+*                       att nästa paket skickas efter en hel period.
+*
+*                       - period_ms: Tid mellan paketen mätt i millisekunder.
+********************************************************************************/
+void telemetry_set_period(const uint16_t period_ms)
+{
+   uint8_t sreg;
+   atomic_begin(sreg);
+   telemetry_period_ms = period_ms;
+   telemetry_counter_ms = 0;
+   telemetry_due = false;
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* telemetry_set_mode: Sätter applikationens läge.
+*
+*                     - mode: Applikationens läge.
+********************************************************************************/
+void telemetry_set_mode(const uint8_t mode)
+{
+   telemetry_mode = mode;
+   return;
+}
+
+/********************************************************************************
+* telemetry_service: Bygger och skickar nästa paket ifall dess tid har
+*                    infallit. Ifall sändbufferten är full förkastas paketet,
+*                    vilket framgår av räknaren i nästa paket.
+********************************************************************************/
+bool telemetry_service(void)
+{
+   uint8_t frame[TELEMETRY_FRAME_SIZE];
+   if (!telemetry_due) return false;
+   telemetry_due = false;
+   telemetry_build(frame);
+   return uart_write(frame, TELEMETRY_FRAME_SIZE);
+}
+
+/********************************************************************************
+* telemetry_build: Bygger ett paket med aktuellt tillstånd i angiven buffert.
+*                  Lysdiodernas tillstånd läses av från portregistren, så att
+*                  även lysdioder som styrs via portmasker rapporteras
+*                  korrekt.
+*
+*                  - frame: Buffert rymmande TELEMETRY_FRAME_SIZE byte.
+********************************************************************************/
+void telemetry_build(uint8_t* frame)
+{
+   const uint32_t now = millis();
+   button_group_t pressed = { 0, 0, 0 };
+   uint16_t leds = 0;
+   uint16_t presses;
+   uint8_t* dest = frame;
+   uint8_t checksum = 0;
+   uint8_t sreg;
+   uint8_t i;
+
+   if (telemetry_leds)
+   {
+      for (i = 0; i < telemetry_leds->size && i < 16; ++i)
+      {
+         const led_t* led = telemetry_leds->leds[i];
+         if (*led->port & led->mask) leds |= (uint16_t)1 << i;
+      }
+   }
+
+   if (telemetry_buttons) button_group_read(telemetry_buttons, &pressed);
+
+   atomic_begin(sreg);
+   presses = telemetry_presses;
+   atomic_end(sreg);
+
+   *dest++ = TELEMETRY_SYNC;
+   *dest++ = TELEMETRY_FRAME_SIZE - 3;
+   *dest++ = telemetry_sequence++;
+   dest = telemetry_put16(dest, (uint16_t)now);
+   dest = telemetry_put16(dest, (uint16_t)(now >> 16));
+   dest = telemetry_put16(dest, leds);
+   *dest++ = pressed.portb;
+   *dest++ = pressed.portc;
+   *dest++ = pressed.portd;
+   dest = telemetry_put16(dest, presses);
+   *dest++ = telemetry_mode;
+   dest = telemetry_put16(dest, event_queue_overflows());
+   dest = telemetry_put16(dest, uart_tx_dropped());
+
+   for (i = 1; i < TELEMETRY_FRAME_SIZE - 1; ++i)
+   {
+      checksum ^= frame[i];
+   }
+
+   *dest = checksum;
+   return;
+}
+
+/********************************************************************************
+* telemetry_put16: Lagrar angivet 16-bitars värde med minst signifikant byte
+*                  först och returnerar adressen efter värdet.
+*
+*                  - dest : Adressen där värdet ska lagras.
+*                  - value: Värdet som ska lagras.
+********************************************************************************/
+static uint8_t* telemetry_put16(uint8_t* dest,
+                                const uint16_t value)
+{
+   *dest++ = (uint8_t)value;
+   *dest++ = (uint8_t)(value >> 8);
+   return dest;
+}
+
+/********************************************************************************
+* telemetry_timer: Anropas av systemtimern en gång per millisekund. Nya
+*                  nedtryckningar räknas genom jämförelse med föregående
+*                  avläsning, varefter nästa paket markeras när perioden har
+*                  löpt ut.
+********************************************************************************/
+static void telemetry_timer(void)
+{
+   button_group_t pressed, new_pressed;
+
+   if (telemetry_buttons)
+   {
+      button_group_read(telemetry_buttons, &pressed);
+      new_pressed.portb = pressed.portb & ~telemetry_last_pressed.portb;
+      new_pressed.portc = pressed.portc & ~telemetry_last_pressed.portc;
+      new_pressed.portd = pressed.portd & ~telemetry_last_pressed.portd;
+      telemetry_presses += button_group_count(&new_pressed);
+      telemetry_last_pressed = pressed;
+   }
+
+   if (telemetry_period_ms && ++telemetry_counter_ms >= telemetry_period_ms)
+   {
+      telemetry_counter_ms = 0;
+      telemetry_due = true;
+   }
+   return;
+}
@@ -0,0 +1,85 @@
+/********************************************************************************
+* telemetry.h: Innehåller funktionalitet för en kompakt binär telemetriström
+*              via USART0, se uart.h. Med angiven periodtid skickas ett paket
+*              innehållande lysdiodernas och tryckknapparnas tillstånd samt
+*              diverse räknare. Systemtimern markerar när nästa paket ska
+*              skickas och räknar nedtryckningar, medan paketet byggs och
+*              skickas från huvudloopen via telemetry_service.
+*
+*              Paketformat (TELEMETRY_FRAME_SIZE byte, flerbytesfält lagras
+*              med minst signifikant byte först):
+*
+*              Byte   Innehåll
+*               0     Synkbyte TELEMETRY_SYNC (0xA5).
+*               1     Antalet byte mellan längdbyten och kontrollsumman (17).
+*               2     Sekvensnummer, räknas upp för varje skickat paket.
+*              3 - 6  Förfluten tid i millisekunder (millis).
+*              7 - 8  Tända lysdioder, bit i motsvarar lysdiod i i arrayen.
+*              9 - 11 Nedtryckta tryckknappar som bitmask för port B, C och D.
+*             12 - 13 Antalet nedtryckningar sedan start.
+*               14    Applikationens läge, se telemetry_set_mode.
+*             15 - 16 Antalet förlorade event i eventkön.
+*             17 - 18 Antalet förkastade byte i sändbufferten.
+*               19    Kontrollsumma, XOR av byte 1 - 18.
+********************************************************************************/
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "led_array.h"
+#include "button_group.h"
+
+/* Makrodefinitioner: */
+#define TELEMETRY_SYNC 0xA5      /* Synkbyte i början av varje paket. */
+#define TELEMETRY_FRAME_SIZE 20 /* Paketets storlek mätt i byte. */
+
+/********************************************************************************
+* telemetry_init: Startar telemetriströmmen för angiven led-array och grupp
+*                 av tryckknappar. Systemtimern initieras vid behov. USART0
+*                 måste ha initierats via uart_init.
+*
+*                 - leds     : Pekare till arrayen vars lysdioder rapporteras.
+*                              Endast de 16 första lysdioderna ingår.
+*                 - buttons  : Pekare till gruppen vars tryckknappar
+*                              rapporteras.
+*                 - period_ms: Tid mellan paketen mätt i millisekunder,
+*                              0 = inga paket skickas.
+********************************************************************************/
+void telemetry_init(const led_array_t* leds,
+                    const button_group_t* buttons,
+                    const uint16_t period_ms);
+
+/********************************************************************************
+* telemetry_set_period: Sätter tiden mellan paketen.
+*
+*                       - period_ms: Tid mellan paketen mätt i millisekunder,
+*                                    0 = inga paket skickas.
+********************************************************************************/
+void telemetry_set_period(const uint16_t period_ms);
+
+/********************************************************************************
+* telemetry_set_mode: Sätter applikationens läge, som rapporteras i varje
+*                     paket, exempelvis aktuellt blinkmönster.
+*
+*                     - mode: Applikationens läge.
+********************************************************************************/
+void telemetry_set_mode(const uint8_t mode);
+
+/********************************************************************************
+* telemetry_service: Bygger och skickar nästa paket ifall dess tid har
+*                    infallit. Anropas kontinuerligt från huvudloopen.
+*                    Returnerar true ifall ett paket lades i sändbufferten.
+********************************************************************************/
+bool telemetry_service(void);
+
+/********************************************************************************
+* telemetry_build: Bygger ett paket med aktuellt tillstånd i angiven buffert
+*                  och räknar upp sekvensnumret. Används av
+*                  telemetry_service, men kan även anropas direkt.
+*
+*                  - frame: Buffert rymmande TELEMETRY_FRAME_SIZE byte.
+********************************************************************************/
+void telemetry_build(uint8_t* frame);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,153 @@
+/********************************************************************************
+* timer.c: Innehåller funktionsdefinitioner för systemtimern, som genererar
+*          avbrott var millisekund via Timer 1 i CTC-mod.
+********************************************************************************/
+#include "timer.h"
+#include "trace.h"
+
+/* Statiska variabler: */
+static volatile timer_callback_t timer_callbacks[TIMER_MAX_CALLBACKS]; /* Registrerade rutiner. */
+static volatile uint8_t timer_num_callbacks = 0; /* Antalet registrerade rutiner. */
+static bool timer_initialized = false; /* Indikerar ifall timern är initierad. */
+static volatile uint32_t timer_millis = 0; /* Antalet förflutna millisekunder. */
+
+/********************************************************************************
+* timer_init: Initierar Timer 1 i CTC-mod så att avbrott genereras en gång per
+*             millisekund samt aktiverar avbrott globalt. Upprepade anrop har
+*             ingen effekt.
+********************************************************************************/
+void timer_init(void)
+{
+   if (timer_initialized) return;
+
+   TCCR1A = 0;
+   TCNT1 = 0;
+   OCR1A = TIMER_TICKS_PER_MS - 1;
+   TCCR1B = (1 << WGM12) | (1 << CS11);
+   set(TIMSK1, OCIE1A);
+   timer_initialized = true;
+   sei();
+   return;
+}
+
+/********************************************************************************
+* timer_add_callback: Registrerar callbackrutin som ska anropas vid varje
+*                     avbrott från systemtimern. Systemtimern initieras vid
+*                     behov. Ifall rutinen redan är registrerad eller lyckas
+*                     registreras returneras 0. Om maximalt antal rutiner
+*                     redan är registrerade returneras felkod 1.
+*
+*                     - callback: Callbackrutinen som ska registreras.
+********************************************************************************/
+int timer_add_callback(const timer_callback_t callback)
+{
+   uint8_t i, sreg;
+   int ret_val = 0;
+
+   atomic_begin(sreg);
+
+   for (i = 0; i < timer_num_callbacks; ++i)
+   {
+      if (timer_callbacks[i] == callback) break;
+   }
+
+   if (i == timer_num_callbacks)
+   {
+      if (timer_num_callbacks < TIMER_MAX_CALLBACKS)
+      {
+         timer_callbacks[timer_num_callbacks++] = callback;
+      }
+      else
+      {
+         ret_val = 1;
+      }
+   }
+
+   atomic_end(sreg);
+   timer_init();
+   return ret_val;
+}
+
+/********************************************************************************
+* timer_remove_callback: Avregistrerar angiven callbackrutin, som därmed inte
+*                        längre anropas av systemtimern. Sista registrerade
+*                        rutin flyttas till den lediga platsen.
+*
+*                        - callback: Callbackrutinen som ska avregistreras.
+********************************************************************************/
+void timer_remove_callback(const timer_callback_t callback)
+{
+   uint8_t i, sreg;
+   atomic_begin(sreg);
+
+   for (i = 0; i < timer_num_callbacks; ++i)
+   {
+      if (timer_callbacks[i] == callback)
+      {
+         timer_callbacks[i] = timer_callbacks[--timer_num_callbacks];
+         break;
+      }
+   }
+
+   atomic_end(sreg);
+   return;
+}
+
+/********************************************************************************
+* millis: Returnerar antalet millisekunder som har förflutit sedan systemtimern
+*         initierades. Avläsningen sker med avbrott inaktiverade, eftersom
+*         räknaren består av fyra byte som annars kan uppdateras under läsning.
+********************************************************************************/
+uint32_t millis(void)
+{
+   uint32_t ms;
+   uint8_t sreg;
+   atomic_begin(sreg);
+   ms = timer_millis;
+   atomic_end(sreg);
+   return ms;
+}
+
+/********************************************************************************
+* micros: Returnerar antalet mikrosekunder som har förflutit sedan
+*         systemtimern initierades. Ifall Timer 1 precis har nått sitt
+*         toppvärde men avbrottet ännu inte har hunnit genomföras räknas
+*         den väntande millisekunden med, vilket detekteras via flaggan OCF1A.
+********************************************************************************/
+uint32_t micros(void)
+{
+   uint32_t ms;
+   uint16_t ticks;
+   uint8_t sreg;
+
+   atomic_begin(sreg);
+   ms = timer_millis;
+   ticks = TCNT1;
+
+   if (read(TIFR1, OCF1A) && ticks < TIMER_TICKS_PER_MS / 2)
+   {
+      ms++;
+   }
+
+   atomic_end(sreg);
+   return ms * 1000UL + timer_ticks_to_us(ticks);
+}
+
+/********************************************************************************
+* ISR (TIMER1_COMPA_vect): Avbrottsrutin för systemtimern, som anropas en gång
+*                          per millisekund. Millisekundräknaren räknas upp,
+*                          varefter samtliga registrerade callbackrutiner anropas.
+********************************************************************************/
+ISR (TIMER1_COMPA_vect)
+{
+   uint8_t i;
+   trace_enter(TRACE_ISR_TIMER1);
+   timer_millis++;
+
+   for (i = 0; i < timer_num_callbacks; ++i)
+   {
+      timer_callbacks[i]();
+   }
+
+   trace_exit(TRACE_ISR_TIMER1);
+}
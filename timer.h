@@ -0,0 +1,93 @@
+/********************************************************************************
+* timer.h: Innehåller funktionalitet för en periodisk systemtimer, som genererar
+*          avbrott var millisekund via Timer 1 i CTC-mod. Systemtimern utgör
+*          programmets tidbas, som läses av via millis samt micros. Andra
+*          moduler kan registrera callbackrutiner som anropas vid varje
+*          avbrott, exempelvis för asynkron blinkning av lysdioder.
+********************************************************************************/
+#ifndef TIMER_H_
+#define TIMER_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#define TIMER_PRESCALER 8 /* Prescaler för Timer 1, ger 2 MHz vid 16 MHz klocka. */
+#define TIMER_TICKS_PER_MS (F_CPU / TIMER_PRESCALER / 1000) /* Timertick per ms. */
+#define TIMER_MAX_CALLBACKS 6 /* Maximalt antal registrerade callbackrutiner. */
+
+#if F_CPU % (TIMER_PRESCALER * 1000UL) != 0
+#error "Systemtimern kräver ett heltal timertick per millisekund (F_CPU)!"
+#endif
+
+/********************************************************************************
+* timer_ticks_to_us: Omvandlar angivet antal timertick till mikrosekunder.
+*                    När antalet timertick per millisekund är en multipel av
+*                    1000, exempelvis vid 8 eller 16 MHz, räcker en division.
+*                    Annars, exempelvis vid 12 eller 20 MHz, omvandlas hela
+*                    millisekunder samt resten var för sig, så att
+*                    omvandlingen blir exakt utan att mellanresultatet slår
+*                    runt för stora värden.
+*
+*                    - ticks: Antalet timertick.
+********************************************************************************/
+#if TIMER_TICKS_PER_MS % 1000 == 0
+#define timer_ticks_to_us(ticks) \
+   ((uint32_t)(ticks) / (TIMER_TICKS_PER_MS / 1000))
+#else
+#define timer_ticks_to_us(ticks) ({ \
+   const uint32_t to_us_ticks = (ticks); \
+   to_us_ticks / TIMER_TICKS_PER_MS * 1000UL + \
+      to_us_ticks % TIMER_TICKS_PER_MS * 1000UL / TIMER_TICKS_PER_MS; \
+})
+#endif
+
+/********************************************************************************
+* timer_callback_t: Typ för callbackrutiner som anropas av systemtimern en gång
+*                   per millisekund. Rutinerna anropas från avbrottsrutinen
+*                   och bör därmed vara korta.
+********************************************************************************/
+typedef void (*timer_callback_t)(void);
+
+/********************************************************************************
+* timer_init: Initierar Timer 1 i CTC-mod så att avbrott genereras en gång per
+*             millisekund samt aktiverar avbrott globalt. Upprepade anrop har
+*             ingen effekt.
+********************************************************************************/
+void timer_init(void);
+
+/********************************************************************************
+* timer_add_callback: Registrerar callbackrutin som ska anropas vid varje
+*                     avbrott från systemtimern. Systemtimern initieras vid
+*                     behov. Ifall rutinen redan är registrerad eller lyckas
+*                     registreras returneras 0. Om maximalt antal rutiner
+*                     redan är registrerade returneras felkod 1.
+*
+*                     - callback: Callbackrutinen som ska registreras.
+********************************************************************************/
+int timer_add_callback(const timer_callback_t callback);
+
+/********************************************************************************
+* timer_remove_callback: Avregistrerar angiven callbackrutin, som därmed inte
+*                        längre anropas av systemtimern.
+*
+*                        - callback: Callbackrutinen som ska avregistreras.
+********************************************************************************/
+void timer_remove_callback(const timer_callback_t callback);
+
+/********************************************************************************
+* millis: Returnerar antalet millisekunder som har förflutit sedan systemtimern
+*         initierades. Räknaren slår runt efter cirka 49 dygn. Avläsningen
+*         sker atomärt, så att räknaren inte kan uppdateras under avläsning.
+********************************************************************************/
+uint32_t millis(void);
+
+/********************************************************************************
+* micros: Returnerar antalet mikrosekunder som har förflutit sedan
+*         systemtimern initierades, beräknat utifrån millisekundräknaren
+*         samt Timer 1:s räknarvärde. Upplösningen är 1 us vid 16 MHz.
+*         Räknaren slår runt efter cirka 71 minuter. Avläsningen sker atomärt.
+********************************************************************************/
+uint32_t micros(void);
+
+#endif /* TIMER_H_ */
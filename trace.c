@@ -0,0 +1,87 @@
+/********************************************************************************
+* trace.c: Innehåller funktionsdefinitioner för spårpunkternas ringbuffert.
+********************************************************************************/
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+/* Globala variabler: */
+volatile trace_record_t trace_ring[TRACE_SIZE]; /* Ringbuffert, oanvända poster har id 0. */
+volatile uint8_t trace_head = 0; /* Index för nästa post som ska skrivas. */
+
+#endif /* TRACE_ENABLED */
+
+/********************************************************************************
+* trace_copy: Kopierar lagrade poster i kronologisk ordning till angiven
+*             array. Den äldsta posten ligger vid skrivindexet, ifall
+*             bufferten har fyllts, varför kopieringen startar där. Oanvända
+*             poster hoppas över.
+*
+*             - records    : Array där posterna ska lagras.
+*             - max_records: Maximalt antal poster som ska kopieras.
+********************************************************************************/
+uint8_t trace_copy(trace_record_t* records,
+                   const uint8_t max_records)
+{
+#if TRACE_ENABLED
+   uint8_t num_records = 0;
+   uint8_t num_skipped;
+   uint8_t sreg;
+   uint8_t i;
+
+   atomic_begin(sreg);
+
+   for (i = 0; i < TRACE_SIZE; ++i)
+   {
+      if (trace_ring[i].id != TRACE_NONE) num_records++;
+   }
+
+   num_skipped = num_records > max_records ? num_records - max_records : 0;
+   num_records = 0;
+
+   for (i = 0; i < TRACE_SIZE; ++i)
+   {
+      const volatile trace_record_t* record = &trace_ring[(trace_head + i) & (TRACE_SIZE - 1)];
+      if (record->id == TRACE_NONE) continue;
+
+      if (num_skipped)
+      {
+         num_skipped--;
+         continue;
+      }
+
+      records[num_records].id = record->id;
+      records[num_records].ticks = record->ticks;
+      num_records++;
+   }
+
+   atomic_end(sreg);
+   return num_records;
+#else
+   (void)records;
+   (void)max_records;
+   return 0;
+#endif /* TRACE_ENABLED */
+}
+
+/********************************************************************************
+* trace_clear: Tömmer ringbufferten genom att markera samtliga poster som
+*              oanvända.
+********************************************************************************/
+void trace_clear(void)
+{
+#if TRACE_ENABLED
+   uint8_t sreg;
+   uint8_t i;
+   atomic_begin(sreg);
+
+   for (i = 0; i < TRACE_SIZE; ++i)
+   {
+      trace_ring[i].id = TRACE_NONE;
+   }
+
+   trace_head = 0;
+   atomic_end(sreg);
+#endif /* TRACE_ENABLED */
+   return;
+}
@@ -0,0 +1,151 @@
+/********************************************************************************
+* trace.h: Innehåller funktionalitet för tidsmätning av kritiska funktioner
+*          samt avbrottsrutiner via spårpunkter. Varje spårpunkt lagrar en
+*          kompakt post på tre byte i en ringbuffert i RAM, bestående av
+*          spårpunktens id samt aktuellt värde på Timer 1 (TCNT1). Bufferten
+*          skrivs över kontinuerligt och innehåller därmed alltid de senaste
+*          posterna, som kan kopieras ut via trace_copy för senare analys.
+*
+*          Timer 1 räknar i CTC-mod från 0 till TIMER_TICKS_PER_MS - 1 med
+*          0,5 us upplösning vid 16 MHz (8 klockcykler per tick), se timer.h.
+*          Exekveringstiden mellan två spårpunkter beräknas via
+*          trace_elapsed_ticks, vilket förutsätter att tiden understiger en
+*          millisekund. Systemtimern måste ha initierats via timer_init.
+*
+*          Spårning aktiveras vid kompilering via TRACE_ENABLED. Vid
+*          inaktiverad spårning expanderar spårpunkterna till ingenting och
+*          ingen ringbuffert allokeras. Vid aktiverad spårning kostar varje
+*          spårpunkt uppskattningsvis 20 klockcykler, eftersom posten skrivs
+*          med avbrott inaktiverade så att spårpunkter i avbrottsrutiner
+*          inte kan avbryta en pågående skrivning.
+********************************************************************************/
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+#include "timer.h"
+
+/* Makrodefinitioner: */
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0 /* Aktiverar spårning, 0 = inaktiverad. */
+#endif
+
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 32 /* Ringbuffertens kapacitet, måste vara en tvåpotens. */
+#endif
+
+#if TRACE_SIZE < 2 || TRACE_SIZE > 128 || (TRACE_SIZE & (TRACE_SIZE - 1))
+#error "TRACE_SIZE måste vara en tvåpotens mellan 2 och 128!"
+#endif
+
+#define TRACE_EXIT 0x80 /* Flagga i id som indikerar utträde ur spårad funktion. */
+
+/********************************************************************************
+* trace_id: Enumeration för spårpunkternas id. Vid utträde ur en spårad
+*           funktion ettställs dessutom flaggan TRACE_EXIT.
+********************************************************************************/
+enum trace_id
+{
+   TRACE_NONE,                    /* Oanvänd post. */
+   TRACE_LED_ON,                  /* Tändning av lysdiod via vtable. */
+   TRACE_LED_OFF,                 /* Släckning av lysdiod via vtable. */
+   TRACE_LED_TOGGLE,              /* Toggling av lysdiod via vtable. */
+   TRACE_LED_BLINK,               /* Blinkning av lysdiod via vtable. */
+   TRACE_BUTTON_IS_PRESSED,       /* Avläsning av tryckknapp via vtable. */
+   TRACE_LED_ARRAY_ON,            /* led_array_on. */
+   TRACE_LED_ARRAY_OFF,           /* led_array_off. */
+   TRACE_LED_ARRAY_MASK_ON,       /* led_array_mask_on. */
+   TRACE_LED_ARRAY_MASK_OFF,      /* led_array_mask_off. */
+   TRACE_LED_ARRAY_MASK_TOGGLE,   /* led_array_mask_toggle. */
+   TRACE_LED_ARRAY_MASK_SET,      /* led_array_mask_set. */
+   TRACE_LED_ARRAY_BLINK,         /* Blockerande blinkning av led-array. */
+   TRACE_ISR_PCINT0,              /* Avbrottsrutin för PCI-avbrott på I/O-port B. */
+   TRACE_ISR_PCINT1,              /* Avbrottsrutin för PCI-avbrott på I/O-port C. */
+   TRACE_ISR_PCINT2,              /* Avbrottsrutin för PCI-avbrott på I/O-port D. */
+   TRACE_ISR_TIMER1,              /* Avbrottsrutin för systemtimern. */
+   TRACE_ISR_TIMER2,              /* Avbrottsrutin för mjukvaru-PWM. */
+   TRACE_MATRIX_SCAN,             /* Aktivering av nästa rad i lysdiodmatrisen. */
+   TRACE_ISR_TIMER1_CAPT,         /* Avbrottsrutin för infångning av flanker på ICP1. */
+   TRACE_USER                     /* Första lediga id för applikationsspecifika spårpunkter. */
+};
+
+/********************************************************************************
+* trace_record: Strukt för en post i ringbufferten.
+********************************************************************************/
+typedef struct trace_record
+{
+   uint8_t id;     /* Spårpunktens id, ettställd TRACE_EXIT vid utträde. */
+   uint16_t ticks; /* Värdet på Timer 1 (TCNT1) vid spårpunkten. */
+} trace_record_t;
+
+/********************************************************************************
+* trace_elapsed_ticks: Returnerar antalet timertick mellan två poster, med
+*                      hänsyn till att Timer 1 nollställs varje millisekund.
+*                      Ett timertick motsvarar 8 klockcykler vid prescaler 8.
+*
+*                      - start: Pekare till posten vid inträde.
+*                      - stop : Pekare till posten vid utträde.
+********************************************************************************/
+#define trace_elapsed_ticks(start, stop) \
+   ((uint16_t)((stop)->ticks >= (start)->ticks ? (stop)->ticks - (start)->ticks : \
+    (stop)->ticks + TIMER_TICKS_PER_MS - (start)->ticks))
+
+#if TRACE_ENABLED
+
+/* Ringbuffert samt skrivindex, används av makrona nedan: */
+extern volatile trace_record_t trace_ring[TRACE_SIZE];
+extern volatile uint8_t trace_head;
+
+/********************************************************************************
+* trace_point: Lagrar en post med angivet id samt aktuellt värde på Timer 1
+*              i ringbufferten. Avbrott inaktiveras under skrivningen.
+*
+*              - point_id: Spårpunktens id.
+********************************************************************************/
+#define trace_point(point_id) ({ \
+   uint8_t trace_sreg; \
+   volatile trace_record_t* trace_record; \
+   atomic_begin(trace_sreg); \
+   trace_record = &trace_ring[trace_head]; \
+   trace_record->id = (point_id); \
+   trace_record->ticks = TCNT1; \
+   trace_head = (trace_head + 1) & (TRACE_SIZE - 1); \
+   atomic_end(trace_sreg); \
+})
+
+#else
+
+#define trace_point(point_id) ((void)0)
+
+#endif /* TRACE_ENABLED */
+
+/********************************************************************************
+* trace_enter, trace_exit: Spårpunkter vid inträde i respektive utträde ur
+*                          en spårad funktion.
+*
+*                          - point_id: Funktionens id, se enumerationen
+*                                      trace_id.
+********************************************************************************/
+#define trace_enter(point_id) trace_point(point_id)
+#define trace_exit(point_id) trace_point((point_id) | TRACE_EXIT)
+
+/********************************************************************************
+* trace_copy: Kopierar lagrade poster i kronologisk ordning, äldst först, till
+*             angiven array och returnerar antalet kopierade poster. Ifall
+*             fler poster finns än vad som ryms kopieras de senaste. Avbrott
+*             inaktiveras under kopieringen. Vid inaktiverad spårning
+*             returneras 0.
+*
+*             - records    : Array där posterna ska lagras.
+*             - max_records: Maximalt antal poster som ska kopieras.
+********************************************************************************/
+uint8_t trace_copy(trace_record_t* records,
+                   const uint8_t max_records);
+
+/********************************************************************************
+* trace_clear: Tömmer ringbufferten.
+********************************************************************************/
+void trace_clear(void);
+
+#endif /* TRACE_H_ */
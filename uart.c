@@ -0,0 +1,121 @@
+/********************************************************************************
+* uart.c: Innehåller funktionsdefinitioner för avbrottsstyrd sändning via
+*         USART0.
+********************************************************************************/
+#include "uart.h"
+
+/* Makrodefinitioner: */
+#define UART_TX_MASK (UART_TX_SIZE - 1) /* Mask för index i sändbufferten. */
+
+/* Statiska variabler: */
+static volatile uint8_t uart_tx_buffer[UART_TX_SIZE]; /* Sändbuffert. */
+static volatile uint8_t uart_tx_head = 0; /* Skrivindex, uppdateras endast av huvudloopen. */
+static volatile uint8_t uart_tx_tail = 0; /* Läsindex, uppdateras endast av avbrottsrutinen. */
+static volatile uint16_t uart_tx_num_dropped = 0; /* Antalet förkastade byte. */
+static bool uart_tx_started = false; /* Indikerar ifall någon byte har skickats. */
+
+/********************************************************************************
+* uart_init: Initierar USART0 för sändning med angiven överföringshastighet.
+*            Värdet på UBRR0 avrundas till närmaste heltal.
+*
+*            - baud: Överföringshastighet mätt i bitar per sekund.
+********************************************************************************/
+void uart_init(const uint32_t baud)
+{
+   UBRR0 = (uint16_t)((F_CPU / 8 + baud / 2) / baud - 1);
+   UCSR0A = (1 << U2X0);
+   UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+   UCSR0B = (1 << TXEN0);
+   sei();
+   return;
+}
+
+/********************************************************************************
+* uart_write: Kopierar angivet antal byte till sändbufferten och aktiverar
+*             avbrott för tomt dataregister. Indexen räknas upp
+*             kontinuerligt och maskas vid åtkomst av bufferten, se
+*             event_queue.c. Skrivindexet uppdateras först efter
+*             kopieringen, så att avbrottsrutinen aldrig läser ofullständig
+*             data. Ifall avbrottsrutinen inaktiverar avbrottet mitt i
+*             aktiveringen medför detta enbart ett extra avbrott. Flaggan
+*             TXC0 nollställs genom att en etta skrivs till den, så att
+*             uart_tx_idle inte rapporterar en tidigare avslutad sändning.
+*
+*             - data: Pekare till data som ska skickas.
+*             - size: Antalet byte som ska skickas.
+********************************************************************************/
+bool uart_write(const void* data,
+                const uint8_t size)
+{
+   const uint8_t* bytes = (const uint8_t*)data;
+   uint8_t head = uart_tx_head;
+   uint8_t i;
+
+   if (size > UART_TX_SIZE - (uint8_t)(head - uart_tx_tail))
+   {
+      uart_tx_num_dropped += size;
+      return false;
+   }
+
+   for (i = 0; i < size; ++i)
+   {
+      uart_tx_buffer[head++ & UART_TX_MASK] = bytes[i];
+   }
+
+   uart_tx_head = head;
+   uart_tx_started = true;
+   set(UCSR0A, TXC0);
+   set(UCSR0B, UDRIE0);
+   return true;
+}
+
+/********************************************************************************
+* uart_tx_pending: Returnerar antalet byte i sändbufferten som ännu inte har
+*                  lämnats över till hårdvaran.
+********************************************************************************/
+uint8_t uart_tx_pending(void)
+{
+   return (uint8_t)(uart_tx_head - uart_tx_tail);
+}
+
+/********************************************************************************
+* uart_tx_idle: Returnerar true ifall sändbufferten är tom och hårdvaran har
+*               skickat sista byten, vilket indikeras av flaggan TXC0.
+********************************************************************************/
+bool uart_tx_idle(void)
+{
+   if (!uart_tx_started) return true;
+   return uart_tx_head == uart_tx_tail && read(UCSR0A, TXC0);
+}
+
+/********************************************************************************
+* uart_tx_dropped: Returnerar antalet förkastade byte sedan start.
+********************************************************************************/
+uint16_t uart_tx_dropped(void)
+{
+   return uart_tx_num_dropped;
+}
+
+/********************************************************************************
+* ISR (USART_UDRE_vect): Avbrottsrutin som anropas när dataregistret UDR0 är
+*                        tomt. Nästa byte i sändbufferten skrivs till UDR0.
+*                        När bufferten har tömts inaktiveras avbrottet.
+********************************************************************************/
+ISR (USART_UDRE_vect)
+{
+   const uint8_t tail = uart_tx_tail;
+
+   if (tail == uart_tx_head)
+   {
+      clr(UCSR0B, UDRIE0);
+      return;
+   }
+
+   UDR0 = uart_tx_buffer[tail & UART_TX_MASK];
+   uart_tx_tail = tail + 1;
+
+   if (uart_tx_tail == uart_tx_head)
+   {
+      clr(UCSR0B, UDRIE0);
+   }
+}
@@ -0,0 +1,70 @@
+/********************************************************************************
+* uart.h: Innehåller funktionalitet för seriell överföring via USART0 med en
+*         avbrottsstyrd sändbuffert. Data som ska skickas kopieras till en
+*         ringbuffert, varefter avbrottsrutinen för tom dataregister (UDRE)
+*         skickar en byte i taget. Sändning blockerar därmed aldrig
+*         huvudloopen. Ifall bufferten saknar plats för samtliga byte
+*         förkastas hela skrivningen, så att paket aldrig skickas ofullständigt.
+*
+*         Bufferten har en producent (huvudloopen) samt en konsument
+*         (avbrottsrutinen), se event_queue.h. Skrivning från avbrottsrutiner
+*         är därmed inte tillåten.
+********************************************************************************/
+#ifndef UART_H_
+#define UART_H_
+
+/* Inkluderingsdirektiv: */
+#include "misc.h"
+
+/* Makrodefinitioner: */
+#ifndef UART_TX_SIZE
+#define UART_TX_SIZE 64 /* Sändbuffertens kapacitet, måste vara en tvåpotens. */
+#endif
+
+#if UART_TX_SIZE < 2 || UART_TX_SIZE > 128 || (UART_TX_SIZE & (UART_TX_SIZE - 1))
+#error "UART_TX_SIZE måste vara en tvåpotens mellan 2 och 128!"
+#endif
+
+/********************************************************************************
+* uart_init: Initierar USART0 för sändning med angiven överföringshastighet,
+*            8 databitar, ingen paritetsbit och en stoppbit (8N1). Dubbel
+*            hastighet (U2X0) används för lägre avvikelse, exempelvis 0,2 %
+*            vid 38 400 baud och 16 MHz. Avbrott aktiveras globalt.
+*
+*            - baud: Överföringshastighet mätt i bitar per sekund.
+********************************************************************************/
+void uart_init(const uint32_t baud);
+
+/********************************************************************************
+* uart_write: Kopierar angivet antal byte till sändbufferten och startar
+*             sändning. Anropet blockerar inte. Ifall bufferten saknar
+*             plats för samtliga byte förkastas skrivningen, antalet
+*             förkastade byte räknas upp och false returneras. Annars
+*             returneras true.
+*
+*             - data: Pekare till data som ska skickas.
+*             - size: Antalet byte som ska skickas.
+********************************************************************************/
+bool uart_write(const void* data,
+                const uint8_t size);
+
+/********************************************************************************
+* uart_tx_pending: Returnerar antalet byte i sändbufferten som ännu inte har
+*                  lämnats över till hårdvaran.
+********************************************************************************/
+uint8_t uart_tx_pending(void);
+
+/********************************************************************************
+* uart_tx_idle: Returnerar true ifall samtliga byte har skickats färdigt,
+*               inklusive sista byten i hårdvarans skiftregister. USART0
+*               stannar i viloläget Power-down, vilket avbryter en pågående
+*               sändning, se power.h.
+********************************************************************************/
+bool uart_tx_idle(void);
+
+/********************************************************************************
+* uart_tx_dropped: Returnerar antalet förkastade byte sedan start.
+********************************************************************************/
+uint16_t uart_tx_dropped(void);
+
+#endif /* UART_H_ */